@@ -0,0 +1,235 @@
+// Microbenchmarks for the hot kernels, one binary per matrix build variant
+// (brownian_bench_slow / _fast / _ultra / _gemm). Rates are reported as
+// items/s and bytes/s; the matrix multiply also reports FLOP/s.
+
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "matrix_operations.h"
+#include "frame_arena.h"
+#include "obstacle_system.h"
+#include "particle_interactions.h"
+#include "particle_kernels.h"
+#include "particle_store.h"
+#include "thread_pool.h"
+
+namespace {
+
+constexpr int WORLD_WIDTH = 1200;
+constexpr int WORLD_HEIGHT = 800;
+constexpr uint64_t SEED = 42;
+constexpr float STEP_SCALE = 0.64f; // position_scale of a 16 ms frame
+
+// --- MATRICES ---
+
+void BM_MultiplyMatrices(benchmark::State& state) {
+    const int n = static_cast<int>(state.range(0));
+    std::mt19937 rng(SEED);
+    Matrix a, b, result;
+    MatrixOperations::createRandomMatrix(a, n, n, rng);
+    MatrixOperations::createRandomMatrix(b, n, n, rng);
+    result.resize(n, n);
+
+    for (auto _ : state) {
+        MatrixOperations::multiplyMatrices(a, b, result);
+        benchmark::DoNotOptimize(result.data());
+        benchmark::ClobberMemory();
+    }
+
+    const double flops = 2.0 * n * n * n;
+    state.SetItemsProcessed(state.iterations() * n * n); // Result elements
+    state.SetBytesProcessed(state.iterations() * 3 * n * n * static_cast<int64_t>(sizeof(float)));
+    state.counters["FLOP/s"] = benchmark::Counter(flops, benchmark::Counter::kIsIterationInvariantRate);
+}
+BENCHMARK(BM_MultiplyMatrices)->RangeMultiplier(2)->Range(32, 1024)->Arg(280)->Unit(benchmark::kMicrosecond);
+
+void BM_MultiplyMatricesThreaded(benchmark::State& state) {
+    const int n = static_cast<int>(state.range(0));
+    ThreadPool pool(static_cast<int>(state.range(1)));
+    std::mt19937 rng(SEED);
+    Matrix a, b, result;
+    MatrixOperations::createRandomMatrix(a, n, n, rng);
+    MatrixOperations::createRandomMatrix(b, n, n, rng);
+    result.resize(n, n);
+
+    for (auto _ : state) {
+        MatrixOperations::multiplyMatrices(a, b, result, &pool);
+        benchmark::DoNotOptimize(result.data());
+        benchmark::ClobberMemory();
+    }
+
+    const double flops = 2.0 * n * n * n;
+    state.SetItemsProcessed(state.iterations() * n * n);
+    state.SetBytesProcessed(state.iterations() * 3 * n * n * static_cast<int64_t>(sizeof(float)));
+    state.counters["FLOP/s"] = benchmark::Counter(flops, benchmark::Counter::kIsIterationInvariantRate);
+}
+BENCHMARK(BM_MultiplyMatricesThreaded)
+    ->ArgsProduct({{280, 1024}, {2, 4, 0}}) // 0 = all cores
+    ->ArgNames({"n", "threads"})
+    ->UseRealTime()
+    ->Unit(benchmark::kMicrosecond);
+
+void BM_TransposeMatrix(benchmark::State& state) {
+    const int n = static_cast<int>(state.range(0));
+    std::mt19937 rng(SEED);
+    Matrix input, output;
+    MatrixOperations::createRandomMatrix(input, n, n, rng);
+    output.resize(n, n);
+
+    for (auto _ : state) {
+        MatrixOperations::transposeMatrix(input, output);
+        benchmark::DoNotOptimize(output.data());
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(state.iterations() * n * n);
+    state.SetBytesProcessed(state.iterations() * 2 * n * n * static_cast<int64_t>(sizeof(float)));
+}
+BENCHMARK(BM_TransposeMatrix)->RangeMultiplier(2)->Range(64, 4096)->Arg(280)->Unit(benchmark::kMicrosecond);
+
+// --- OBSTACLE COLLISIONS ---
+
+void BM_HandleParticleCollision(benchmark::State& state) {
+    const int obstacle_count = static_cast<int>(state.range(0));
+    ObstacleSystem obstacles(WORLD_WIDTH, WORLD_HEIGHT, obstacle_count, SEED);
+
+    // Same particle field for every obstacle count: uniform over the world
+    constexpr int PARTICLES = 4096;
+    std::mt19937 rng(SEED);
+    std::uniform_real_distribution<float> x_dist(0.0f, WORLD_WIDTH);
+    std::uniform_real_distribution<float> y_dist(0.0f, WORLD_HEIGHT);
+    std::uniform_real_distribution<float> v_dist(-50.0f, 50.0f);
+    std::vector<Vec2f> positions(PARTICLES);
+    std::vector<Vec2f> velocities(PARTICLES);
+    for (int i = 0; i < PARTICLES; ++i) {
+        positions[i] = Vec2f(x_dist(rng), y_dist(rng));
+        velocities[i] = Vec2f(v_dist(rng), v_dist(rng));
+    }
+
+    for (auto _ : state) {
+        int hits = 0;
+        for (int i = 0; i < PARTICLES; ++i) {
+            Vec2f position = positions[i];
+            Vec2f velocity = velocities[i];
+            hits += obstacles.handleParticleCollision(position - velocity * STEP_SCALE, position, velocity, 3.0f);
+            benchmark::DoNotOptimize(position);
+            benchmark::DoNotOptimize(velocity);
+        }
+        benchmark::DoNotOptimize(hits);
+    }
+
+    state.SetItemsProcessed(state.iterations() * PARTICLES);
+    state.SetBytesProcessed(state.iterations() * PARTICLES * 2 * static_cast<int64_t>(sizeof(Vec2f)));
+}
+BENCHMARK(BM_HandleParticleCollision)->RangeMultiplier(4)->Range(1, 256)->Unit(benchmark::kMicrosecond);
+
+// --- PARTICLE LOOPS ---
+
+void fillParticles(ParticleStore& particles, std::size_t count) {
+    std::mt19937 rng(SEED);
+    std::uniform_real_distribution<float> x_dist(10.0f, WORLD_WIDTH - 10.0f);
+    std::uniform_real_distribution<float> y_dist(10.0f, WORLD_HEIGHT - 10.0f);
+    particles.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        particles.add(x_dist(rng), y_dist(rng), 0.0f, 0.0f, 3.0f, Color(100, 100, 200, 220));
+    }
+}
+
+void BM_IntegrateParticles(benchmark::State& state) {
+    const std::size_t count = static_cast<std::size_t>(state.range(0));
+    ParticleStore particles;
+    fillParticles(particles, count);
+
+    CounterRng rng(SEED);
+    AlignedVector<float> noise_x(count), noise_y(count), color_roll(count);
+    ParticleKernels::generateMotionNoise(rng, 0, -50.0f, 50.0f, particles.id.data(), noise_x.data(),
+                                         noise_y.data(), color_roll.data(), 0, count);
+
+    IntegrationStep step;
+    step.noise_scale = 0.032f;
+    step.damping = 0.992f;
+    step.position_scale = STEP_SCALE;
+
+    for (auto _ : state) {
+        ParticleKernels::integrate(particles, noise_x.data(), noise_y.data(), step, 0, count);
+        ParticleKernels::bounceWalls(particles, WORLD_WIDTH, WORLD_HEIGHT, -0.4f, 0, count);
+        benchmark::ClobberMemory();
+    }
+
+    // Reads noise x/y and radius, reads and writes position and velocity
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(count));
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(count) * 11 * static_cast<int64_t>(sizeof(float)));
+}
+BENCHMARK(BM_IntegrateParticles)->RangeMultiplier(10)->Range(1000, 10000000)->Unit(benchmark::kMicrosecond);
+
+void BM_GenerateMotionNoise(benchmark::State& state) {
+    const std::size_t count = static_cast<std::size_t>(state.range(0));
+    CounterRng rng(SEED);
+    AlignedVector<float> noise_x(count), noise_y(count), color_roll(count);
+    AlignedVector<uint32_t> ids(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        ids[i] = static_cast<uint32_t>(i);
+    }
+    uint64_t frame = 0;
+
+    for (auto _ : state) {
+        ParticleKernels::generateMotionNoise(rng, frame++, -50.0f, 50.0f, ids.data(), noise_x.data(),
+                                             noise_y.data(), color_roll.data(), 0, count);
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(count));
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(count) * 3 * static_cast<int64_t>(sizeof(float)));
+}
+BENCHMARK(BM_GenerateMotionNoise)->RangeMultiplier(10)->Range(1000, 10000000)->Unit(benchmark::kMicrosecond);
+
+void BM_ParticleInteractions(benchmark::State& state) {
+    // Constant density (the demo's 10000 particles in 1200x800), so time per
+    // particle should stay flat as the count grows
+    const std::size_t count = static_cast<std::size_t>(state.range(0));
+    const float side = std::sqrt(static_cast<float>(count) * WORLD_WIDTH * WORLD_HEIGHT / 10000.0f);
+    std::mt19937 rng(SEED);
+    std::uniform_real_distribution<float> position_dist(0.0f, side);
+    std::uniform_real_distribution<float> radius_dist(1.5f, 3.0f);
+    ParticleStore particles;
+    particles.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        particles.add(position_dist(rng), position_dist(rng), 0.0f, 0.0f, radius_dist(rng),
+                      Color(100, 100, 200, 220));
+    }
+
+    ParticleInteractions interactions;
+    interactions.configure(side, side, 3.0f);
+    FrameArena arena;
+    ThreadPool pool(static_cast<int>(state.range(1)));
+
+    for (auto _ : state) {
+        arena.reset();
+        arena.reserve(interactions.getFrameScratchBytes(count));
+        interactions.apply(particles, 0.016f, arena, pool.getThreadCount() > 1 ? &pool : nullptr);
+        benchmark::ClobberMemory();
+    }
+
+    state.counters["contacts"] = static_cast<double>(interactions.getContactCount());
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(count));
+}
+BENCHMARK(BM_ParticleInteractions)
+    ->ArgsProduct({benchmark::CreateRange(1000, 1000000, 10), {1, 4}})
+    ->ArgNames({"particles", "threads"})
+    ->Unit(benchmark::kMicrosecond);
+
+} // namespace
+
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::AddCustomContext("matrix_implementation", MatrixOperations::getImplementationName());
+    benchmark::AddCustomContext("particle_kernels", ParticleKernels::getInstructionSetName());
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,88 @@
+#include "allocation_counter.h"
+
+#if defined(BROWNIAN_COUNT_ALLOCATIONS)
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<uint64_t> allocation_count{0};
+thread_local std::atomic<uint64_t> thread_allocation_count{0};
+
+void* countedAllocate(std::size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    thread_allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* pointer = std::malloc(size ? size : 1)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void* countedAllocateAligned(std::size_t size, std::align_val_t alignment) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    thread_allocation_count.fetch_add(1, std::memory_order_relaxed);
+    const std::size_t align = static_cast<std::size_t>(alignment);
+    // aligned_alloc wants the size to be a multiple of the alignment
+    const std::size_t rounded = (size + align - 1) / align * align;
+    if (void* pointer = std::aligned_alloc(align, rounded ? rounded : align)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+} // namespace
+
+uint64_t AllocationCounter::getCount() {
+    return allocation_count.load(std::memory_order_relaxed);
+}
+
+uint64_t AllocationCounter::getThreadCount() {
+    return thread_allocation_count.load(std::memory_order_relaxed);
+}
+
+const std::atomic<uint64_t>* AllocationCounter::getThreadCounter() {
+    return &thread_allocation_count;
+}
+
+// Replacements for the global allocation functions. Both plain and aligned
+// blocks come from the C allocator, so every delete form frees with free().
+void* operator new(std::size_t size) { return countedAllocate(size); }
+void* operator new[](std::size_t size) { return countedAllocate(size); }
+void* operator new(std::size_t size, std::align_val_t alignment) { return countedAllocateAligned(size, alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return countedAllocateAligned(size, alignment); }
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    try { return countedAllocate(size); } catch (...) { return nullptr; }
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    try { return countedAllocate(size); } catch (...) { return nullptr; }
+}
+
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+void operator delete[](void* pointer) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, std::size_t) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::align_val_t) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, std::align_val_t) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept { std::free(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept { std::free(pointer); }
+
+#else
+
+uint64_t AllocationCounter::getCount() {
+    return 0;
+}
+
+uint64_t AllocationCounter::getThreadCount() {
+    return 0;
+}
+
+const std::atomic<uint64_t>* AllocationCounter::getThreadCounter() {
+    return nullptr;
+}
+
+#endif
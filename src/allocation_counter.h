@@ -0,0 +1,31 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Counts global operator new calls, for checking that hot loops don't allocate.
+// Debug builds (no NDEBUG) replace the global allocation functions to count;
+// define BROWNIAN_COUNT_ALLOCATIONS to force it, or BROWNIAN_NO_ALLOCATION_COUNTER
+// to turn it off.
+#if !defined(BROWNIAN_COUNT_ALLOCATIONS) && !defined(NDEBUG) && !defined(BROWNIAN_NO_ALLOCATION_COUNTER)
+    #define BROWNIAN_COUNT_ALLOCATIONS
+#endif
+
+class AllocationCounter {
+public:
+    // Allocations so far, on all threads; always 0 when counting is compiled out
+    static uint64_t getCount();
+    // Allocations so far on the calling thread only, for checks that must not
+    // see other threads' work (independent simulations side by side)
+    static uint64_t getThreadCount();
+    // The calling thread's counter, which another thread may read (a pool
+    // summing its workers); nullptr when counting is compiled out
+    static const std::atomic<uint64_t>* getThreadCounter();
+    static constexpr bool isEnabled() {
+#if defined(BROWNIAN_COUNT_ALLOCATIONS)
+        return true;
+#else
+        return false;
+#endif
+    }
+};
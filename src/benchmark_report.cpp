@@ -0,0 +1,187 @@
+#include "benchmark_report.h"
+#include "matrix_operations.h"
+#include "particle_kernels.h"
+#include "obstacle_kernels.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <numeric>
+#include <ostream>
+
+BenchmarkReport::BenchmarkReport(int expected_frames) {
+    const std::size_t capacity = static_cast<std::size_t>(std::max(expected_frames, 0));
+    total_ms.reserve(capacity);
+    matrix_ms.reserve(capacity);
+    obstacles_ms.reserve(capacity);
+    particles_ms.reserve(capacity);
+}
+
+void BenchmarkReport::addFrame(const FrameTimings& timings, double frame_ms) {
+    total_ms.push_back(frame_ms);
+    matrix_ms.push_back(timings.matrix_ms);
+    obstacles_ms.push_back(timings.obstacles_ms);
+    particles_ms.push_back(timings.particles_ms);
+}
+
+void BenchmarkReport::addCounters(const PhaseCounters& counters) {
+    counter_totals += counters;
+    ++counter_frames;
+}
+
+double BenchmarkReport::percentile(const std::vector<double>& sorted, double fraction) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    // Nearest rank
+    std::size_t rank = static_cast<std::size_t>(std::ceil(fraction * sorted.size()));
+    rank = std::min(std::max<std::size_t>(rank, 1), sorted.size());
+    return sorted[rank - 1];
+}
+
+void BenchmarkReport::writePhase(std::ostream& out, const char* name, std::vector<double> samples, bool last) {
+    std::sort(samples.begin(), samples.end());
+    const double mean = samples.empty() ? 0.0 :
+        std::accumulate(samples.begin(), samples.end(), 0.0) / samples.size();
+    
+    out << "    \"" << name << "\": {"
+        << "\"mean\": " << mean
+        << ", \"p50\": " << percentile(samples, 0.50)
+        << ", \"p99\": " << percentile(samples, 0.99)
+        << ", \"max\": " << (samples.empty() ? 0.0 : samples.back())
+        << "}" << (last ? "\n" : ",\n");
+}
+
+void BenchmarkReport::writeCounters(std::ostream& out, const PerfCounters& counters) const {
+    if (!counters.isOpen()) {
+        out << "{\"available\": false, \"error\": \"" << counters.getError() << "\"}";
+        return;
+    }
+    
+    // Means per frame; events the machine does not expose are null
+    const double frames = std::max(counter_frames, 1);
+    auto writePhase = [&](const char* name, const PerfCounterValues& values, bool last) {
+        out << "    \"" << name << "\": {";
+        for (int event = 0; event < PERF_EVENT_COUNT; ++event) {
+            out << "\"" << PerfCounters::getEventName(event) << "\": ";
+            if (counters.hasEvent(event)) {
+                out << std::setprecision(0) << values.counts[event] / frames;
+            } else {
+                out << "null";
+            }
+            out << ", ";
+        }
+        out << "\"ipc\": ";
+        if (counters.hasEvent(PERF_CYCLES) && counters.hasEvent(PERF_INSTRUCTIONS)) {
+            out << std::setprecision(3) << values.ipc();
+        } else {
+            out << "null";
+        }
+        out << "}" << (last ? "\n" : ",\n");
+    };
+    
+    out << "{\n"
+        << "    \"scope\": \"update thread, user space\",\n";
+    writePhase("matrix", counter_totals.matrix, false);
+    writePhase("obstacles", counter_totals.obstacles, false);
+    writePhase("particles", counter_totals.particles, true);
+    out << "  }";
+}
+
+void BenchmarkReport::writeJson(std::ostream& out, const BenchmarkConfig& config, const ParticleStore& particles,
+                                const PerfCounters& counters, double wall_seconds) const {
+    const double frames = static_cast<double>(total_ms.size());
+    const double update_seconds = std::accumulate(total_ms.begin(), total_ms.end(), 0.0) / 1000.0;
+    const double matrix_seconds = std::accumulate(matrix_ms.begin(), matrix_ms.end(), 0.0) / 1000.0;
+    
+    // Nominal 2 * n^3 per frame, also in lazy mode, where it measures what the
+    // cache saves rather than arithmetic done
+    const double n = static_cast<double>(config.matrix_size);
+    const double matrix_flops = 2.0 * n * n * n * frames;
+    const double gflops = matrix_seconds > 0.0 ? matrix_flops / matrix_seconds / 1e9 : 0.0;
+    const double particle_updates = update_seconds > 0.0 ?
+        static_cast<double>(config.particles) * frames / update_seconds : 0.0;
+    
+    const std::ios_base::fmtflags flags = out.flags();
+    const std::streamsize precision = out.precision();
+    out << std::fixed << std::setprecision(4);
+    
+    out << "{\n"
+        << "  \"matrix_implementation\": \"" << MatrixOperations::getImplementationName() << "\",\n"
+        << "  \"particle_kernels\": \"" << ParticleKernels::getInstructionSetName() << "\",\n"
+        << "  \"obstacle_kernels\": \"" << ObstacleKernels::getInstructionSetName() << "\",\n"
+        << "  \"frames\": " << total_ms.size() << ",\n"
+        << "  \"dt\": " << config.delta_time << ",\n"
+        << "  \"seed\": " << config.seed << ",\n"
+        << "  \"threads\": " << config.threads << ",\n"
+        << "  \"particles\": " << config.particles << ",\n"
+        << "  \"obstacles\": " << config.obstacles << ",\n"
+        << "  \"matrix_size\": " << config.matrix_size << ",\n"
+        << "  \"lazy_matrix\": " << (config.lazy_matrix ? "true" : "false") << ",\n"
+        << "  \"interactions\": " << (config.interactions ? "true" : "false") << ",\n"
+        << "  \"boundary\": \"" << MotionPolicy::boundaryName(config.boundary) << "\",\n"
+        << "  \"noise\": \"" << MotionPolicy::noiseName(config.noise) << "\",\n"
+        << "  \"color_jitter\": " << (config.color_jitter ? "true" : "false") << ",\n"
+        << "  \"sort_every\": " << config.sort_interval << ",\n"
+        << "  \"domains\": \"" << config.domain_columns << "x" << config.domain_rows << "\",\n"
+        << "  \"ranks\": " << config.ranks << ",\n"
+        << "  \"migrations_per_frame\": " << config.migrations_per_frame << ",\n"
+        << "  \"compute\": \"" << config.compute << "\",\n";
+    if (config.compute_check_interval > 0) {
+        out << "  \"compute_check\": {\"interval\": " << config.compute_check_interval
+            << ", \"checks\": " << config.compute_checks
+            << ", \"max_position_error\": " << std::setprecision(6) << config.compute_max_position_error
+            << ", \"max_velocity_error\": " << config.compute_max_velocity_error << std::setprecision(4) << "},\n";
+    }
+    out << "  \"frame_time_ms\": {\n";
+    writePhase(out, "total", total_ms, false);
+    writePhase(out, "matrix", matrix_ms, false);
+    writePhase(out, "obstacles", obstacles_ms, false);
+    writePhase(out, "particles", particles_ms, true);
+    out << "  },\n"
+        << "  \"wall_time_s\": " << wall_seconds << ",\n"
+        << "  \"particle_updates_per_s\": " << std::setprecision(0) << particle_updates << ",\n"
+        << "  \"matrix_gflops\": " << std::setprecision(3) << gflops << ",\n";
+    if (config.perf_counters) {
+        out << "  \"perf_counters\": ";
+        writeCounters(out, counters);
+        out << ",\n";
+    }
+    out << "  \"state_hash\": \"" << std::hex << std::setw(16) << std::setfill('0')
+        << hashParticles(particles) << std::dec << std::setfill(' ') << "\"\n"
+        << "}\n";
+    
+    out.flags(flags);
+    out.precision(precision);
+}
+
+uint64_t BenchmarkReport::hashParticles(const ParticleStore& particles) {
+    // Reordered runs (--sort-every) are hashed through a permutation by id;
+    // in creation order it is the identity and is skipped
+    std::vector<uint32_t> by_id;
+    if (!std::is_sorted(particles.id.begin(), particles.id.end())) {
+        by_id.resize(particles.size());
+        std::iota(by_id.begin(), by_id.end(), 0u);
+        std::sort(by_id.begin(), by_id.end(), [&particles](uint32_t a, uint32_t b) {
+            return particles.id[a] < particles.id[b];
+        });
+    }
+    
+    uint64_t hash = 0xcbf29ce484222325ull;
+    auto mixArray = [&hash, &by_id](const AlignedVector<float>& values) {
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            const float value = by_id.empty() ? values[i] : values[by_id[i]];
+            uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            for (int byte = 0; byte < 4; ++byte) {
+                hash ^= (bits >> (byte * 8)) & 0xFFu;
+                hash *= 0x100000001b3ull;
+            }
+        }
+    };
+    mixArray(particles.pos_x);
+    mixArray(particles.pos_y);
+    mixArray(particles.vel_x);
+    mixArray(particles.vel_y);
+    return hash;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+#include "simulation.h"
+
+// Fixed workload a benchmark run was made with, echoed into the report
+struct BenchmarkConfig {
+    int frames = 0;
+    float delta_time = 0.0f;
+    int particles = 0;
+    int obstacles = 0;
+    int matrix_size = 0;
+    bool lazy_matrix = false;
+    bool perf_counters = false;
+    bool interactions = false;
+    BoundaryMode boundary = BoundaryMode::Reflect;
+    NoiseMode noise = NoiseMode::Uniform;
+    bool color_jitter = true;
+    int sort_interval = 0; // --sort-every: frames between Morton reorders (0 = off)
+    int domain_columns = 1; // --domains tiles, ranks and mean migrations per frame
+    int domain_rows = 1;
+    int ranks = 1;
+    double migrations_per_frame = 0.0;
+    std::string compute = "cpu"; // Particle pass: "cpu" or the OpenCL device's name
+    int compute_check_interval = 0; // --compute-check: frames between comparisons, and the worst deviations seen
+    int compute_checks = 0;
+    double compute_max_position_error = 0.0;
+    double compute_max_velocity_error = 0.0;
+    int threads = 1;
+    uint64_t seed = 0;
+};
+
+// Collects per-frame phase timings of a headless run and writes them out as
+// one JSON object: mean / p50 / p99 / max per phase, particle throughput and
+// the effective GFLOP/s of the matrix step, plus mean hardware counter deltas
+// per phase when they were recorded
+class BenchmarkReport {
+public:
+    explicit BenchmarkReport(int expected_frames);
+    
+    void addFrame(const FrameTimings& timings, double frame_ms);
+    // Hardware counter deltas of the same frame (--perf-counters runs)
+    void addCounters(const PhaseCounters& counters);
+    
+    // wall_seconds covers the whole measured loop, including the timing itself
+    // particles and counters are the final state (state_hash) and the update
+    // thread's counters (--perf-counters runs)
+    void writeJson(std::ostream& out, const BenchmarkConfig& config, const ParticleStore& particles,
+                   const PerfCounters& counters, double wall_seconds) const;
+    
+    // FNV-1a over positions and velocities in id order: equal hashes mean
+    // equal trajectories, however the particles are arranged in memory
+    static uint64_t hashParticles(const ParticleStore& particles);
+    
+private:
+    std::vector<double> total_ms;
+    std::vector<double> matrix_ms;
+    std::vector<double> obstacles_ms;
+    std::vector<double> particles_ms;
+    PhaseCounters counter_totals;
+    int counter_frames = 0;
+    
+    void writeCounters(std::ostream& out, const PerfCounters& counters) const;
+    static void writePhase(std::ostream& out, const char* name, std::vector<double> samples, bool last);
+    static double percentile(const std::vector<double>& sorted, double fraction);
+};
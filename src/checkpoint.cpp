@@ -0,0 +1,151 @@
+#include "checkpoint.h"
+#include <cerrno>
+#include <cstdio>
+#include <sstream>
+
+namespace CheckpointFormat {
+
+uint64_t checksum(const uint8_t* data, std::size_t size) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (std::size_t i = 0; i < size; ++i) {
+        hash ^= data[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+} // namespace CheckpointFormat
+
+void CheckpointWriter::writeBytes(const void* data, std::size_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    payload.insert(payload.end(), bytes, bytes + size);
+}
+
+void CheckpointWriter::writeRng(const std::mt19937& rng) {
+    std::ostringstream state;
+    state << rng;
+    writeString(state.str());
+}
+
+bool CheckpointWriter::writeFile(const std::string& path, std::string& error) const {
+    CheckpointHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, CheckpointFormat::MAGIC, sizeof(header.magic));
+    header.version = CheckpointFormat::VERSION;
+    header.header_bytes = sizeof(header);
+    header.payload_bytes = payload.size();
+    header.checksum = CheckpointFormat::checksum(payload.data(), payload.size());
+
+    const std::string temporary = path + ".tmp";
+    std::FILE* file = std::fopen(temporary.c_str(), "wb");
+    if (!file) {
+        error = "could not open '" + temporary + "' for writing: " + std::strerror(errno);
+        return false;
+    }
+    bool written = std::fwrite(&header, 1, sizeof(header), file) == sizeof(header) &&
+                   std::fwrite(payload.data(), 1, payload.size(), file) == payload.size();
+    written = std::fclose(file) == 0 && written;
+    if (!written) {
+        error = "writing '" + temporary + "' failed";
+        std::remove(temporary.c_str());
+        return false;
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        error = "could not replace '" + path + "': " + std::strerror(errno);
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool CheckpointReader::open(const std::string& path) {
+    error.clear();
+    cursor = end = nullptr;
+    if (!file.open(path)) {
+        return fail(file.getError());
+    }
+
+    CheckpointHeader header;
+    if (file.size() < sizeof(header)) {
+        return fail("file is too short for a checkpoint header");
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, CheckpointFormat::MAGIC, sizeof(header.magic)) != 0) {
+        return fail("not a checkpoint file");
+    }
+    if (header.version != CheckpointFormat::VERSION) {
+        return fail("unsupported checkpoint version " + std::to_string(header.version));
+    }
+    if (header.header_bytes < sizeof(header) || header.header_bytes > file.size() ||
+        header.payload_bytes != file.size() - header.header_bytes) {
+        return fail("checkpoint is truncated");
+    }
+
+    cursor = file.data() + header.header_bytes;
+    end = cursor + header.payload_bytes;
+    if (CheckpointFormat::checksum(cursor, header.payload_bytes) != header.checksum) {
+        return fail("checkpoint checksum mismatch");
+    }
+    return true;
+}
+
+bool CheckpointReader::fail(const std::string& message) {
+    if (error.empty()) {
+        error = message;
+    }
+    cursor = end;
+    return false;
+}
+
+bool CheckpointReader::readBytes(void* data, std::size_t size) {
+    if (!ok()) {
+        return false;
+    }
+    if (static_cast<std::size_t>(end - cursor) < size) {
+        return fail("checkpoint ends early");
+    }
+    if (size == 0) {
+        return true;
+    }
+    std::memcpy(data, cursor, size);
+    cursor += size;
+    return true;
+}
+
+bool CheckpointReader::expectSection(uint32_t tag, const char* name) {
+    uint32_t value = 0;
+    if (!read(value)) {
+        return false;
+    }
+    if (value != tag) {
+        return fail(std::string("checkpoint section '") + name + "' not found");
+    }
+    return true;
+}
+
+bool CheckpointReader::readCount(uint64_t& count, uint64_t max_count) {
+    if (!read(count)) {
+        return false;
+    }
+    if (count > max_count) {
+        return fail("checkpoint array too large (" + std::to_string(count) + " entries)");
+    }
+    return true;
+}
+
+bool CheckpointReader::readString(std::string& value, uint64_t max_length) {
+    return readVector(value, max_length);
+}
+
+bool CheckpointReader::readRng(std::mt19937& rng) {
+    std::string text;
+    if (!readString(text, 1 << 16)) {
+        return false;
+    }
+    std::istringstream state(text);
+    state >> rng;
+    if (!state) {
+        return fail("checkpoint RNG state is malformed");
+    }
+    return true;
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "mapped_file.h"
+
+// Versioned binary blob for BrownianSimulation::saveCheckpoint().
+//
+//   CheckpointHeader | payload
+//
+// The payload is a sequence of sections, each a 32-bit tag followed by the
+// owner's fields in a fixed order. Values are raw host bytes (little-endian
+// on every platform we build for); arrays are a uint64 count then the
+// elements. std::mt19937 goes through its standard text form, which is the
+// only exact and portable way to get at its state. The header checksum
+// (FNV-1a of the payload) rejects a torn or corrupted file before anything
+// is restored.
+namespace CheckpointFormat {
+
+constexpr char MAGIC[8] = {'B', 'R', 'W', 'N', 'C', 'K', 'P', '\0'};
+constexpr uint32_t VERSION = 4; // 2: motion policy section, 3: particle ids, 4: particle order section
+
+constexpr uint32_t sectionTag(char a, char b, char c, char d) {
+    return static_cast<uint32_t>(a) | static_cast<uint32_t>(b) << 8 | static_cast<uint32_t>(c) << 16 |
+           static_cast<uint32_t>(d) << 24;
+}
+
+uint64_t checksum(const uint8_t* data, std::size_t size);
+
+} // namespace CheckpointFormat
+
+struct CheckpointHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_bytes;
+    uint64_t payload_bytes;
+    uint64_t checksum;
+};
+
+static_assert(sizeof(CheckpointHeader) == 32, "checkpoint header layout");
+
+// Builds a checkpoint payload in memory; writeFile() puts it on disk
+class CheckpointWriter {
+public:
+    void beginSection(uint32_t tag) { write(tag); }
+
+    template <typename T>
+    void write(const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "checkpoint values are raw bytes");
+        writeBytes(&value, sizeof(T));
+    }
+
+    template <typename T>
+    void writeArray(const T* values, std::size_t count) {
+        static_assert(std::is_trivially_copyable<T>::value, "checkpoint values are raw bytes");
+        write<uint64_t>(count);
+        writeBytes(values, count * sizeof(T));
+    }
+
+    template <typename Container>
+    void writeVector(const Container& values) { writeArray(values.data(), values.size()); }
+
+    void writeString(const std::string& value) { writeArray(value.data(), value.size()); }
+    void writeRng(const std::mt19937& rng);
+
+    // Written to path + ".tmp" first and renamed over path, so a crash while
+    // saving leaves the previous checkpoint intact
+    bool writeFile(const std::string& path, std::string& error) const;
+
+    std::size_t size() const { return payload.size(); }
+
+private:
+    std::vector<uint8_t> payload;
+
+    void writeBytes(const void* data, std::size_t size);
+};
+
+// Reads a checkpoint straight from the mapped file. Every read is bounds
+// checked; the first failure is kept in getError() and later reads fail too.
+class CheckpointReader {
+public:
+    CheckpointReader() : cursor(nullptr), end(nullptr) {}
+
+    // Map the file and validate the header and checksum
+    bool open(const std::string& path);
+
+    bool ok() const { return error.empty(); }
+    const std::string& getError() const { return error; }
+    bool fail(const std::string& message);
+
+    bool expectSection(uint32_t tag, const char* name);
+
+    template <typename T>
+    bool read(T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "checkpoint values are raw bytes");
+        return readBytes(&value, sizeof(T));
+    }
+
+    // Element count of the next array, refused if above max_count
+    bool readCount(uint64_t& count, uint64_t max_count);
+
+    template <typename Container>
+    bool readVector(Container& values, uint64_t max_count) {
+        uint64_t count = 0;
+        if (!readCount(count, max_count)) {
+            return false;
+        }
+        values.resize(count);
+        return readBytes(values.data(), count * sizeof(values[0]));
+    }
+
+    // An array whose stored count must be exactly count
+    template <typename T>
+    bool readArray(T* values, std::size_t count) {
+        uint64_t stored = 0;
+        if (!readCount(stored, count)) {
+            return false;
+        }
+        if (stored != count) {
+            return fail("checkpoint array has " + std::to_string(stored) + " entries, expected " +
+                        std::to_string(count));
+        }
+        return readBytes(values, count * sizeof(T));
+    }
+
+    bool readString(std::string& value, uint64_t max_length);
+    bool readRng(std::mt19937& rng);
+
+    bool atEnd() const { return cursor == end; }
+
+private:
+    MappedFile file;
+    const uint8_t* cursor;
+    const uint8_t* end;
+    std::string error;
+
+    bool readBytes(void* data, std::size_t size);
+};
@@ -0,0 +1,781 @@
+#include "compute_backend.h"
+#include "obstacle_system.h"
+
+#if defined(BROWNIAN_HAS_OPENCL)
+
+#define CL_TARGET_OPENCL_VERSION 120
+#if defined(__APPLE__)
+#include <OpenCL/opencl.h>
+#else
+#include <CL/cl.h>
+#endif
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace {
+
+// One work item per particle: updateParticleRange() for a single index.
+// The CPU kernels' operation order is kept; fma() stands where the AVX2
+// kernels fuse, and FP_CONTRACT OFF keeps the compiler from fusing elsewhere.
+const char* const PARTICLE_STEP_SOURCE = R"CL(
+#pragma OPENCL FP_CONTRACT OFF
+
+#define BOUNDARY_REFLECT 0
+#define BOUNDARY_PERIODIC 1
+#define BOUNDARY_ABSORB 2
+
+// CounterRng::generate with one Philox4x32-10 counter
+uint4 philox(uint4 c, uint key0, uint key1) {
+    for (int round = 0; round < 10; ++round) {
+        const uint hi0 = mul_hi(0xD2511F53u, c.x);
+        const uint lo0 = 0xD2511F53u * c.x;
+        const uint hi1 = mul_hi(0xCD9E8D57u, c.z);
+        const uint lo1 = 0xCD9E8D57u * c.z;
+        c = (uint4)(hi1 ^ c.y ^ key0, lo1, hi0 ^ c.w ^ key1, lo0);
+        key0 += 0x9E3779B9u;
+        key1 += 0xBB67AE85u;
+    }
+    return c;
+}
+
+float2 rotate(float2 v, float c, float s) {
+    return (float2)(v.x * c - v.y * s, v.x * s + v.y * c);
+}
+
+float2 reflect_velocity(float2 v, float2 n) {
+    const float dot_product = v.x * n.x + v.y * n.y;
+    return (float2)(v.x - 2.0f * dot_product * n.x, v.y - 2.0f * dot_product * n.y);
+}
+
+// Obstacle arrays, OBSTACLE_FIELDS of them, each obstacle_count long, in
+// ObstacleTransforms order
+#define CENTER_X 0
+#define CENTER_Y 1
+#define COS_ROTATION 2
+#define SIN_ROTATION 3
+#define HALF_WIDTH 4
+#define HALF_HEIGHT 5
+#define AABB_MIN_X 6
+#define AABB_MIN_Y 7
+#define AABB_MAX_X 8
+#define AABB_MAX_Y 9
+#define FIELD(field, index) obstacles[(field) * obstacle_count + (index)]
+
+// sweepBox / sweepCircle of obstacle_system.cpp
+float sweep_box(float2 p, float2 d, float hx, float hy, float2* normal) {
+    float t_enter = 0.0f;
+    float t_exit = 1.0f;
+    float2 enter_normal = (float2)(0.0f, 0.0f);
+    bool entered = false;
+    const float origin[2] = {p.x, p.y};
+    const float direction[2] = {d.x, d.y};
+    const float extent[2] = {hx, hy};
+    for (int axis = 0; axis < 2; ++axis) {
+        if (direction[axis] == 0.0f) {
+            if (fabs(origin[axis]) > extent[axis]) {
+                return 2.0f;
+            }
+            continue;
+        }
+        const float side = direction[axis] > 0.0f ? -1.0f : 1.0f;
+        const float t_near = (side * extent[axis] - origin[axis]) / direction[axis];
+        const float t_far = (-side * extent[axis] - origin[axis]) / direction[axis];
+        if (t_near > t_enter) {
+            t_enter = t_near;
+            enter_normal = axis == 0 ? (float2)(side, 0.0f) : (float2)(0.0f, side);
+            entered = true;
+        }
+        t_exit = min(t_exit, t_far);
+        if (t_enter > t_exit) {
+            return 2.0f;
+        }
+    }
+    if (!entered) {
+        return 2.0f;
+    }
+    *normal = enter_normal;
+    return t_enter;
+}
+
+float sweep_circle(float2 p, float2 d, float2 c, float r) {
+    const float2 m = p - c;
+    const float a = d.x * d.x + d.y * d.y;
+    const float b = m.x * d.x + m.y * d.y;
+    const float k = m.x * m.x + m.y * m.y - r * r;
+    if (k <= 0.0f || b >= 0.0f) {
+        return 2.0f;
+    }
+    const float discriminant = b * b - a * k;
+    if (discriminant < 0.0f) {
+        return 2.0f;
+    }
+    return (-b - sqrt(discriminant)) / a;
+}
+
+// checkLineRectangleCollision: time of impact (> 1 on a miss), contact and normal
+float sweep_obstacle(__global const float* obstacles, int obstacle_count, int index,
+                     float2 line_start, float2 line_end, float radius, float2* point, float2* normal) {
+    const float2 center = (float2)(FIELD(CENTER_X, index), FIELD(CENTER_Y, index));
+    const float cos_a = FIELD(COS_ROTATION, index);
+    const float sin_a = FIELD(SIN_ROTATION, index);
+    const float half_width = FIELD(HALF_WIDTH, index);
+    const float half_height = FIELD(HALF_HEIGHT, index);
+
+    const float2 local_start = rotate(line_start - center, cos_a, -sin_a);
+    const float2 local_end = rotate(line_end - center, cos_a, -sin_a);
+    const float2 motion = local_end - local_start;
+
+    const float outside_x = max(fabs(local_start.x) - half_width, 0.0f);
+    const float outside_y = max(fabs(local_start.y) - half_height, 0.0f);
+    if (outside_x * outside_x + outside_y * outside_y < radius * radius) {
+        return 2.0f;
+    }
+
+    float2 local_normal;
+    float2 box_normal = (float2)(0.0f, 0.0f);
+    float t_hit = sweep_box(local_start, motion, half_width + radius, half_height, &box_normal);
+    local_normal = box_normal;
+    float t = sweep_box(local_start, motion, half_width, half_height + radius, &box_normal);
+    if (t < t_hit) {
+        t_hit = t;
+        local_normal = box_normal;
+    }
+
+    int hit_corner = -1;
+    const float2 corners[4] = {
+        (float2)(-half_width, -half_height), (float2)(half_width, -half_height),
+        (float2)(-half_width, half_height), (float2)(half_width, half_height)
+    };
+    for (int corner = 0; corner < 4; ++corner) {
+        t = sweep_circle(local_start, motion, corners[corner], radius);
+        if (t < t_hit) {
+            t_hit = t;
+            hit_corner = corner;
+        }
+    }
+    if (t_hit > 1.0f) {
+        return t_hit;
+    }
+
+    const float2 local_contact = local_start + motion * t_hit;
+    if (hit_corner >= 0) {
+        local_normal = (local_contact - corners[hit_corner]) / radius;
+    }
+    *normal = rotate(local_normal, cos_a, sin_a);
+    *point = center + rotate(local_contact, cos_a, sin_a);
+    return t_hit;
+}
+
+// checkPointRectangleCollision: penetration depth, or 0 without overlap
+float overlap_obstacle(__global const float* obstacles, int obstacle_count, int index,
+                       float2 point, float radius, float2* normal) {
+    const float2 center = (float2)(FIELD(CENTER_X, index), FIELD(CENTER_Y, index));
+    const float cos_a = FIELD(COS_ROTATION, index);
+    const float sin_a = FIELD(SIN_ROTATION, index);
+    const float half_width = FIELD(HALF_WIDTH, index);
+    const float half_height = FIELD(HALF_HEIGHT, index);
+
+    const float2 local_point = rotate(point - center, cos_a, -sin_a);
+    const float2 closest = (float2)(clamp(local_point.x, -half_width, half_width),
+                                    clamp(local_point.y, -half_height, half_height));
+    const float2 offset = local_point - closest;
+    const float distance_squared = offset.x * offset.x + offset.y * offset.y;
+    if (distance_squared >= radius * radius) {
+        return 0.0f;
+    }
+
+    float2 local_normal;
+    float depth;
+    if (distance_squared > 0.0f) {
+        const float distance = sqrt(distance_squared);
+        local_normal = offset / distance;
+        depth = radius - distance;
+    } else {
+        const float penetration_x = half_width + radius - fabs(local_point.x);
+        const float penetration_y = half_height + radius - fabs(local_point.y);
+        if (penetration_x < penetration_y) {
+            local_normal = (float2)(local_point.x > 0 ? 1.0f : -1.0f, 0.0f);
+            depth = penetration_x;
+        } else {
+            local_normal = (float2)(0.0f, local_point.y > 0 ? 1.0f : -1.0f);
+            depth = penetration_y;
+        }
+    }
+    *normal = rotate(local_normal, cos_a, sin_a);
+    return depth;
+}
+
+// Whether obstacle index is binned into a cell of [x0, x1] x [y0, y1], as
+// ObstacleSystem::rebuildGrid() bins it: the CPU only tests those
+bool in_cells(__global const float* obstacles, int obstacle_count, int index,
+              int x0, int y0, int x1, int y1, int columns, int rows) {
+    const int ox0 = clamp((int)floor(FIELD(AABB_MIN_X, index) / GRID_CELL_SIZE), 0, columns - 1);
+    const int ox1 = clamp((int)floor(FIELD(AABB_MAX_X, index) / GRID_CELL_SIZE), 0, columns - 1);
+    const int oy0 = clamp((int)floor(FIELD(AABB_MIN_Y, index) / GRID_CELL_SIZE), 0, rows - 1);
+    const int oy1 = clamp((int)floor(FIELD(AABB_MAX_Y, index) / GRID_CELL_SIZE), 0, rows - 1);
+    return ox0 <= x1 && ox1 >= x0 && oy0 <= y1 && oy1 >= y0;
+}
+
+// ObstacleSystem::handleParticleCollision without the grid: every obstacle
+// is visited, and the ones outside the cells the CPU would visit are skipped
+bool collide(__global const float* obstacles, int obstacle_count, int columns, int rows,
+             float2 previous, float2* position, float2* velocity, float radius) {
+    const float sweep_min_x = min(previous.x, position->x);
+    const float sweep_max_x = max(previous.x, position->x);
+    const float sweep_min_y = min(previous.y, position->y);
+    const float sweep_max_y = max(previous.y, position->y);
+
+    if (sweep_max_x > sweep_min_x || sweep_max_y > sweep_min_y) {
+        const int x0 = clamp((int)(sweep_min_x / GRID_CELL_SIZE), 0, columns - 1);
+        const int x1 = clamp((int)(sweep_max_x / GRID_CELL_SIZE), 0, columns - 1);
+        const int y0 = clamp((int)(sweep_min_y / GRID_CELL_SIZE), 0, rows - 1);
+        const int y1 = clamp((int)(sweep_max_y / GRID_CELL_SIZE), 0, rows - 1);
+
+        float first_time = 1.0f;
+        bool hit = false;
+        float2 hit_point = (float2)(0.0f, 0.0f);
+        float2 hit_normal = (float2)(0.0f, 0.0f);
+        for (int index = 0; index < obstacle_count; ++index) {
+            if (!in_cells(obstacles, obstacle_count, index, x0, y0, x1, y1, columns, rows) ||
+                sweep_max_x < FIELD(AABB_MIN_X, index) || sweep_min_x > FIELD(AABB_MAX_X, index) ||
+                sweep_max_y < FIELD(AABB_MIN_Y, index) || sweep_min_y > FIELD(AABB_MAX_Y, index)) {
+                continue;
+            }
+            float2 point, normal;
+            const float t = sweep_obstacle(obstacles, obstacle_count, index, previous, *position, radius,
+                                           &point, &normal);
+            if (t <= 1.0f && t < first_time) {
+                first_time = t;
+                hit = true;
+                hit_point = point;
+                hit_normal = normal;
+            }
+        }
+        if (hit) {
+            *position = hit_point + hit_normal * CONTACT_OFFSET;
+            *velocity = reflect_velocity(*velocity, hit_normal) * 0.8f;
+            return true;
+        }
+    }
+
+    bool any_collision = false;
+    const int cell_x = clamp((int)(position->x / GRID_CELL_SIZE), 0, columns - 1);
+    const int cell_y = clamp((int)(position->y / GRID_CELL_SIZE), 0, rows - 1);
+    for (int index = 0; index < obstacle_count; ++index) {
+        if (!in_cells(obstacles, obstacle_count, index, cell_x, cell_y, cell_x, cell_y, columns, rows) ||
+            position->x < FIELD(AABB_MIN_X, index) || position->x > FIELD(AABB_MAX_X, index) ||
+            position->y < FIELD(AABB_MIN_Y, index) || position->y > FIELD(AABB_MAX_Y, index)) {
+            continue;
+        }
+        float2 normal;
+        const float depth = overlap_obstacle(obstacles, obstacle_count, index, *position, radius, &normal);
+        if (depth > 0.0f) {
+            *position = *position + normal * depth;
+            *velocity = reflect_velocity(*velocity, normal) * 0.7f;
+            any_collision = true;
+        }
+    }
+    return any_collision;
+}
+
+void bounce_axis(float* p, float* v, float r, float extent, float restitution) {
+    if (*p <= r || *p >= extent - r) {
+        *v *= restitution;
+        *p = max(r, min(*p, extent - r));
+    }
+}
+
+float wrap_axis(float p, float extent) {
+    p += p < 0.0f ? extent : 0.0f;
+    p -= p >= extent ? extent : 0.0f;
+    return p;
+}
+
+__kernel void step_particles(__global float* pos_x, __global float* pos_y,
+                             __global float* vel_x, __global float* vel_y,
+                             __global const float* radius, __global uchar4* color,
+                             __global const uint* id, uint count,
+                             uint key0, uint key1, uint frame_lo, uint frame_hi,
+                             float noise_low, float noise_range_scale,
+                             float noise_scale, float damping, float position_scale,
+                             float width, float height, float restitution, float sigma,
+                             __global const float* obstacles, int obstacle_count, int columns, int rows) {
+    const uint i = get_global_id(0);
+    if (i >= count) {
+        return;
+    }
+
+    // Noise: CounterRng::toRange / toUnitFloat on the motion stream, fused
+    // like the AVX2 mapping (GCC contracts its add of a product)
+    const uint4 block = philox((uint4)(id[i], frame_lo, frame_hi, 0u), key0, key1);
+    float noise_x = fma((float)(block.x >> 8), noise_range_scale, noise_low);
+    float noise_y = fma((float)(block.y >> 8), noise_range_scale, noise_low);
+    const float color_roll = (float)(block.z >> 8) * (1.0f / 16777216.0f);
+#if GAUSSIAN
+    const float kick = sigma * sqrt(-2.0f * log(1.0f - noise_x));
+    const float angle = 6.28318531f * noise_y;
+    noise_x = kick * cos(angle);
+    noise_y = kick * sin(angle);
+#endif
+
+    float vx = fma(noise_x, noise_scale, vel_x[i]) * damping;
+    float vy = fma(noise_y, noise_scale, vel_y[i]) * damping;
+    float x = fma(vx, position_scale, pos_x[i]);
+    float y = fma(vy, position_scale, pos_y[i]);
+    const float r = radius[i];
+
+#if HAS_OBSTACLES
+    float2 position = (float2)(x, y);
+    float2 velocity = (float2)(vx, vy);
+    const float2 previous = position - velocity * position_scale;
+    if (collide(obstacles, obstacle_count, columns, rows, previous, &position, &velocity, r)) {
+        x = position.x;
+        y = position.y;
+        vx = velocity.x;
+        vy = velocity.y;
+    }
+#endif
+
+#if BOUNDARY == BOUNDARY_PERIODIC
+    x = wrap_axis(x, width);
+    y = wrap_axis(y, height);
+#else
+    bounce_axis(&x, &vx, r, width, restitution);
+    bounce_axis(&y, &vy, r, height, restitution);
+#endif
+
+    pos_x[i] = x;
+    pos_y[i] = y;
+    vel_x[i] = vx;
+    vel_y[i] = vy;
+
+#if COLOR_JITTER
+    if (color_roll > COLOR_CHANGE_THRESHOLD) {
+        const uint4 change = philox((uint4)(id[i], frame_lo, frame_hi, 1u), key0, key1);
+        const uint span = 2 * COLOR_STEP + 1;
+        int4 channels = convert_int4(color[i]);
+        channels.x = clamp(channels.x + (int)(change.x % span) - COLOR_STEP, 0, COLOR_MAX);
+        channels.y = clamp(channels.y + (int)(change.y % span) - COLOR_STEP, 0, COLOR_MAX);
+        channels.z = clamp(channels.z + (int)(change.z % span) - COLOR_STEP, 0, COLOR_MAX);
+        color[i] = convert_uchar4(channels);
+    }
+#endif
+}
+)CL";
+
+constexpr int OBSTACLE_FIELDS = 10;
+constexpr int VARIANT_COUNT = 3 * 2 * 2 * 2; // Boundary x noise x jitter x obstacles
+
+const char* describeStatus(cl_int status) {
+    switch (status) {
+        case CL_DEVICE_NOT_FOUND: return "no OpenCL device";
+        case CL_OUT_OF_RESOURCES: return "device out of resources";
+        case CL_OUT_OF_HOST_MEMORY: return "out of host memory";
+        case CL_MEM_OBJECT_ALLOCATION_FAILURE: return "device buffer allocation failed";
+        case CL_BUILD_PROGRAM_FAILURE: return "kernel build failed";
+        case CL_INVALID_KERNEL_ARGS: return "invalid kernel arguments";
+        default: return "OpenCL error";
+    }
+}
+
+} // namespace
+
+struct ComputeBackend::Device {
+    cl_device_id device_id = nullptr;
+    cl_context context = nullptr;
+    cl_command_queue queue = nullptr;
+    std::string build_options; // Shared by every variant
+    cl_program programs[VARIANT_COUNT] = {};
+    cl_kernel kernels[VARIANT_COUNT] = {};
+
+    // Particle arrays; capacity in particles, count as last uploaded
+    cl_mem pos_x = nullptr;
+    cl_mem pos_y = nullptr;
+    cl_mem vel_x = nullptr;
+    cl_mem vel_y = nullptr;
+    cl_mem radius = nullptr;
+    cl_mem color = nullptr;
+    cl_mem id = nullptr;
+    std::size_t capacity = 0;
+    std::size_t count = 0;
+
+    cl_mem obstacles = nullptr;
+    std::size_t obstacle_capacity = 0;
+    std::vector<float> obstacle_staging;
+
+    void releaseParticles() {
+        for (cl_mem* buffer : {&pos_x, &pos_y, &vel_x, &vel_y, &radius, &color, &id}) {
+            if (*buffer) {
+                clReleaseMemObject(*buffer);
+                *buffer = nullptr;
+            }
+        }
+        capacity = 0;
+    }
+
+    ~Device() {
+        releaseParticles();
+        if (obstacles) {
+            clReleaseMemObject(obstacles);
+        }
+        for (int variant = 0; variant < VARIANT_COUNT; ++variant) {
+            if (kernels[variant]) {
+                clReleaseKernel(kernels[variant]);
+            }
+            if (programs[variant]) {
+                clReleaseProgram(programs[variant]);
+            }
+        }
+        if (queue) {
+            clReleaseCommandQueue(queue);
+        }
+        if (context) {
+            clReleaseContext(context);
+        }
+    }
+};
+
+ComputeBackend::ComputeBackend() = default;
+
+ComputeBackend::~ComputeBackend() = default;
+
+bool ComputeBackend::isAvailable() {
+    return true;
+}
+
+bool ComputeBackend::open() {
+    close();
+
+    cl_uint platform_count = 0;
+    if (clGetPlatformIDs(0, nullptr, &platform_count) != CL_SUCCESS || platform_count == 0) {
+        error = "no OpenCL platform";
+        return false;
+    }
+    std::vector<cl_platform_id> platforms(platform_count);
+    clGetPlatformIDs(platform_count, platforms.data(), nullptr);
+
+    // Prefer a GPU anywhere over whatever comes first
+    cl_device_id chosen = nullptr;
+    for (cl_device_type type : {static_cast<cl_device_type>(CL_DEVICE_TYPE_GPU),
+                                static_cast<cl_device_type>(CL_DEVICE_TYPE_ALL)}) {
+        for (cl_platform_id platform : platforms) {
+            if (clGetDeviceIDs(platform, type, 1, &chosen, nullptr) == CL_SUCCESS) {
+                break;
+            }
+            chosen = nullptr;
+        }
+        if (chosen) {
+            break;
+        }
+    }
+    if (!chosen) {
+        error = "no OpenCL device";
+        return false;
+    }
+
+    auto created = std::make_unique<Device>();
+    created->device_id = chosen;
+    cl_int status = CL_SUCCESS;
+    created->context = clCreateContext(nullptr, 1, &chosen, nullptr, nullptr, &status);
+    if (status == CL_SUCCESS) {
+        created->queue = clCreateCommandQueue(created->context, chosen, 0, &status);
+    }
+    if (status != CL_SUCCESS) {
+        error = describeStatus(status);
+        return false;
+    }
+
+    char name[256] = {};
+    clGetDeviceInfo(chosen, CL_DEVICE_NAME, sizeof(name) - 1, name, nullptr);
+    device_name = name;
+
+    // Correctly rounded division and sqrt where the device offers them, as on
+    // the CPU; the policy constants come in as defines
+    cl_device_fp_config fp_config = 0;
+    clGetDeviceInfo(chosen, CL_DEVICE_SINGLE_FP_CONFIG, sizeof(fp_config), &fp_config, nullptr);
+    std::string options = "-cl-std=CL1.2";
+    if (fp_config & CL_FP_CORRECTLY_ROUNDED_DIVIDE_SQRT) {
+        options += " -cl-fp32-correctly-rounded-divide-sqrt";
+    }
+    options += " -DGRID_CELL_SIZE=" + std::to_string(ObstacleSystem::GRID_CELL_SIZE) + "f";
+    options += " -DCONTACT_OFFSET=" + std::to_string(ObstacleSystem::CONTACT_OFFSET) + "f";
+    options += " -DCOLOR_CHANGE_THRESHOLD=" + std::to_string(MotionPolicy::COLOR_CHANGE_THRESHOLD) + "f";
+    options += " -DCOLOR_STEP=" + std::to_string(MotionPolicy::COLOR_STEP);
+    options += " -DCOLOR_MAX=" + std::to_string(MotionPolicy::COLOR_MAX);
+    created->build_options = options;
+
+    device = std::move(created);
+    error.clear();
+    return true;
+}
+
+void ComputeBackend::close() {
+    device.reset();
+    device_name.clear();
+}
+
+bool ComputeBackend::upload(const ParticleStore& particles) {
+    if (!device) {
+        error = "backend not open";
+        return false;
+    }
+    Device& d = *device;
+    const std::size_t count = particles.size();
+    cl_int status = CL_SUCCESS;
+    if (count > d.capacity) {
+        d.releaseParticles();
+        const std::size_t capacity = count + count / 4;
+        cl_mem* float_buffers[] = {&d.pos_x, &d.pos_y, &d.vel_x, &d.vel_y, &d.radius};
+        for (cl_mem* buffer : float_buffers) {
+            *buffer = clCreateBuffer(d.context, CL_MEM_READ_WRITE, capacity * sizeof(float), nullptr, &status);
+            if (status != CL_SUCCESS) {
+                break;
+            }
+        }
+        if (status == CL_SUCCESS) {
+            d.color = clCreateBuffer(d.context, CL_MEM_READ_WRITE, capacity * sizeof(Color), nullptr, &status);
+        }
+        if (status == CL_SUCCESS) {
+            d.id = clCreateBuffer(d.context, CL_MEM_READ_ONLY, capacity * sizeof(uint32_t), nullptr, &status);
+        }
+        if (status != CL_SUCCESS) {
+            d.releaseParticles();
+            error = describeStatus(status);
+            return false;
+        }
+        d.capacity = capacity;
+    }
+
+    d.count = count;
+    if (count == 0) {
+        return true;
+    }
+    const std::pair<cl_mem, const void*> float_arrays[] = {
+        {d.pos_x, particles.pos_x.data()}, {d.pos_y, particles.pos_y.data()},
+        {d.vel_x, particles.vel_x.data()}, {d.vel_y, particles.vel_y.data()},
+        {d.radius, particles.radius.data()}
+    };
+    for (const auto& array : float_arrays) {
+        status |= clEnqueueWriteBuffer(d.queue, array.first, CL_FALSE, 0, count * sizeof(float), array.second,
+                                       0, nullptr, nullptr);
+    }
+    status |= clEnqueueWriteBuffer(d.queue, d.color, CL_FALSE, 0, count * sizeof(Color), particles.color.data(),
+                                   0, nullptr, nullptr);
+    status |= clEnqueueWriteBuffer(d.queue, d.id, CL_FALSE, 0, count * sizeof(uint32_t), particles.id.data(),
+                                   0, nullptr, nullptr);
+    // The host arrays may change as soon as this returns
+    status |= clFinish(d.queue);
+    if (status != CL_SUCCESS) {
+        error = "particle upload failed";
+        return false;
+    }
+    return true;
+}
+
+bool ComputeBackend::download(ParticleStore& particles) const {
+    if (!device || particles.size() != device->count) {
+        error = "no uploaded particles of this size";
+        return false;
+    }
+    const Device& d = *device;
+    const std::size_t count = d.count;
+    if (count == 0) {
+        return true;
+    }
+    cl_int status = CL_SUCCESS;
+    const std::pair<cl_mem, void*> float_arrays[] = {
+        {d.pos_x, particles.pos_x.data()}, {d.pos_y, particles.pos_y.data()},
+        {d.vel_x, particles.vel_x.data()}, {d.vel_y, particles.vel_y.data()}
+    };
+    for (const auto& array : float_arrays) {
+        status |= clEnqueueReadBuffer(d.queue, array.first, CL_FALSE, 0, count * sizeof(float), array.second,
+                                      0, nullptr, nullptr);
+    }
+    status |= clEnqueueReadBuffer(d.queue, d.color, CL_FALSE, 0, count * sizeof(Color), particles.color.data(),
+                                  0, nullptr, nullptr);
+    status |= clFinish(d.queue);
+    if (status != CL_SUCCESS) {
+        error = "particle download failed";
+        return false;
+    }
+    return true;
+}
+
+bool ComputeBackend::step(const ComputeStep& step, const CounterRng& rng, const ObstacleSystem& obstacles) {
+    if (!device) {
+        error = "backend not open";
+        return false;
+    }
+    Device& d = *device;
+    if (d.count == 0) {
+        return true;
+    }
+
+    // Kernel for this combination of policies, built on first use
+    const int obstacle_count = obstacles.getObstacleCount();
+    const int variant = ((static_cast<int>(step.boundary) * 2 + (step.noise == NoiseMode::Gaussian)) * 2 +
+                         step.color_jitter) * 2 + (obstacle_count > 0);
+    cl_int status = CL_SUCCESS;
+    if (!d.kernels[variant]) {
+        const std::string options = d.build_options +
+            " -DBOUNDARY=" + std::to_string(static_cast<int>(step.boundary)) +
+            " -DGAUSSIAN=" + std::to_string(step.noise == NoiseMode::Gaussian ? 1 : 0) +
+            " -DCOLOR_JITTER=" + std::to_string(step.color_jitter ? 1 : 0) +
+            " -DHAS_OBSTACLES=" + std::to_string(obstacle_count > 0 ? 1 : 0);
+        const char* source = PARTICLE_STEP_SOURCE;
+        cl_program program = clCreateProgramWithSource(d.context, 1, &source, nullptr, &status);
+        if (status == CL_SUCCESS) {
+            status = clBuildProgram(program, 1, &d.device_id, options.c_str(), nullptr, nullptr);
+        }
+        if (status != CL_SUCCESS) {
+            std::size_t log_size = 0;
+            clGetProgramBuildInfo(program, d.device_id, CL_PROGRAM_BUILD_LOG, 0, nullptr, &log_size);
+            std::string log(log_size, '\0');
+            clGetProgramBuildInfo(program, d.device_id, CL_PROGRAM_BUILD_LOG, log_size, &log[0], nullptr);
+            error = std::string(describeStatus(status)) + ": " + log;
+            if (program) {
+                clReleaseProgram(program);
+            }
+            return false;
+        }
+        d.programs[variant] = program;
+        d.kernels[variant] = clCreateKernel(program, "step_particles", &status);
+        if (status != CL_SUCCESS) {
+            d.kernels[variant] = nullptr;
+            error = describeStatus(status);
+            return false;
+        }
+    }
+
+    // This frame's poses, packed field by field
+    const ObstacleTransforms& transforms = obstacles.getTransforms();
+    const std::size_t obstacle_floats = static_cast<std::size_t>(std::max(obstacle_count, 1)) * OBSTACLE_FIELDS;
+    if (obstacle_floats > d.obstacle_capacity) {
+        if (d.obstacles) {
+            clReleaseMemObject(d.obstacles);
+        }
+        d.obstacles = clCreateBuffer(d.context, CL_MEM_READ_ONLY, obstacle_floats * sizeof(float), nullptr, &status);
+        if (status != CL_SUCCESS) {
+            d.obstacles = nullptr;
+            d.obstacle_capacity = 0;
+            error = describeStatus(status);
+            return false;
+        }
+        d.obstacle_capacity = obstacle_floats;
+    }
+    if (obstacle_count > 0) {
+        d.obstacle_staging.resize(obstacle_floats);
+        const std::vector<float>* fields[OBSTACLE_FIELDS] = {
+            &transforms.center_x, &transforms.center_y, &transforms.cos_rotation, &transforms.sin_rotation,
+            &transforms.half_width, &transforms.half_height,
+            &transforms.aabb_min_x, &transforms.aabb_min_y, &transforms.aabb_max_x, &transforms.aabb_max_y
+        };
+        for (int field = 0; field < OBSTACLE_FIELDS; ++field) {
+            std::copy(fields[field]->begin(), fields[field]->end(), d.obstacle_staging.begin() + field * obstacle_count);
+        }
+        status = clEnqueueWriteBuffer(d.queue, d.obstacles, CL_FALSE, 0, obstacle_floats * sizeof(float),
+                                      d.obstacle_staging.data(), 0, nullptr, nullptr);
+    }
+
+    const cl_uint count = static_cast<cl_uint>(d.count);
+    const cl_uint key0 = rng.getKey0();
+    const cl_uint key1 = rng.getKey1();
+    const cl_uint frame_lo = static_cast<cl_uint>(step.frame);
+    const cl_uint frame_hi = static_cast<cl_uint>(step.frame >> 32);
+    // The noise policies' ranges and the walls' restitution
+    const bool gaussian = step.noise == NoiseMode::Gaussian;
+    const float noise_low = gaussian ? 0.0f : -MotionPolicy::NOISE_AMPLITUDE;
+    const float noise_high = gaussian ? 1.0f : MotionPolicy::NOISE_AMPLITUDE;
+    const float noise_range_scale = (noise_high - noise_low) * (1.0f / 16777216.0f);
+    const float restitution = step.boundary == BoundaryMode::Absorb ? MotionPolicy::AbsorbBoundary::RESTITUTION
+                                                                    : MotionPolicy::ReflectBoundary::RESTITUTION;
+    const float sigma = MotionPolicy::GaussianNoise::SIGMA;
+    const cl_int columns = obstacles.getGridColumns();
+    const cl_int rows = obstacles.getGridRows();
+    const cl_int device_obstacle_count = obstacle_count;
+
+    cl_kernel kernel = d.kernels[variant];
+    cl_uint arg = 0;
+    auto setArg = [&](std::size_t size, const void* value) {
+        status |= clSetKernelArg(kernel, arg++, size, value);
+    };
+    setArg(sizeof(cl_mem), &d.pos_x);
+    setArg(sizeof(cl_mem), &d.pos_y);
+    setArg(sizeof(cl_mem), &d.vel_x);
+    setArg(sizeof(cl_mem), &d.vel_y);
+    setArg(sizeof(cl_mem), &d.radius);
+    setArg(sizeof(cl_mem), &d.color);
+    setArg(sizeof(cl_mem), &d.id);
+    setArg(sizeof(count), &count);
+    setArg(sizeof(key0), &key0);
+    setArg(sizeof(key1), &key1);
+    setArg(sizeof(frame_lo), &frame_lo);
+    setArg(sizeof(frame_hi), &frame_hi);
+    setArg(sizeof(noise_low), &noise_low);
+    setArg(sizeof(noise_range_scale), &noise_range_scale);
+    setArg(sizeof(float), &step.integration.noise_scale);
+    setArg(sizeof(float), &step.integration.damping);
+    setArg(sizeof(float), &step.integration.position_scale);
+    setArg(sizeof(float), &step.width);
+    setArg(sizeof(float), &step.height);
+    setArg(sizeof(restitution), &restitution);
+    setArg(sizeof(sigma), &sigma);
+    setArg(sizeof(cl_mem), &d.obstacles);
+    setArg(sizeof(device_obstacle_count), &device_obstacle_count);
+    setArg(sizeof(columns), &columns);
+    setArg(sizeof(rows), &rows);
+
+    // The driver picks the work-group size; the kernel skips the rounded-up tail
+    constexpr std::size_t GROUP = 256;
+    const std::size_t global_size = (d.count + GROUP - 1) / GROUP * GROUP;
+    status |= clEnqueueNDRangeKernel(d.queue, kernel, 1, nullptr, &global_size, nullptr, 0, nullptr, nullptr);
+    // Finished before returning, so update()'s phase timings include the kernel
+    status |= clFinish(d.queue);
+    if (status != CL_SUCCESS) {
+        error = "particle step failed";
+        return false;
+    }
+    return true;
+}
+
+#else
+
+// Built without OpenCL: the backend never opens
+
+struct ComputeBackend::Device {
+};
+
+ComputeBackend::ComputeBackend() = default;
+
+ComputeBackend::~ComputeBackend() = default;
+
+bool ComputeBackend::isAvailable() {
+    return false;
+}
+
+bool ComputeBackend::open() {
+    error = "built without OpenCL (configure with -DBROWNIAN_OPENCL=ON)";
+    return false;
+}
+
+void ComputeBackend::close() {
+    device.reset();
+}
+
+bool ComputeBackend::upload(const ParticleStore&) {
+    error = "built without OpenCL";
+    return false;
+}
+
+bool ComputeBackend::download(ParticleStore&) const {
+    error = "built without OpenCL";
+    return false;
+}
+
+bool ComputeBackend::step(const ComputeStep&, const CounterRng&, const ObstacleSystem&) {
+    error = "built without OpenCL";
+    return false;
+}
+
+#endif
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "particle_store.h"
+#include "particle_kernels.h"
+#include "counter_rng.h"
+#include "motion_policies.h"
+
+class ObstacleSystem;
+
+// Settings of one device step: the CPU pass's coefficients, frame and policies
+struct ComputeStep {
+    IntegrationStep integration;
+    uint64_t frame = 0;
+    float width = 0.0f;
+    float height = 0.0f;
+    BoundaryMode boundary = BoundaryMode::Reflect;
+    NoiseMode noise = NoiseMode::Uniform;
+    bool color_jitter = true;
+};
+
+// Optional OpenCL backend for the particle pass. The particle arrays stay
+// resident on the device; a step runs noise, integration, obstacle
+// collisions, walls and color jitter for every particle in one kernel, with
+// only the obstacle poses uploaded per frame. The kernel mirrors
+// updateParticleRange() operation for operation (the same Philox streams,
+// fused multiply-adds where the AVX2 kernels fuse, no contraction elsewhere),
+// so it can be cross-checked against the CPU reference; libm-backed Gaussian
+// noise and the device's sqrt can still differ in the last ulp.
+//
+// Like updateParticleRange(), the kernel is built once per combination of
+// boundary, noise, jitter and obstacles (as -D defines) when first used.
+//
+// Built without BROWNIAN_HAS_OPENCL, open() fails and nothing else is valid.
+class ComputeBackend {
+public:
+    ComputeBackend();
+    ~ComputeBackend();
+
+    ComputeBackend(const ComputeBackend&) = delete;
+    ComputeBackend& operator=(const ComputeBackend&) = delete;
+
+    // Whether this build has the OpenCL backend at all
+    static bool isAvailable();
+
+    // First GPU of any platform, else the first device of any type; false
+    // with the reason in getError()
+    bool open();
+    void close();
+    bool isOpen() const { return static_cast<bool>(device); }
+    const std::string& getDeviceName() const { return device_name; }
+    const std::string& getError() const { return error; }
+
+    // Copy every particle array to the device, growing its buffers if needed
+    bool upload(const ParticleStore& particles);
+    // Positions, velocities and colors back into particles, which must have
+    // the uploaded size (radii and ids never change on the device)
+    bool download(ParticleStore& particles) const;
+    // One step of every uploaded particle against the obstacles' current poses
+    bool step(const ComputeStep& step, const CounterRng& rng, const ObstacleSystem& obstacles);
+
+private:
+    struct Device; // OpenCL handles, kept out of this header
+    std::unique_ptr<Device> device;
+    std::string device_name;
+    mutable std::string error;
+};
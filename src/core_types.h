@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+
+// Small value types of the simulation core, so it builds without SFML. They
+// mirror sf::Vector2f / sf::Color (same members, same layout); the viewer
+// converts at the draw boundary.
+
+struct Vec2f {
+    float x;
+    float y;
+
+    constexpr Vec2f() : x(0.0f), y(0.0f) {}
+    constexpr Vec2f(float x, float y) : x(x), y(y) {}
+
+    Vec2f& operator+=(const Vec2f& other) { x += other.x; y += other.y; return *this; }
+    Vec2f& operator-=(const Vec2f& other) { x -= other.x; y -= other.y; return *this; }
+    Vec2f& operator*=(float scale) { x *= scale; y *= scale; return *this; }
+};
+
+constexpr Vec2f operator+(const Vec2f& a, const Vec2f& b) { return Vec2f(a.x + b.x, a.y + b.y); }
+constexpr Vec2f operator-(const Vec2f& a, const Vec2f& b) { return Vec2f(a.x - b.x, a.y - b.y); }
+constexpr Vec2f operator-(const Vec2f& v) { return Vec2f(-v.x, -v.y); }
+constexpr Vec2f operator*(const Vec2f& v, float scale) { return Vec2f(v.x * scale, v.y * scale); }
+constexpr Vec2f operator*(float scale, const Vec2f& v) { return Vec2f(v.x * scale, v.y * scale); }
+constexpr Vec2f operator/(const Vec2f& v, float divisor) { return Vec2f(v.x / divisor, v.y / divisor); }
+
+// 8-bit RGBA
+struct Color {
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+    uint8_t a;
+
+    constexpr Color() : r(0), g(0), b(0), a(255) {}
+    constexpr Color(uint8_t r, uint8_t g, uint8_t b, uint8_t a = 255) : r(r), g(g), b(b), a(a) {}
+};
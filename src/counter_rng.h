@@ -0,0 +1,73 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+// Counter-based random number generator (Philox4x32-10, Salmon et al. 2011).
+// Every draw is a pure function of (seed, counter), so particle i can get its
+// noise for frame f on any thread, in any order, and still be reproducible.
+class CounterRng {
+public:
+    using Block = std::array<uint32_t, 4>;
+
+    // Independent streams for different consumers of the same (index, frame)
+    enum Stream : uint32_t {
+        STREAM_MOTION = 0, // noise_x, noise_y, color roll
+        STREAM_COLOR = 1,  // color channel deltas
+        STREAM_INIT = 2,   // initial distribution of particles
+        STREAM_MATRIX = 3  // values of the per-frame matrix operand
+    };
+
+    static constexpr uint32_t MULTIPLIER_0 = 0xD2511F53u;
+    static constexpr uint32_t MULTIPLIER_1 = 0xCD9E8D57u;
+    static constexpr uint32_t WEYL_0 = 0x9E3779B9u;
+    static constexpr uint32_t WEYL_1 = 0xBB67AE85u;
+    static constexpr int ROUNDS = 10;
+
+    explicit CounterRng(uint64_t seed = 0) : seed(seed) {}
+
+    uint64_t getSeed() const { return seed; }
+    uint32_t getKey0() const { return static_cast<uint32_t>(seed); }
+    uint32_t getKey1() const { return static_cast<uint32_t>(seed >> 32); }
+
+    // Four random words for (index, frame, stream)
+    Block generate(uint32_t index, uint64_t frame, uint32_t stream) const {
+        Block counter = {index, static_cast<uint32_t>(frame), static_cast<uint32_t>(frame >> 32), stream};
+        uint32_t key0 = getKey0();
+        uint32_t key1 = getKey1();
+
+        for (int round = 0; round < ROUNDS; ++round) {
+            uint64_t product0 = static_cast<uint64_t>(MULTIPLIER_0) * counter[0];
+            uint64_t product1 = static_cast<uint64_t>(MULTIPLIER_1) * counter[2];
+
+            counter = {
+                static_cast<uint32_t>(product1 >> 32) ^ counter[1] ^ key0,
+                static_cast<uint32_t>(product1),
+                static_cast<uint32_t>(product0 >> 32) ^ counter[3] ^ key1,
+                static_cast<uint32_t>(product0)
+            };
+
+            key0 += WEYL_0;
+            key1 += WEYL_1;
+        }
+
+        return counter;
+    }
+
+    // Top 24 bits of a word as a float in [0, 1); exact, so SIMD and scalar paths agree
+    static float toUnitFloat(uint32_t word) {
+        return static_cast<float>(word >> 8) * (1.0f / 16777216.0f);
+    }
+
+    static float toRange(uint32_t word, float low, float high) {
+        return low + static_cast<float>(word >> 8) * ((high - low) * (1.0f / 16777216.0f));
+    }
+
+    // Integer in [low, high], for the rare draws where a tiny modulo bias is irrelevant
+    static int toInt(uint32_t word, int low, int high) {
+        return low + static_cast<int>(word % static_cast<uint32_t>(high - low + 1));
+    }
+
+private:
+    uint64_t seed;
+};
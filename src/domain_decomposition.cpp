@@ -0,0 +1,312 @@
+#include "domain_decomposition.h"
+#include "profiler.h"
+#include <algorithm>
+#include <chrono>
+
+#if defined(BROWNIAN_HAS_MPI)
+#include <mpi.h>
+#endif
+
+DomainDecomposition::DomainDecomposition(int width, int height, int particle_count, uint64_t seed,
+                                         int obstacle_count, int tile_columns, int tile_rows)
+    : columns(std::max(tile_columns, 1)),
+      rows(std::max(tile_rows, 1)),
+      rank(getRank()),
+      rank_count(getRankCount()),
+      tile_width(static_cast<float>(width) / columns),
+      tile_height(static_cast<float>(height) / rows),
+      last_migrations(0),
+      last_migration_ms(0.0) {
+
+    // The last row and column run to the world's edge, whatever the rounding
+    bounds.resize(getTileCount());
+    for (int row = 0; row < rows; ++row) {
+        for (int column = 0; column < columns; ++column) {
+            TileBounds& tile = bounds[row * columns + column];
+            tile.min_x = column * tile_width;
+            tile.min_y = row * tile_height;
+            tile.max_x = column + 1 == columns ? static_cast<float>(width) : (column + 1) * tile_width;
+            tile.max_y = row + 1 == rows ? static_cast<float>(height) : (row + 1) * tile_height;
+        }
+    }
+
+    // Each tile replays the single simulation's initialization, so particles
+    // and obstacles match it exactly, then drops the particles outside it
+    local_index.assign(getTileCount(), -1);
+    ParticleStore discarded;
+    for (int tile = 0; tile < getTileCount(); ++tile) {
+        if (ownerRank(tile) != rank) {
+            continue;
+        }
+        LocalTile local;
+        local.tile = tile;
+        local.simulation = std::make_unique<BrownianSimulation>(width, height, particle_count, seed, obstacle_count);
+        discarded.clear();
+        const TileBounds& own = bounds[tile];
+        local.simulation->extractParticlesOutside(own.min_x, own.min_y, own.max_x, own.max_y, discarded);
+        local_index[tile] = static_cast<int>(tiles.size());
+        tiles.push_back(std::move(local));
+    }
+    arrivals.resize(tiles.size());
+}
+
+DomainDecomposition::~DomainDecomposition() = default;
+
+int DomainDecomposition::getTileAt(float x, float y) const {
+    const int column = std::min(std::max(static_cast<int>(x / tile_width), 0), columns - 1);
+    const int row = std::min(std::max(static_cast<int>(y / tile_height), 0), rows - 1);
+    return row * columns + column;
+}
+
+std::size_t DomainDecomposition::getLocalParticleCount() const {
+    std::size_t count = 0;
+    for (const LocalTile& local : tiles) {
+        count += local.simulation->getParticleCount();
+    }
+    return count;
+}
+
+void DomainDecomposition::update(float delta_time) {
+    PROFILE_ZONE("DomainDecomposition::update");
+
+    last_frame_timings = FrameTimings();
+    for (LocalTile& local : tiles) {
+        local.simulation->update(delta_time);
+        const FrameTimings& timings = local.simulation->getLastFrameTimings();
+        last_frame_timings.matrix_ms += timings.matrix_ms;
+        last_frame_timings.obstacles_ms += timings.obstacles_ms;
+        last_frame_timings.particles_ms += timings.particles_ms;
+    }
+
+    const auto migration_start = std::chrono::steady_clock::now();
+    migrate();
+    last_migration_ms =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - migration_start).count();
+}
+
+void DomainDecomposition::migrate() {
+    PROFILE_ZONE("DomainDecomposition::migrate");
+
+    // Collect the leavers of every tile, in tile order, into one batch per
+    // destination; remote ones are packed as records for the exchange
+    last_migrations = 0;
+    outgoing_records.clear();
+    for (ParticleStore& batch : arrivals) {
+        batch.clear();
+    }
+    for (LocalTile& local : tiles) {
+        const TileBounds& own = bounds[local.tile];
+        local.leaving.clear();
+        local.simulation->extractParticlesOutside(own.min_x, own.min_y, own.max_x, own.max_y, local.leaving);
+        last_migrations += local.leaving.size();
+
+        for (std::size_t i = 0; i < local.leaving.size(); ++i) {
+            const int destination = getTileAt(local.leaving.pos_x[i], local.leaving.pos_y[i]);
+            if (local_index[destination] >= 0) {
+                arrivals[local_index[destination]].append(local.leaving, i);
+            } else {
+                outgoing_records.push_back(makeRecord(local.leaving, i, destination));
+            }
+        }
+    }
+
+    exchangeRemote();
+    for (const MigrationRecord& record : incoming_records) {
+        appendRecord(arrivals[local_index[record.tile]], record);
+    }
+
+    for (std::size_t local = 0; local < tiles.size(); ++local) {
+        if (!arrivals[local].empty()) {
+            tiles[local].simulation->insertParticles(arrivals[local]);
+        }
+    }
+}
+
+DomainDecomposition::MigrationRecord DomainDecomposition::makeRecord(const ParticleStore& particles,
+                                                                     std::size_t i, int tile) {
+    MigrationRecord record;
+    record.id = particles.id[i];
+    record.tile = static_cast<uint32_t>(tile);
+    record.pos_x = particles.pos_x[i];
+    record.pos_y = particles.pos_y[i];
+    record.vel_x = particles.vel_x[i];
+    record.vel_y = particles.vel_y[i];
+    record.radius = particles.radius[i];
+    record.color = particles.color[i];
+    return record;
+}
+
+void DomainDecomposition::appendRecord(ParticleStore& particles, const MigrationRecord& record) {
+    particles.pos_x.push_back(record.pos_x);
+    particles.pos_y.push_back(record.pos_y);
+    particles.vel_x.push_back(record.vel_x);
+    particles.vel_y.push_back(record.vel_y);
+    particles.radius.push_back(record.radius);
+    particles.color.push_back(record.color);
+    particles.id.push_back(record.id);
+}
+
+#if defined(BROWNIAN_HAS_MPI)
+
+namespace {
+
+// Byte counts and displacements of one all-to-all, per rank
+struct ExchangeLayout {
+    std::vector<int> counts;
+    std::vector<int> offsets;
+
+    int finish() {
+        offsets.assign(counts.size(), 0);
+        int total = 0;
+        for (std::size_t rank = 0; rank < counts.size(); ++rank) {
+            offsets[rank] = total;
+            total += counts[rank];
+        }
+        return total;
+    }
+};
+
+} // namespace
+
+void DomainDecomposition::exchangeRemote() {
+    incoming_records.clear();
+    const int ranks = rank_count;
+    if (ranks == 1) {
+        return;
+    }
+
+    // Records grouped by destination rank; sizes first, then the payload
+    std::stable_sort(outgoing_records.begin(), outgoing_records.end(),
+                     [this](const MigrationRecord& a, const MigrationRecord& b) {
+                         return ownerRank(a.tile) < ownerRank(b.tile);
+                     });
+    ExchangeLayout send, receive;
+    send.counts.assign(ranks, 0);
+    for (const MigrationRecord& record : outgoing_records) {
+        send.counts[ownerRank(record.tile)] += static_cast<int>(sizeof(MigrationRecord));
+    }
+    send.finish();
+    receive.counts.assign(ranks, 0);
+    MPI_Alltoall(send.counts.data(), 1, MPI_INT, receive.counts.data(), 1, MPI_INT, MPI_COMM_WORLD);
+    const int received_bytes = receive.finish();
+
+    incoming_records.resize(static_cast<std::size_t>(received_bytes) / sizeof(MigrationRecord));
+    MPI_Alltoallv(outgoing_records.data(), send.counts.data(), send.offsets.data(), MPI_BYTE,
+                  incoming_records.data(), receive.counts.data(), receive.offsets.data(), MPI_BYTE,
+                  MPI_COMM_WORLD);
+}
+
+void DomainDecomposition::gatherParticles(ParticleStore& out) const {
+    std::vector<MigrationRecord> local;
+    local.reserve(getLocalParticleCount());
+    for (const LocalTile& tile : tiles) {
+        const ParticleStore& particles = tile.simulation->getParticles();
+        for (std::size_t i = 0; i < particles.size(); ++i) {
+            local.push_back(makeRecord(particles, i, tile.tile));
+        }
+    }
+
+    const int ranks = rank_count;
+    ExchangeLayout layout;
+    layout.counts.assign(ranks, 0);
+    const int local_bytes = static_cast<int>(local.size() * sizeof(MigrationRecord));
+    MPI_Gather(&local_bytes, 1, MPI_INT, layout.counts.data(), 1, MPI_INT, 0, MPI_COMM_WORLD);
+    const int total_bytes = layout.finish();
+
+    std::vector<MigrationRecord> all(rank == 0 ? static_cast<std::size_t>(total_bytes) / sizeof(MigrationRecord) : 0);
+    MPI_Gatherv(local.data(), local_bytes, MPI_BYTE, all.data(), layout.counts.data(), layout.offsets.data(),
+                MPI_BYTE, 0, MPI_COMM_WORLD);
+
+    out.clear();
+    std::sort(all.begin(), all.end(), [](const MigrationRecord& a, const MigrationRecord& b) { return a.id < b.id; });
+    out.reserve(all.size());
+    for (const MigrationRecord& record : all) {
+        appendRecord(out, record);
+    }
+}
+
+void DomainDecomposition::initializeRuntime(int* argc, char*** argv) {
+    int initialized = 0;
+    MPI_Initialized(&initialized);
+    if (!initialized) {
+        MPI_Init(argc, argv);
+    }
+}
+
+void DomainDecomposition::finalizeRuntime() {
+    int finalized = 0;
+    MPI_Finalized(&finalized);
+    if (!finalized) {
+        MPI_Finalize();
+    }
+}
+
+int DomainDecomposition::getRank() {
+    int initialized = 0;
+    MPI_Initialized(&initialized);
+    int rank = 0;
+    if (initialized) {
+        MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    }
+    return rank;
+}
+
+int DomainDecomposition::getRankCount() {
+    int initialized = 0;
+    MPI_Initialized(&initialized);
+    int size = 1;
+    if (initialized) {
+        MPI_Comm_size(MPI_COMM_WORLD, &size);
+    }
+    return size;
+}
+
+bool DomainDecomposition::hasMpi() {
+    return true;
+}
+
+#else
+
+// Single process: every tile is local, nothing crosses a process boundary
+
+void DomainDecomposition::exchangeRemote() {
+    incoming_records.clear();
+}
+
+void DomainDecomposition::gatherParticles(ParticleStore& out) const {
+    std::vector<std::pair<uint32_t, std::pair<int, std::size_t>>> order;
+    order.reserve(getLocalParticleCount());
+    for (int local = 0; local < getLocalTileCount(); ++local) {
+        const ParticleStore& particles = tiles[local].simulation->getParticles();
+        for (std::size_t i = 0; i < particles.size(); ++i) {
+            order.push_back({particles.id[i], {local, i}});
+        }
+    }
+    std::sort(order.begin(), order.end());
+
+    out.clear();
+    out.reserve(order.size());
+    for (const auto& entry : order) {
+        out.append(tiles[entry.second.first].simulation->getParticles(), entry.second.second);
+    }
+}
+
+void DomainDecomposition::initializeRuntime(int*, char***) {
+}
+
+void DomainDecomposition::finalizeRuntime() {
+}
+
+int DomainDecomposition::getRank() {
+    return 0;
+}
+
+int DomainDecomposition::getRankCount() {
+    return 1;
+}
+
+bool DomainDecomposition::hasMpi() {
+    return false;
+}
+
+#endif
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "simulation.h"
+
+// Part of the world owned by one tile: [min_x, max_x) x [min_y, max_y)
+struct TileBounds {
+    float min_x;
+    float min_y;
+    float max_x;
+    float max_y;
+};
+
+// Splits the world into a columns x rows grid of tiles, each simulated by its
+// own BrownianSimulation holding only the particles whose centers are inside.
+//
+// After every step the particles that left their tile migrate to the owner of
+// their new position, in one batch per destination tile. The lookup runs
+// after the boundary policy, so with --boundary periodic a particle crossing
+// the world's edge lands in the tile on the opposite side.
+//
+// Obstacles are replicated: every tile builds the same ObstacleSystem from the
+// shared seed and moves it identically, so a particle near a tile edge sees
+// the same obstacles as in a single simulation. Noise is keyed by particle id,
+// so a decomposed run follows the same trajectories as one simulation (bit
+// for bit on the AVX2 kernels; see gatherParticles()). Particle interactions
+// are not supported: they would need ghost particles from neighboring tiles.
+//
+// Without MPI every tile lives in this process and tiles step one after the
+// other, each using the whole pool. Built with BROWNIAN_HAS_MPI, rank r owns
+// the tiles t with t % ranks == r, and batches for other ranks go through one
+// MPI_Alltoallv per step.
+class DomainDecomposition {
+public:
+    // Every local tile starts from the same particle_count particles a single
+    // BrownianSimulation with this seed would create, keeping its own
+    DomainDecomposition(int width, int height, int particle_count, uint64_t seed, int obstacle_count,
+                        int tile_columns, int tile_rows);
+    ~DomainDecomposition();
+
+    DomainDecomposition(const DomainDecomposition&) = delete;
+    DomainDecomposition& operator=(const DomainDecomposition&) = delete;
+
+    // Step every local tile, then migrate the particles that left them
+    void update(float delta_time);
+
+    int getColumns() const { return columns; }
+    int getRows() const { return rows; }
+    int getTileCount() const { return columns * rows; }
+    // Tiles simulated by this process, in increasing tile order
+    int getLocalTileCount() const { return static_cast<int>(tiles.size()); }
+    BrownianSimulation& getLocalTile(int local) { return *tiles[local].simulation; }
+    const BrownianSimulation& getLocalTile(int local) const { return *tiles[local].simulation; }
+    int getLocalTileIndex(int local) const { return tiles[local].tile; }
+    const TileBounds& getTileBounds(int tile) const { return bounds[tile]; }
+    // Tile owning a center at (x, y); positions outside the world go to the nearest edge tile
+    int getTileAt(float x, float y) const;
+
+    std::size_t getLocalParticleCount() const;
+    // Particles this process sent to another tile in the last update()
+    std::size_t getLastMigrationCount() const { return last_migrations; }
+    // Phase times of the last update(), summed over the local tiles
+    const FrameTimings& getLastFrameTimings() const { return last_frame_timings; }
+    double getLastMigrationMs() const { return last_migration_ms; }
+
+    // Every particle of every tile, sorted by id: the order a single
+    // simulation keeps them in, so BenchmarkReport::hashParticles() of the
+    // result matches an undecomposed run. Collective with MPI; only rank 0
+    // gets the particles, the others an empty store.
+    void gatherParticles(ParticleStore& out) const;
+
+    // MPI_Init / MPI_Finalize with BROWNIAN_HAS_MPI, nothing otherwise
+    static void initializeRuntime(int* argc, char*** argv);
+    static void finalizeRuntime();
+    static int getRank();
+    static int getRankCount();
+    static bool hasMpi();
+
+private:
+    struct LocalTile {
+        int tile;
+        std::unique_ptr<BrownianSimulation> simulation;
+        ParticleStore leaving; // Scratch for the particles that left this step
+    };
+
+    // One particle in flight between ranks (and in gatherParticles())
+    struct MigrationRecord {
+        uint32_t id;
+        uint32_t tile; // Destination
+        float pos_x;
+        float pos_y;
+        float vel_x;
+        float vel_y;
+        float radius;
+        Color color;
+    };
+
+    int columns;
+    int rows;
+    int rank;       // This process and the process count, fixed at construction
+    int rank_count;
+    float tile_width;
+    float tile_height;
+    std::vector<TileBounds> bounds;
+    std::vector<LocalTile> tiles;
+    std::vector<int> local_index; // Per tile: index into tiles, or -1 if another rank owns it
+    std::vector<ParticleStore> arrivals; // Per local tile, reused every step
+    std::vector<MigrationRecord> outgoing_records;
+    std::vector<MigrationRecord> incoming_records;
+
+    std::size_t last_migrations;
+    double last_migration_ms;
+    FrameTimings last_frame_timings;
+
+    void migrate();
+    void exchangeRemote();
+    int ownerRank(int tile) const { return tile % rank_count; }
+    static MigrationRecord makeRecord(const ParticleStore& particles, std::size_t i, int tile);
+    static void appendRecord(ParticleStore& particles, const MigrationRecord& record);
+};
@@ -0,0 +1,229 @@
+#include "ensemble_runner.h"
+#include "benchmark_report.h"
+#include "simulation.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <utility>
+
+namespace {
+
+bool parseCount(const std::string& text, uint64_t min_value, uint64_t max_value, uint64_t& value) {
+    char* end = nullptr;
+    const unsigned long long parsed = std::strtoull(text.c_str(), &end, 0);
+    if (text.empty() || *end != '\0' || text[0] == '-' || parsed < min_value || parsed > max_value) {
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+bool parseReal(const std::string& text, float& value) {
+    char* end = nullptr;
+    const float parsed = std::strtof(text.c_str(), &end);
+    if (text.empty() || *end != '\0' || !std::isfinite(parsed)) {
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+bool parseSwitch(const std::string& text, bool& value) {
+    if (text == "1" || text == "true" || text == "on") {
+        value = true;
+    } else if (text == "0" || text == "false" || text == "off") {
+        value = false;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Apply one key=value setting; false if the key or the value is unknown
+bool applySetting(const std::string& key, const std::string& text, EnsembleMember& member) {
+    uint64_t value = 0;
+    if (key == "seed") {
+        return parseCount(text, 0, UINT64_MAX, member.seed);
+    } else if (key == "particles") {
+        if (!parseCount(text, 0, 10000000, value)) {
+            return false;
+        }
+        member.particles = static_cast<int>(value);
+    } else if (key == "obstacles") {
+        if (!parseCount(text, 0, 1000, value)) {
+            return false;
+        }
+        member.obstacles = static_cast<int>(value);
+    } else if (key == "matrix") {
+        if (!parseCount(text, 1, 4096, value)) {
+            return false;
+        }
+        member.matrix_size = static_cast<int>(value);
+    } else if (key == "sort-every") {
+        if (!parseCount(text, 0, 100000000, value)) {
+            return false;
+        }
+        member.sort_interval = static_cast<int>(value);
+    } else if (key == "dt") {
+        return parseReal(text, member.delta_time) && member.delta_time > 0.0f && member.delta_time <= 1.0f;
+    } else if (key == "stiffness") {
+        return parseReal(text, member.stiffness) && member.stiffness >= 0.0f;
+    } else if (key == "lazy-matrix") {
+        return parseSwitch(text, member.lazy_matrix);
+    } else if (key == "interactions") {
+        return parseSwitch(text, member.interactions);
+    } else if (key == "color-jitter") {
+        return parseSwitch(text, member.color_jitter);
+    } else if (key == "boundary") {
+        if (text == "reflect") {
+            member.boundary = BoundaryMode::Reflect;
+        } else if (text == "periodic") {
+            member.boundary = BoundaryMode::Periodic;
+        } else if (text == "absorb") {
+            member.boundary = BoundaryMode::Absorb;
+        } else {
+            return false;
+        }
+    } else if (key == "noise") {
+        if (text == "uniform") {
+            member.noise = NoiseMode::Uniform;
+        } else if (text == "gaussian") {
+            member.noise = NoiseMode::Gaussian;
+        } else {
+            return false;
+        }
+    } else {
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+EnsembleRunner::EnsembleRunner(int world_width, int world_height, int frames)
+    : world_width(world_width), world_height(world_height), frames(frames), next_output(0), completed(0) {
+}
+
+bool EnsembleRunner::parseSweep(std::istream& in, const EnsembleMember& base, std::vector<EnsembleMember>& members,
+                                std::string& error) {
+    std::string line;
+    for (int line_number = 1; std::getline(in, line); ++line_number) {
+        const std::size_t comment = line.find('#');
+        if (comment != std::string::npos) {
+            line.erase(comment);
+        }
+        std::istringstream tokens(line);
+        std::string token;
+        EnsembleMember member = base;
+        member.seed = base.seed + members.size();
+        bool any = false;
+        while (tokens >> token) {
+            const std::size_t equals = token.find('=');
+            if (equals == std::string::npos ||
+                !applySetting(token.substr(0, equals), token.substr(equals + 1), member)) {
+                error = "line " + std::to_string(line_number) + ": bad setting '" + token + "'";
+                return false;
+            }
+            any = true;
+        }
+        if (any) {
+            members.push_back(member);
+        }
+    }
+    return true;
+}
+
+std::string EnsembleRunner::runMember(std::size_t index, const EnsembleMember& member,
+                                      const volatile std::sig_atomic_t* keep_running, bool& ran_to_end) const {
+    ran_to_end = false;
+    if (keep_running && !*keep_running) {
+        return std::string();
+    }
+
+    // No thread pool: the member runs on this worker, next to the others
+    BrownianSimulation simulation(world_width, world_height, member.particles, member.seed, member.obstacles);
+    simulation.setMatrixSize(member.matrix_size);
+    simulation.setLazyMatrixProduct(member.lazy_matrix);
+    simulation.setParticleInteractions(member.interactions);
+    simulation.getParticleInteractions().setStiffness(member.stiffness);
+    simulation.setBoundaryMode(member.boundary);
+    simulation.setNoiseMode(member.noise);
+    simulation.setColorJitter(member.color_jitter);
+    simulation.setSortInterval(member.sort_interval);
+
+    using Clock = std::chrono::steady_clock;
+    const auto start = Clock::now();
+    double max_frame_ms = 0.0;
+    int frames_run = 0;
+    while (frames_run < frames && (!keep_running || *keep_running)) {
+        const auto frame_start = Clock::now();
+        simulation.update(member.delta_time);
+        const double frame_ms = std::chrono::duration<double, std::milli>(Clock::now() - frame_start).count();
+        max_frame_ms = std::max(max_frame_ms, frame_ms);
+        ++frames_run;
+    }
+    const double wall_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    ran_to_end = frames_run == frames;
+
+    const double particle_updates = wall_ms > 0.0 ?
+        static_cast<double>(simulation.getParticleCount()) * frames_run / (wall_ms * 1e-3) : 0.0;
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(4)
+        << "{\"member\": " << index
+        << ", \"seed\": " << member.seed
+        << ", \"particles\": " << member.particles
+        << ", \"obstacles\": " << simulation.getObstacleCount()
+        << ", \"matrix_size\": " << member.matrix_size
+        << ", \"lazy_matrix\": " << (member.lazy_matrix ? "true" : "false")
+        << ", \"dt\": " << member.delta_time
+        << ", \"interactions\": " << (member.interactions ? "true" : "false")
+        << ", \"stiffness\": " << member.stiffness
+        << ", \"boundary\": \"" << MotionPolicy::boundaryName(member.boundary) << "\""
+        << ", \"noise\": \"" << MotionPolicy::noiseName(member.noise) << "\""
+        << ", \"color_jitter\": " << (member.color_jitter ? "true" : "false")
+        << ", \"sort_every\": " << member.sort_interval
+        << ", \"frames\": " << frames_run
+        << ", \"completed\": " << (ran_to_end ? "true" : "false")
+        << ", \"wall_ms\": " << wall_ms
+        << ", \"frame_ms_mean\": " << (frames_run > 0 ? wall_ms / frames_run : 0.0)
+        << ", \"frame_ms_max\": " << max_frame_ms
+        << ", \"particle_updates_per_s\": " << std::setprecision(0) << particle_updates
+        << ", \"state_hash\": \"" << std::hex << std::setw(16) << std::setfill('0')
+        << BenchmarkReport::hashParticles(simulation.getParticles()) << "\"}\n";
+    return out.str();
+}
+
+void EnsembleRunner::submit(std::size_t index, std::string line, bool ran_to_end, std::ostream& out) {
+    std::lock_guard<std::mutex> lock(output_mutex);
+    pending[index] = std::move(line);
+    finished[index] = 1;
+    completed += ran_to_end ? 1 : 0;
+    // Write every result whose predecessors are all out, then free it
+    while (next_output < finished.size() && finished[next_output]) {
+        out << pending[next_output];
+        std::string().swap(pending[next_output]);
+        ++next_output;
+    }
+    out.flush();
+}
+
+std::size_t EnsembleRunner::run(const std::vector<EnsembleMember>& members, ThreadPool& pool, std::ostream& out,
+                                const volatile std::sig_atomic_t* keep_running) {
+    pending.assign(members.size(), std::string());
+    finished.assign(members.size(), 0);
+    next_output = 0;
+    completed = 0;
+
+    pool.parallelForEach(members.size(), [&](std::size_t index, int) {
+        bool ran_to_end = false;
+        std::string line = runMember(index, members[index], keep_running, ran_to_end);
+        submit(index, std::move(line), ran_to_end, out);
+    });
+    return completed;
+}
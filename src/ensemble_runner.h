@@ -0,0 +1,74 @@
+#pragma once
+
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "motion_policies.h"
+#include "particle_interactions.h"
+
+class ThreadPool;
+
+// Setup of one ensemble member: its own seed and parameters
+struct EnsembleMember {
+    uint64_t seed = 0;
+    int particles = 10000;
+    int obstacles = 4;
+    int matrix_size = 280;
+    bool lazy_matrix = false;
+    float delta_time = 0.016f;
+    bool interactions = false;
+    float stiffness = ParticleInteractions::DEFAULT_STIFFNESS;
+    BoundaryMode boundary = BoundaryMode::Reflect;
+    NoiseMode noise = NoiseMode::Uniform;
+    bool color_jitter = true;
+    int sort_interval = 0;
+};
+
+// Runs many independent simulations of the same length in one process, for
+// parameter sweeps: process start, kernel dispatch and the worker pool are
+// paid once instead of once per run.
+//
+// Members are the pool's tasks. Each worker builds a member, steps it through
+// every frame on its own thread and moves on to the next unclaimed one, so
+// hundreds of small runs keep every core busy the way one large run does,
+// without the per-frame fork/join a single run pays. A member's result,
+// one JSON object per line, is streamed in member order as soon as every
+// earlier member has finished.
+class EnsembleRunner {
+public:
+    EnsembleRunner(int world_width, int world_height, int frames);
+
+    // Members from a sweep file: one member per line of space-separated
+    // key=value settings over base (seed, particles, obstacles, matrix,
+    // lazy-matrix, dt, interactions, stiffness, boundary, noise, color-jitter, sort-every).
+    // A line without seed= gets base.seed plus its member index. Blank lines
+    // and # comments are skipped. False with error set on a bad line.
+    static bool parseSweep(std::istream& in, const EnsembleMember& base, std::vector<EnsembleMember>& members,
+                           std::string& error);
+
+    // Run every member on the pool and stream the results to out; returns
+    // the number of members that ran to the end (fewer when stopped)
+    std::size_t run(const std::vector<EnsembleMember>& members, ThreadPool& pool, std::ostream& out,
+                    const volatile std::sig_atomic_t* keep_running = nullptr);
+
+private:
+    int world_width;
+    int world_height;
+    int frames;
+
+    // Results waiting for an earlier member, guarded by output_mutex
+    std::mutex output_mutex;
+    std::vector<std::string> pending;
+    std::vector<char> finished;
+    std::size_t next_output;
+    std::size_t completed;
+
+    // One JSON line; empty when stopped before the member started
+    std::string runMember(std::size_t index, const EnsembleMember& member,
+                          const volatile std::sig_atomic_t* keep_running, bool& ran_to_end) const;
+    void submit(std::size_t index, std::string line, bool ran_to_end, std::ostream& out);
+};
@@ -0,0 +1,22 @@
+#include "fixed_timestep.h"
+#include <algorithm>
+
+FixedTimestep::FixedTimestep(float step, int max_steps)
+    : step(step > 0.0f ? step : DEFAULT_STEP),
+      max_steps(std::max(max_steps, 1)),
+      accumulator(0.0),
+      dropped_steps(0) {
+}
+
+int FixedTimestep::advance(float elapsed_seconds) {
+    accumulator += std::clamp(elapsed_seconds, 0.0f, MAX_ELAPSED);
+
+    int steps = static_cast<int>(accumulator / step);
+    if (steps > max_steps) {
+        dropped_steps += steps - max_steps;
+        accumulator -= static_cast<double>(steps - max_steps) * step;
+        steps = max_steps;
+    }
+    accumulator -= static_cast<double>(steps) * step;
+    return steps;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+
+// Fixed-step accumulator for real-time loops: wall time goes in, a whole
+// number of simulation steps of the same dt comes out, and the remainder
+// carries over to the next call. getAlpha() is how far the loop is into the
+// next step, for interpolating between the last two states.
+//
+// When the simulation cannot keep up, at most max_steps run per call and the
+// rest of the backlog is dropped (the run slows down instead of spiraling).
+class FixedTimestep {
+public:
+    static constexpr float DEFAULT_STEP = 1.0f / 60.0f;
+    static constexpr int DEFAULT_MAX_STEPS = 4;
+    static constexpr float MAX_ELAPSED = 0.25f; // Longer gaps (a dragged window) are cut to this
+
+    explicit FixedTimestep(float step = DEFAULT_STEP, int max_steps = DEFAULT_MAX_STEPS);
+
+    // Add elapsed wall time; returns the number of steps to run now
+    int advance(float elapsed_seconds);
+    void reset() { accumulator = 0.0; }
+
+    float getStep() const { return step; }
+    int getMaxSteps() const { return max_steps; }
+    float getAlpha() const { return static_cast<float>(accumulator / step); }
+    uint64_t getDroppedSteps() const { return dropped_steps; }
+
+private:
+    float step;
+    int max_steps;
+    double accumulator; // Seconds not yet simulated, < step after advance()
+    uint64_t dropped_steps;
+};
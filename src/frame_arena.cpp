@@ -0,0 +1,86 @@
+#include "frame_arena.h"
+#include <algorithm>
+
+namespace {
+
+std::size_t alignUp(std::size_t value) {
+    return (value + FrameArena::ALIGNMENT - 1) / FrameArena::ALIGNMENT * FrameArena::ALIGNMENT;
+}
+
+thread_local FrameArena* bound_arena = nullptr;
+
+} // namespace
+
+void* FrameArena::allocate(std::size_t bytes) {
+    bytes = alignUp(std::max<std::size_t>(bytes, 1));
+
+    // Current block first, then any spill block left from an earlier scope
+    while (current_block < blocks.size()) {
+        AlignedVector<unsigned char>& block = blocks[current_block];
+        if (offset + bytes <= block.size()) {
+            void* result = block.data() + offset;
+            offset += bytes;
+            return result;
+        }
+        ++current_block;
+        offset = 0;
+    }
+
+    // Out of space: spill into a new block at least as big as everything so far
+    blocks.emplace_back(std::max({bytes, getCapacity(), MIN_BLOCK_SIZE}));
+    current_block = blocks.size() - 1;
+    offset = bytes;
+    return blocks.back().data();
+}
+
+void FrameArena::reset() {
+    const std::size_t wanted = std::max(getCapacity(), alignUp(reserved_bytes));
+    if (blocks.size() > 1 || (blocks.empty() ? wanted > 0 : blocks.front().size() < wanted)) {
+        blocks.clear();
+        blocks.emplace_back(wanted);
+    }
+    current_block = 0;
+    offset = 0;
+}
+
+void FrameArena::reserve(std::size_t bytes) {
+    reserved_bytes = std::max(reserved_bytes, bytes);
+    if (getUsed() == 0) {
+        reset();
+    }
+}
+
+std::size_t FrameArena::getCapacity() const {
+    std::size_t capacity = 0;
+    for (const auto& block : blocks) {
+        capacity += block.size();
+    }
+    return capacity;
+}
+
+std::size_t FrameArena::getUsed() const {
+    std::size_t used = offset;
+    for (std::size_t block = 0; block < current_block && block < blocks.size(); ++block) {
+        used += blocks[block].size();
+    }
+    return used;
+}
+
+void FrameArena::release(std::size_t block, std::size_t block_offset) {
+    // Back to empty: a good moment to merge spill blocks
+    if (block == 0 && block_offset == 0) {
+        reset();
+        return;
+    }
+    current_block = block;
+    offset = block_offset;
+}
+
+FrameArena& FrameArena::forThread() {
+    static thread_local FrameArena own_arena;
+    return bound_arena ? *bound_arena : own_arena;
+}
+
+void FrameArena::bindThread(FrameArena* arena) {
+    bound_arena = arena;
+}
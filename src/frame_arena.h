@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+#include "aligned_allocator.h"
+
+// Bump allocator for per-frame temporaries.
+// allocate() hands out 64-byte aligned slices of one large block and reset()
+// releases them all at once. When a frame needs more than the block holds, the
+// extra requests spill into added blocks, and the next reset() merges everything
+// into one block of the combined size, so a steady-state frame never allocates.
+// Not thread-safe: use one arena per thread (see forThread()).
+class FrameArena {
+public:
+    static constexpr std::size_t ALIGNMENT = 64;
+    static constexpr std::size_t MIN_BLOCK_SIZE = 64 * 1024;
+
+    FrameArena() : current_block(0), offset(0), reserved_bytes(0) {}
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    // Uninitialized storage for count objects; valid until reset() or the
+    // enclosing Marker goes out of scope
+    template <typename T>
+    T* allocateArray(std::size_t count) {
+        static_assert(std::is_trivially_destructible<T>::value, "FrameArena never runs destructors");
+        static_assert(alignof(T) <= ALIGNMENT, "FrameArena alignment is 64 bytes");
+        return static_cast<T*>(allocate(count * sizeof(T)));
+    }
+
+    void* allocate(std::size_t bytes);
+
+    // Release everything; spilled blocks are merged into one
+    void reset();
+
+    // Make sure a frame of this many bytes fits in a single block. Applied now
+    // when the arena is empty, otherwise at the next reset().
+    void reserve(std::size_t bytes);
+
+    std::size_t getCapacity() const;
+    std::size_t getUsed() const;
+
+    // Scoped allocation: everything allocated after the marker is released
+    // when it goes out of scope
+    class Marker {
+    public:
+        explicit Marker(FrameArena& arena)
+            : arena(arena), block(arena.current_block), offset(arena.offset) {}
+        ~Marker() { arena.release(block, offset); }
+
+        Marker(const Marker&) = delete;
+        Marker& operator=(const Marker&) = delete;
+
+    private:
+        FrameArena& arena;
+        std::size_t block;
+        std::size_t offset;
+    };
+
+    // Scratch arena of the calling thread: the one bound with bindThread() (a
+    // pool worker's), or a thread-local one
+    static FrameArena& forThread();
+    static void bindThread(FrameArena* arena);
+
+private:
+    std::vector<AlignedVector<unsigned char>> blocks;
+    std::size_t current_block; // Block the next allocation comes from
+    std::size_t offset;        // Bytes used in the current block
+    std::size_t reserved_bytes;
+
+    void release(std::size_t block, std::size_t block_offset);
+};
@@ -0,0 +1,103 @@
+#include "frame_stats.h"
+#include "simulation.h"
+#include <algorithm>
+#include <cmath>
+
+FrameStats::FrameStats(double publish_seconds)
+    : ring(),
+      histogram(),
+      head(0),
+      window_frames(0),
+      window_ns(0),
+      frames(0),
+      total_ns(0),
+      phase_ms(),
+      publish_ns(static_cast<uint64_t>(std::max(publish_seconds, 0.0) * 1e9)),
+      unpublished_ns(0) {
+}
+
+std::size_t FrameStats::slotOf(uint64_t nanoseconds) {
+    const uint64_t value = std::min(nanoseconds, (uint64_t(1) << MAX_VALUE_BITS) - 1);
+    // Shift the value down until it fits the sub-buckets; each octave above
+    // the exact range then takes HALF_BUCKETS slots
+    int shift = 0;
+    while ((value >> shift) >= 2 * HALF_BUCKETS) {
+        ++shift;
+    }
+    return static_cast<std::size_t>(shift * HALF_BUCKETS + (value >> shift));
+}
+
+uint64_t FrameStats::highestValueOf(std::size_t slot) {
+    if (slot < 2 * HALF_BUCKETS) {
+        return slot;
+    }
+    const int shift = static_cast<int>(slot / HALF_BUCKETS) - 1;
+    const uint64_t lowest = (slot - shift * HALF_BUCKETS) << shift;
+    return lowest + (uint64_t(1) << shift) - 1;
+}
+
+void FrameStats::addFrame(std::chrono::nanoseconds frame_time) {
+    const uint64_t ns = static_cast<uint64_t>(std::max<int64_t>(frame_time.count(), 0));
+    if (window_frames == WINDOW) {
+        --histogram[slotOf(ring[head])];
+        window_ns -= ring[head];
+    } else {
+        ++window_frames;
+    }
+    ring[head] = ns;
+    ++histogram[slotOf(ns)];
+    head = head + 1 == WINDOW ? 0 : head + 1;
+    window_ns += ns;
+    ++frames;
+    total_ns += ns;
+
+    unpublished_ns += ns;
+    if (unpublished_ns >= publish_ns) {
+        publish();
+    }
+}
+
+void FrameStats::addFrame(std::chrono::nanoseconds frame_time, const FrameTimings& phases) {
+    phase_ms[0] += phases.matrix_ms;
+    phase_ms[1] += phases.obstacles_ms;
+    phase_ms[2] += phases.particles_ms;
+    addFrame(frame_time);
+}
+
+uint64_t FrameStats::percentile(double fraction, uint64_t window_max) const {
+    // Smallest bucket holding at least this share of the window; its highest
+    // value, so a percentile is never under-reported
+    const uint64_t rank = std::max<uint64_t>(
+        static_cast<uint64_t>(std::ceil(fraction * static_cast<double>(window_frames))), 1);
+    uint64_t seen = 0;
+    for (std::size_t slot = 0; slot < SLOTS; ++slot) {
+        seen += histogram[slot];
+        if (seen >= rank) {
+            return std::min(highestValueOf(slot), window_max);
+        }
+    }
+    return window_max;
+}
+
+void FrameStats::publish() {
+    unpublished_ns = 0;
+
+    FrameStatsSnapshot snapshot;
+    snapshot.frames = frames;
+    snapshot.window_frames = window_frames;
+    snapshot.total_seconds = total_ns * 1e-9;
+    snapshot.matrix_seconds = phase_ms[0] * 1e-3;
+    snapshot.obstacles_seconds = phase_ms[1] * 1e-3;
+    snapshot.particles_seconds = phase_ms[2] * 1e-3;
+    if (window_frames > 0) {
+        const uint64_t window_max = *std::max_element(ring, ring + window_frames);
+        snapshot.fps = window_ns > 0 ? window_frames * 1e9 / window_ns : 0.0;
+        snapshot.mean_ms = window_ns * 1e-6 / window_frames;
+        snapshot.p50_ms = percentile(0.5, window_max) * 1e-6;
+        snapshot.p90_ms = percentile(0.9, window_max) * 1e-6;
+        snapshot.p99_ms = percentile(0.99, window_max) * 1e-6;
+        snapshot.p999_ms = percentile(0.999, window_max) * 1e-6;
+        snapshot.max_ms = window_max * 1e-6;
+    }
+    published.store(snapshot);
+}
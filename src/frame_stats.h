@@ -0,0 +1,77 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include "seqlock.h"
+
+struct FrameTimings;
+
+// What FrameStats readers see: rate and percentiles of the recent window,
+// plus run totals that only grow (for scrapers computing rates themselves)
+struct FrameStatsSnapshot {
+    uint64_t frames = 0;        // Frames recorded since the start
+    uint64_t window_frames = 0; // Frames the window figures cover
+    double fps = 0.0;           // window_frames over their summed duration
+    double mean_ms = 0.0;
+    double p50_ms = 0.0;
+    double p90_ms = 0.0;
+    double p99_ms = 0.0;
+    double p999_ms = 0.0;
+    double max_ms = 0.0;
+    double total_seconds = 0.0; // Summed frame time of the whole run
+    double matrix_seconds = 0.0; // Summed update() phases of the whole run
+    double obstacles_seconds = 0.0;
+    double particles_seconds = 0.0;
+};
+
+// Frame time statistics for loops that cannot afford to format them every
+// frame. The owner thread adds each frame's duration to a fixed ring of the
+// last WINDOW frames and to a log-linear (HDR) histogram of the same frames:
+// values share a bucket only within 1/64 of each other, so percentiles cost
+// one walk over a few thousand counters and the ring never allocates.
+//
+// Figures are computed only every publish_seconds of recorded frame time and
+// published through a SeqLock, so getSnapshot() works from any thread (the
+// metrics endpoint, an overlay) without a lock on the frame thread.
+class FrameStats {
+public:
+    static constexpr std::size_t WINDOW = 512;
+    static constexpr double DEFAULT_PUBLISH_SECONDS = 0.25;
+
+    explicit FrameStats(double publish_seconds = DEFAULT_PUBLISH_SECONDS);
+    FrameStats(const FrameStats&) = delete;
+    FrameStats& operator=(const FrameStats&) = delete;
+
+    // Owner thread. The second form also sums update()'s phases.
+    void addFrame(std::chrono::nanoseconds frame_time);
+    void addFrame(std::chrono::nanoseconds frame_time, const FrameTimings& phases);
+    // Recompute and publish now instead of at the next interval
+    void publish();
+
+    // Any thread: the figures as of the last publish
+    FrameStatsSnapshot getSnapshot() const { return published.load(); }
+
+private:
+    static constexpr int SUB_BUCKET_BITS = 7; // 128 exact values, then 64 buckets per octave
+    static constexpr int MAX_VALUE_BITS = 40; // Longer frames (~18 minutes) share the last bucket
+    static constexpr uint64_t HALF_BUCKETS = uint64_t(1) << (SUB_BUCKET_BITS - 1);
+    static constexpr std::size_t SLOTS = (MAX_VALUE_BITS - SUB_BUCKET_BITS + 2) * HALF_BUCKETS;
+
+    static std::size_t slotOf(uint64_t nanoseconds);
+    static uint64_t highestValueOf(std::size_t slot);
+    uint64_t percentile(double fraction, uint64_t window_max) const;
+
+    uint64_t ring[WINDOW];         // Frame times in ns, oldest at head once full
+    uint32_t histogram[SLOTS];     // Counts of the ring's frames per bucket
+    std::size_t head;
+    std::size_t window_frames;
+    uint64_t window_ns;
+    uint64_t frames;
+    uint64_t total_ns;
+    double phase_ms[3];            // Matrix, obstacles, particles
+    uint64_t publish_ns;
+    uint64_t unpublished_ns;       // Frame time since the last publish
+
+    SeqLock<FrameStatsSnapshot> published;
+};
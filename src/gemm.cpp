@@ -0,0 +1,300 @@
+#include "gemm.h"
+#include "simd_config.h"
+#include "frame_arena.h"
+#include <algorithm>
+
+namespace {
+
+using MicrokernelFn = void (*)(int kc, const float* a_panel, const float* b_panel,
+                               float* c, int ldc, bool accumulate);
+
+constexpr int MR = Gemm::MR;
+constexpr int NR = Gemm::NR;
+
+// --- PORTABLE MICROKERNEL (MR x NR, left to the auto-vectorizer) ---
+
+[[maybe_unused]]
+void microkernelPortable(int kc, const float* a_panel, const float* b_panel,
+                         float* c, int ldc, bool accumulate) {
+    float acc[MR][NR] = {};
+
+    for (int k = 0; k < kc; ++k) {
+        const float* a = a_panel + k * MR;
+        const float* b = b_panel + k * NR;
+        for (int r = 0; r < MR; ++r) {
+            for (int col = 0; col < NR; ++col) {
+                acc[r][col] += a[r] * b[col];
+            }
+        }
+    }
+
+    for (int r = 0; r < MR; ++r) {
+        float* c_row = c + r * ldc;
+        for (int col = 0; col < NR; ++col) {
+            c_row[col] = accumulate ? c_row[col] + acc[r][col] : acc[r][col];
+        }
+    }
+}
+
+// --- AVX2 FMA MICROKERNEL (8x8: one ymm accumulator per row of C) ---
+#if defined(HAVE_AVX2_DISPATCH)
+
+SIMD_TARGET_AVX2
+void microkernelAvx2(int kc, const float* a_panel, const float* b_panel,
+                     float* c, int ldc, bool accumulate) {
+    __m256 c0 = _mm256_setzero_ps();
+    __m256 c1 = _mm256_setzero_ps();
+    __m256 c2 = _mm256_setzero_ps();
+    __m256 c3 = _mm256_setzero_ps();
+    __m256 c4 = _mm256_setzero_ps();
+    __m256 c5 = _mm256_setzero_ps();
+    __m256 c6 = _mm256_setzero_ps();
+    __m256 c7 = _mm256_setzero_ps();
+
+    const float* a = a_panel;
+    const float* b = b_panel;
+    for (int k = 0; k < kc; ++k) {
+        // Packed B rows are 32-byte aligned: base is 64-byte aligned, panels are kc * 8 floats
+        const __m256 b_row = _mm256_load_ps(b);
+        c0 = _mm256_fmadd_ps(_mm256_broadcast_ss(a + 0), b_row, c0);
+        c1 = _mm256_fmadd_ps(_mm256_broadcast_ss(a + 1), b_row, c1);
+        c2 = _mm256_fmadd_ps(_mm256_broadcast_ss(a + 2), b_row, c2);
+        c3 = _mm256_fmadd_ps(_mm256_broadcast_ss(a + 3), b_row, c3);
+        c4 = _mm256_fmadd_ps(_mm256_broadcast_ss(a + 4), b_row, c4);
+        c5 = _mm256_fmadd_ps(_mm256_broadcast_ss(a + 5), b_row, c5);
+        c6 = _mm256_fmadd_ps(_mm256_broadcast_ss(a + 6), b_row, c6);
+        c7 = _mm256_fmadd_ps(_mm256_broadcast_ss(a + 7), b_row, c7);
+        a += 8;
+        b += 8;
+    }
+
+    if (accumulate) {
+        c0 = _mm256_add_ps(_mm256_loadu_ps(c + 0 * ldc), c0);
+        c1 = _mm256_add_ps(_mm256_loadu_ps(c + 1 * ldc), c1);
+        c2 = _mm256_add_ps(_mm256_loadu_ps(c + 2 * ldc), c2);
+        c3 = _mm256_add_ps(_mm256_loadu_ps(c + 3 * ldc), c3);
+        c4 = _mm256_add_ps(_mm256_loadu_ps(c + 4 * ldc), c4);
+        c5 = _mm256_add_ps(_mm256_loadu_ps(c + 5 * ldc), c5);
+        c6 = _mm256_add_ps(_mm256_loadu_ps(c + 6 * ldc), c6);
+        c7 = _mm256_add_ps(_mm256_loadu_ps(c + 7 * ldc), c7);
+    }
+
+    _mm256_storeu_ps(c + 0 * ldc, c0);
+    _mm256_storeu_ps(c + 1 * ldc, c1);
+    _mm256_storeu_ps(c + 2 * ldc, c2);
+    _mm256_storeu_ps(c + 3 * ldc, c3);
+    _mm256_storeu_ps(c + 4 * ldc, c4);
+    _mm256_storeu_ps(c + 5 * ldc, c5);
+    _mm256_storeu_ps(c + 6 * ldc, c6);
+    _mm256_storeu_ps(c + 7 * ldc, c7);
+}
+
+#endif
+
+// --- AARCH64 NEON MICROKERNEL (8x12: three q accumulators per row of C) ---
+#if defined(USE_NEON) && defined(__aarch64__)
+
+void microkernelNeon(int kc, const float* a_panel, const float* b_panel,
+                     float* c, int ldc, bool accumulate) {
+    float32x4_t acc[MR][3];
+    for (int r = 0; r < MR; ++r) {
+        acc[r][0] = vdupq_n_f32(0.0f);
+        acc[r][1] = vdupq_n_f32(0.0f);
+        acc[r][2] = vdupq_n_f32(0.0f);
+    }
+
+    const float* a = a_panel;
+    const float* b = b_panel;
+    for (int k = 0; k < kc; ++k) {
+        const float32x4_t b0 = vld1q_f32(b);
+        const float32x4_t b1 = vld1q_f32(b + 4);
+        const float32x4_t b2 = vld1q_f32(b + 8);
+        const float32x4_t a_low = vld1q_f32(a);
+        const float32x4_t a_high = vld1q_f32(a + 4);
+
+        // Lane indices must be immediates, so the rows are spelled out
+#define GEMM_NEON_ROW(row, a_vec, lane)                                  \
+        acc[row][0] = vfmaq_laneq_f32(acc[row][0], b0, a_vec, lane);     \
+        acc[row][1] = vfmaq_laneq_f32(acc[row][1], b1, a_vec, lane);     \
+        acc[row][2] = vfmaq_laneq_f32(acc[row][2], b2, a_vec, lane);
+        GEMM_NEON_ROW(0, a_low, 0)
+        GEMM_NEON_ROW(1, a_low, 1)
+        GEMM_NEON_ROW(2, a_low, 2)
+        GEMM_NEON_ROW(3, a_low, 3)
+        GEMM_NEON_ROW(4, a_high, 0)
+        GEMM_NEON_ROW(5, a_high, 1)
+        GEMM_NEON_ROW(6, a_high, 2)
+        GEMM_NEON_ROW(7, a_high, 3)
+#undef GEMM_NEON_ROW
+
+        a += MR;
+        b += NR;
+    }
+
+    for (int r = 0; r < MR; ++r) {
+        float* c_row = c + r * ldc;
+        for (int part = 0; part < 3; ++part) {
+            float32x4_t value = acc[r][part];
+            if (accumulate) {
+                value = vaddq_f32(vld1q_f32(c_row + part * 4), value);
+            }
+            vst1q_f32(c_row + part * 4, value);
+        }
+    }
+}
+
+#endif
+
+// --- RUNTIME DISPATCH ---
+
+struct MicrokernelChoice {
+    MicrokernelFn kernel;
+    const char* name;
+};
+
+MicrokernelChoice selectMicrokernel() {
+#if defined(HAVE_AVX2_DISPATCH)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return {microkernelAvx2, "AVX2 FMA 8x8"};
+    }
+#endif
+#if defined(USE_NEON) && defined(__aarch64__)
+    return {microkernelNeon, "NEON 8x12"};
+#else
+    return {microkernelPortable, NR == 12 ? "portable 8x12" : "portable 8x8"};
+#endif
+}
+
+const MicrokernelChoice& microkernel() {
+    static const MicrokernelChoice choice = selectMicrokernel();
+    return choice;
+}
+
+// --- PACKING ---
+
+// A[0:mc, 0:kc] into MR-tall micro-panels, column by column; short panels are zero-padded
+void packA(ConstMatrixView a, float* packed) {
+    for (int panel = 0; panel < a.rows; panel += MR) {
+        const int rows = std::min(MR, a.rows - panel);
+        for (int k = 0; k < a.cols; ++k) {
+            for (int r = 0; r < rows; ++r) {
+                packed[r] = a(panel + r, k);
+            }
+            for (int r = rows; r < MR; ++r) {
+                packed[r] = 0.0f;
+            }
+            packed += MR;
+        }
+    }
+}
+
+// B[0:kc, 0:nc] into NR-wide micro-panels, row by row; narrow panels are zero-padded
+void packB(ConstMatrixView b, float* packed) {
+    for (int panel = 0; panel < b.cols; panel += NR) {
+        const int cols = std::min(NR, b.cols - panel);
+        for (int k = 0; k < b.rows; ++k) {
+            const float* b_row = b.row(k) + panel;
+            for (int col = 0; col < cols; ++col) {
+                packed[col] = b_row[col];
+            }
+            for (int col = cols; col < NR; ++col) {
+                packed[col] = 0.0f;
+            }
+            packed += NR;
+        }
+    }
+}
+
+int roundUp(int value, int multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+std::size_t packedASize(int m, int k) {
+    return static_cast<std::size_t>(roundUp(std::min(Gemm::MC, m), MR)) * std::min(Gemm::KC, k);
+}
+
+std::size_t packedBSize(int n, int k) {
+    return static_cast<std::size_t>(std::min(Gemm::KC, k)) * roundUp(std::min(Gemm::NC, n), NR);
+}
+
+// C[0:mc, 0:nc] (+)= packed A block * packed B slice
+void macroKernel(int mc, int nc, int kc, const float* packed_a, const float* packed_b,
+                 MatrixView c, bool accumulate, MicrokernelFn kernel) {
+    alignas(64) float edge_tile[MR * NR];
+
+    for (int jr = 0; jr < nc; jr += NR) {
+        const int nr = std::min(NR, nc - jr);
+        const float* b_panel = packed_b + static_cast<std::size_t>(jr / NR) * kc * NR;
+
+        for (int ir = 0; ir < mc; ir += MR) {
+            const int mr = std::min(MR, mc - ir);
+            const float* a_panel = packed_a + static_cast<std::size_t>(ir / MR) * kc * MR;
+            float* c_tile = c.row(ir) + jr;
+
+            if (mr == MR && nr == NR) {
+                kernel(kc, a_panel, b_panel, c_tile, c.stride, accumulate);
+                continue;
+            }
+
+            // Edge tile: full-size product into scratch, then copy the valid part
+            kernel(kc, a_panel, b_panel, edge_tile, NR, false);
+            for (int r = 0; r < mr; ++r) {
+                float* c_row = c_tile + static_cast<std::size_t>(r) * c.stride;
+                for (int col = 0; col < nr; ++col) {
+                    c_row[col] = accumulate ? c_row[col] + edge_tile[r * NR + col] : edge_tile[r * NR + col];
+                }
+            }
+        }
+    }
+}
+
+} // namespace
+
+void Gemm::multiply(ConstMatrixView a, ConstMatrixView b, MatrixView result) {
+    const int m = a.rows;
+    const int n = b.cols;
+    const int k = a.cols;
+    if (m == 0 || n == 0 || b.rows != k || result.rows != m || result.cols != n) {
+        return;
+    }
+
+    if (k == 0) {
+        for (int i = 0; i < m; ++i) {
+            std::fill(result.row(i), result.row(i) + n, 0.0f);
+        }
+        return;
+    }
+
+    // Packing buffers come from the thread's scratch arena, released on return
+    FrameArena& arena = FrameArena::forThread();
+    FrameArena::Marker scratch(arena);
+    float* packed_a = arena.allocateArray<float>(packedASize(m, k));
+    float* packed_b = arena.allocateArray<float>(packedBSize(n, k));
+
+    const MicrokernelFn kernel = microkernel().kernel;
+
+    for (int jc = 0; jc < n; jc += NC) {
+        const int nc = std::min(NC, n - jc);
+
+        for (int pc = 0; pc < k; pc += KC) {
+            const int kc = std::min(KC, k - pc);
+            packB(b.block(pc, jc, kc, nc), packed_b);
+
+            for (int ic = 0; ic < m; ic += MC) {
+                const int mc = std::min(MC, m - ic);
+                packA(a.block(ic, pc, mc, kc), packed_a);
+                macroKernel(mc, nc, kc, packed_a, packed_b,
+                            result.block(ic, jc, mc, nc), pc > 0, kernel);
+            }
+        }
+    }
+}
+
+std::size_t Gemm::getScratchBytes(int m, int n, int k) {
+    return (packedASize(m, k) + packedBSize(n, k)) * sizeof(float) + 2 * FrameArena::ALIGNMENT;
+}
+
+const char* Gemm::getKernelName() {
+    return microkernel().name;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include "matrix.h"
+
+// Single precision GEMM in the BLIS / GotoBLAS style: C = A * B.
+//
+// The k dimension is split into KC-deep slices and the rows of A into MC-row
+// blocks. For each slice, B is packed once into NR-wide micro-panels (sized to
+// stay in L1 while it is reused) and each A block into MR-tall micro-panels (an
+// MC x KC block stays in L2). An MR x NR register-blocked microkernel (AVX2 FMA
+// 8x8, AArch64 NEON 8x12, portable 8x8 otherwise) then walks the packed panels.
+// Partial edge tiles go through a small scratch tile.
+class Gemm {
+public:
+    static constexpr int MR = 8;
+#if defined(__aarch64__)
+    static constexpr int NR = 12;
+#else
+    static constexpr int NR = 8;
+#endif
+    static constexpr int KC = 256;
+    static constexpr int MC = 128;  // Multiple of MR
+    static constexpr int NC = 3072; // Multiple of NR
+
+    // result must be a.rows x b.cols; it is overwritten
+    static void multiply(ConstMatrixView a, ConstMatrixView b, MatrixView result);
+
+    // Scratch arena bytes multiply() takes for the packed panels
+    static std::size_t getScratchBytes(int m, int n, int k);
+
+    // Microkernel picked by the runtime dispatcher, e.g. "AVX2 FMA 8x8"
+    static const char* getKernelName();
+};
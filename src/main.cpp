@@ -1,71 +1,669 @@
-#include <SFML/Graphics.hpp>
 #include <iostream>
 #include <chrono>
 #include <string>
 #include <iomanip>
-#include <signal.h>
+#include <csignal>
 #include <thread>
+#include <random>
+#include <cstdint>
+#include <cstdlib>
+#include <cmath>
+#include <fstream>
+#include <memory>
+#include <algorithm>
+#include <vector>
 
 #include "simulation.h"
-#include "fps_counter.h"
+#include "particle_kernels.h"
+#include "thread_pool.h"
+#include "benchmark_report.h"
+#include "profiler.h"
+#include "trajectory_writer.h"
+#include "fixed_timestep.h"
+#include "render_snapshot.h"
+#include "domain_decomposition.h"
+#include "frame_stats.h"
+#include "metrics_server.h"
+#include "ensemble_runner.h"
+
+#if defined(BROWNIAN_VIEWER)
+#include "viewer/viewer.h"
+#endif
 
 constexpr int WINDOW_WIDTH = 1200;
 constexpr int WINDOW_HEIGHT = 800;
 constexpr int PARTICLE_COUNT = 10000; // Extreme particle count for maximum performance impact
 
-// Global variables for signal handling
-static volatile bool running = true;
-static int total_frames = 0;
-static std::chrono::high_resolution_clock::time_point start_time;
-
-void signalHandler(int signal) {
-    if (signal == SIGINT) {
-        std::cout << "\n\n=== INTERRUPTED BY USER ===" << std::endl;
-        auto end_time = std::chrono::high_resolution_clock::now();
-        float total_duration = std::chrono::duration<float>(end_time - start_time).count();
-        float avg_fps = total_frames / total_duration;
+// Set from the SIGINT handler; the handler does nothing else, since almost
+// nothing (iostreams included) is async-signal-safe
+static volatile std::sig_atomic_t running = 1;
+
+void signalHandler(int) {
+    running = 0;
+}
+
+// Command line options
+struct AppOptions {
+    bool headless = false;
+    uint64_t seed = 0;
+    int threads = 1;
+    int matrix_size = 280;
+    bool lazy_matrix = false;
+    bool perf_counters = false; // Read hardware counters around each update phase
+    bool interactions = false;  // Particle-particle repulsion
+    float stiffness = ParticleInteractions::DEFAULT_STIFFNESS;
+    BoundaryMode boundary = BoundaryMode::Reflect;
+    NoiseMode noise = NoiseMode::Uniform;
+    bool color_jitter = true;
+    int sort_interval = 0;       // > 0: Morton-reorder the particles every N frames
+    bool compute_device = false; // Particle pass on the OpenCL device
+    int compute_check = 0;       // > 0 with --frames: compare with a CPU run every N frames
+    int frames = 0;          // > 0: fixed-length benchmark with a JSON report
+    int domain_columns = 0;  // > 0 with --frames: split the world into tiles (--domains CxR)
+    int domain_rows = 0;
+    int ensemble = 0;        // > 0 with --frames: run this many replicas in one process
+    std::string sweep_path;  // Non-empty with --frames: ensemble members from this file
+    float delta_time = 0.0f; // > 0: fixed timestep instead of wall clock
+    int particles = PARTICLE_COUNT;
+    int obstacles = BrownianSimulation::DEFAULT_OBSTACLE_COUNT;
+    std::string report_path; // Empty: report goes to stdout
+    std::string trace_path;  // Chrome trace written at exit (profiling builds)
+    std::string trajectory_path; // Non-empty: record positions (headless and --frames)
+    int trajectory_stride = 1;   // Record every Nth frame
+    std::string checkpoint_path; // Non-empty: save state at exit (headless and --frames)
+    int checkpoint_every = 0;    // > 0: also save every N frames
+    std::string resume_path;     // Non-empty: start from this checkpoint
+    int metrics_port = 0;        // > 0: serve Prometheus metrics on this port (headless and --frames)
+    bool serial_render = false;  // Viewer: update and draw on one thread
+    int max_substeps = FixedTimestep::DEFAULT_MAX_STEPS; // Viewer: fixed steps per drawn frame, at most
+    bool interpolate = true;     // Viewer: draw between the last two steps
+    RenderLod lod = RenderLod::Decimate;
+    int render_budget = 250000;  // Viewer: particles drawn before level of detail kicks in
+};
+
+void printUsage(const char* program) {
+    std::cout << "Usage: " << program << " [options]\n"
+              << "  --no-visualize   Run headless (Ctrl+C to stop)\n"
+              << "  --seed S         Seed for reproducible runs (random by default)\n"
+              << "  --threads N      Worker threads for the particle update and matrix multiply (0 = all cores, default 1)\n"
+              << "  --matrix-size N  Edge of the per-frame matrix multiply, 1..4096 (default 280)\n"
+              << "  --lazy-matrix    Reuse the matrix product while its inputs are unchanged\n"
+              << "  --frames N       Run N frames headless and print a JSON benchmark report\n"
+              << "  --dt T           Fixed timestep in seconds (default: wall clock headless, 1/60 in the viewer, 0.016 with --frames)\n"
+              << "  --particles P    Particle count (default 10000)\n"
+              << "  --obstacles O    Obstacle count (default 4)\n"
+              << "  --report FILE    Write the benchmark report to FILE instead of stdout\n"
+              << "  --domains CxR    With --frames: simulate C x R tiles that exchange particles (MPI ranks with -DBROWNIAN_MPI)\n"
+              << "  --ensemble N     With --frames: run N replicas (seeds S, S+1, ...) in one process, one per worker, as JSON lines\n"
+              << "  --sweep FILE     With --frames: ensemble members from FILE, one line of key=value settings each\n"
+              << "  --interactions   Soft-sphere repulsion between particles (cell-list neighbor search)\n"
+              << "  --stiffness K    Repulsion stiffness for --interactions (default 200)\n"
+              << "  --boundary MODE  World edges: reflect (default), periodic (wrap around) or absorb (stop at the wall)\n"
+              << "  --noise MODE     Velocity kicks: uniform (default) or gaussian (same variance)\n"
+              << "  --no-color-jitter  Keep particle colors fixed\n"
+              << "  --sort-every K   Reorder the particle arrays along a Morton curve every K frames (default off)\n"
+              << "  --compute MODE   Particle pass: cpu (default) or opencl (device-resident particles, needs -DBROWNIAN_OPENCL)\n"
+              << "  --compute-check N  With --frames and --compute opencl: step a CPU copy alongside, compare every N frames and resync\n"
+              << "  --perf-counters  Count cycles, instructions and cache/branch misses per phase (Linux perf_event)\n"
+              << "  --trajectory FILE  Record quantized positions to FILE (headless and --frames; read with brownian_trajectory_dump)\n"
+              << "  --trajectory-stride N  Record every Nth frame (default 1)\n"
+              << "  --checkpoint FILE  Save the full simulation state to FILE at exit (headless and --frames)\n"
+              << "  --checkpoint-every N  Also save the checkpoint every N frames\n"
+              << "  --resume FILE    Continue from a checkpoint (its particles, obstacles and settings replace the options)\n"
+              << "  --metrics-port P Serve FPS, frame time quantiles and phase timings at http://host:P/metrics (headless and --frames)\n"
+              << "  --serial-render  Viewer: run update() and drawing on one thread instead of pipelining them\n"
+              << "  --substeps N     Viewer: at most N fixed steps per drawn frame before the run slows down (default 4)\n"
+              << "  --no-interpolate Viewer: draw the latest step instead of interpolating between the last two\n"
+              << "  --lod MODE       Viewer: off, decimate (every Nth particle) or density (density image) above the budget\n"
+              << "  --render-budget N  Viewer: particles drawn individually before --lod applies (default 250000)\n"
+              << "  --trace FILE     Write profiler zones as Chrome trace JSON on exit (needs -DBROWNIAN_PROFILING)\n"
+              << "  --help           Show this help\n";
+}
+
+// Parse an unsigned 64-bit option value; returns false on garbage
+bool parseUnsigned(const char* text, uint64_t& value) {
+    char* end = nullptr;
+    unsigned long long parsed = std::strtoull(text, &end, 0);
+    if (end == text || *end != '\0') {
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+// Parse a float option value; returns false on garbage
+bool parseFloat(const char* text, float& value) {
+    char* end = nullptr;
+    float parsed = std::strtof(text, &end);
+    if (end == text || *end != '\0' || !std::isfinite(parsed)) {
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+// Dump the profiler's retained zones, if a trace was asked for
+void writeTrace(const AppOptions& options) {
+    if (options.trace_path.empty()) {
+        return;
+    }
+    std::ofstream file(options.trace_path);
+    if (!file) {
+        std::cerr << "Error: could not open '" << options.trace_path << "' for writing" << std::endl;
+        return;
+    }
+    Profiler::writeChromeTrace(file);
+    std::cerr << "Trace written to " << options.trace_path << " (open in ui.perfetto.dev)" << std::endl;
+}
+
+// Apply the command line's simulation settings and attach the worker pool;
+// a --resume checkpoint is loaded last, so its settings win
+bool configureSimulation(BrownianSimulation& simulation, ThreadPool& thread_pool, const AppOptions& options) {
+    simulation.setMatrixSize(options.matrix_size);
+    simulation.setLazyMatrixProduct(options.lazy_matrix);
+    simulation.setParticleInteractions(options.interactions);
+    simulation.getParticleInteractions().setStiffness(options.stiffness);
+    simulation.setBoundaryMode(options.boundary);
+    simulation.setNoiseMode(options.noise);
+    simulation.setColorJitter(options.color_jitter);
+    simulation.setSortInterval(options.sort_interval);
+    simulation.setThreadPool(&thread_pool);
+    if (options.compute_device && !simulation.enableComputeBackend()) {
+        std::cerr << "Error: no compute device: " << simulation.getComputeBackend().getError() << std::endl;
+        return false;
+    }
+    
+    if (options.resume_path.empty()) {
+        return true;
+    }
+    std::string error;
+    if (!simulation.loadCheckpoint(options.resume_path, error)) {
+        std::cerr << "Error: could not resume from '" << options.resume_path << "': " << error << std::endl;
+        return false;
+    }
+    std::cerr << "Resumed from " << options.resume_path << " at frame " << simulation.getFrameIndex()
+              << " (" << simulation.getParticleCount() << " particles, seed " << simulation.getSeed() << ")"
+              << std::endl;
+    return true;
+}
+
+// Save --checkpoint at exit, or every --checkpoint-every frames when periodic is set
+void writeCheckpoint(const BrownianSimulation& simulation, const AppOptions& options, bool periodic) {
+    if (options.checkpoint_path.empty()) {
+        return;
+    }
+    if (periodic && (options.checkpoint_every == 0 || simulation.getFrameIndex() % options.checkpoint_every != 0)) {
+        return;
+    }
+    std::string error;
+    if (!simulation.saveCheckpoint(options.checkpoint_path, error)) {
+        std::cerr << "Error: checkpoint not saved: " << error << std::endl;
+    } else if (!periodic) {
+        std::cerr << "Checkpoint at frame " << simulation.getFrameIndex() << " written to "
+                  << options.checkpoint_path << std::endl;
+    }
+}
+
+// Open the simulation's counter group if asked; a missing PMU or permission
+// is a warning, not an error, so the run goes on without counters
+void setupPerfCounters(BrownianSimulation& simulation, const AppOptions& options) {
+    if (!options.perf_counters) {
+        return;
+    }
+    if (!simulation.enablePerfCounters()) {
+        std::cerr << "Warning: hardware counters unavailable (" << simulation.getPerfCounters().getError()
+                  << "); check /proc/sys/kernel/perf_event_paranoid" << std::endl;
+        return;
+    }
+    std::cerr << "Hardware counters: update thread only";
+    for (int event = 0; event < PERF_EVENT_COUNT; ++event) {
+        if (!simulation.getPerfCounters().hasEvent(event)) {
+            std::cerr << ", no " << PerfCounters::getEventName(event);
+        }
+    }
+    std::cerr << std::endl;
+}
+
+// Start recording if --trajectory was given; on failure the caller exits
+bool openTrajectory(TrajectoryWriter& writer, const BrownianSimulation& simulation, const AppOptions& options) {
+    if (options.trajectory_path.empty()) {
+        return true;
+    }
+    if (!writer.open(options.trajectory_path, simulation.getParticleCount(), simulation.getWidth(),
+                     simulation.getHeight())) {
+        std::cerr << "Error: " << writer.getError() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void recordTrajectory(TrajectoryWriter& writer, const BrownianSimulation& simulation, const AppOptions& options) {
+    if (writer.isOpen() && simulation.getFrameIndex() % options.trajectory_stride == 0) {
+        writer.addFrame(simulation.getParticles(), simulation.getFrameIndex());
+    }
+}
+
+void closeTrajectory(TrajectoryWriter& writer, const AppOptions& options) {
+    if (!writer.isOpen()) {
+        return;
+    }
+    const bool written = writer.close();
+    std::cerr << "Trajectory: " << writer.getFramesWritten() << " frames to " << options.trajectory_path
+              << ", " << writer.getStallCount() << " stalls" << std::endl;
+    if (!written) {
+        std::cerr << "Error: " << writer.getError() << std::endl;
+    }
+}
+
+// Serve --metrics-port from stats if it was given; on failure the caller exits
+bool startMetrics(MetricsServer& server, const FrameStats& stats, std::size_t particles, int threads,
+                  const std::string& compute, const AppOptions& options) {
+    if (options.metrics_port == 0) {
+        return true;
+    }
+    MetricsInfo info;
+    info.particles = particles;
+    info.threads = threads;
+    info.kernels = ParticleKernels::getInstructionSetName();
+    info.compute = compute;
+    if (!server.start(options.metrics_port, stats, info)) {
+        std::cerr << "Error: metrics endpoint: " << server.getError() << std::endl;
+        return false;
+    }
+    std::cerr << "Metrics: serving http://0.0.0.0:" << options.metrics_port << "/metrics" << std::endl;
+    return true;
+}
+
+// --compute-check: largest position and velocity deviation of the device run
+// from the CPU reference since the last check, then restart both from the
+// reference state so errors do not compound through collisions. Particles are
+// matched by id: with --sort-every the two runs reorder by their own positions.
+void compareWithReference(BrownianSimulation& simulation, const BrownianSimulation& reference,
+                          BenchmarkConfig& config) {
+    const ParticleStore& device = simulation.getParticles();
+    const ParticleStore& host = reference.getParticles();
+    std::vector<std::size_t> host_slot(host.size()); // Ids of one simulation are 0 .. count - 1
+    for (std::size_t i = 0; i < host.size(); ++i) {
+        host_slot[host.id[i]] = i;
+    }
+    double position_error = 0.0;
+    double velocity_error = 0.0;
+    for (std::size_t i = 0; i < device.size(); ++i) {
+        const std::size_t j = host_slot[device.id[i]];
+        position_error = std::max({position_error, static_cast<double>(std::abs(device.pos_x[i] - host.pos_x[j])),
+                                   static_cast<double>(std::abs(device.pos_y[i] - host.pos_y[j]))});
+        velocity_error = std::max({velocity_error, static_cast<double>(std::abs(device.vel_x[i] - host.vel_x[j])),
+                                   static_cast<double>(std::abs(device.vel_y[i] - host.vel_y[j]))});
+    }
+    ++config.compute_checks;
+    config.compute_max_position_error = std::max(config.compute_max_position_error, position_error);
+    config.compute_max_velocity_error = std::max(config.compute_max_velocity_error, velocity_error);
+    simulation.setParticles(host);
+}
+
+// Fixed workload: same frames, timestep and seed every run, so builds and
+// commits can be compared on equal terms. Progress goes to stderr, the JSON
+// report to stdout (or --report).
+int runBenchmarkMode(const AppOptions& options) {
+    BrownianSimulation simulation(WINDOW_WIDTH, WINDOW_HEIGHT, options.particles, options.seed, options.obstacles);
+    ThreadPool thread_pool(options.threads);
+    if (!configureSimulation(simulation, thread_pool, options)) {
+        return 1;
+    }
+    setupPerfCounters(simulation, options);
+    TrajectoryWriter trajectory;
+    if (!openTrajectory(trajectory, simulation, options)) {
+        return 1;
+    }
+    
+    // The CPU twin for --compute-check gets the same options, minus the device
+    std::unique_ptr<BrownianSimulation> reference;
+    if (options.compute_check > 0) {
+        AppOptions reference_options = options;
+        reference_options.compute_device = false;
+        reference = std::make_unique<BrownianSimulation>(WINDOW_WIDTH, WINDOW_HEIGHT, options.particles,
+                                                         options.seed, options.obstacles);
+        if (!configureSimulation(*reference, thread_pool, reference_options)) {
+            return 1;
+        }
+    }
+    
+    BenchmarkConfig config;
+    config.frames = options.frames;
+    config.delta_time = options.delta_time > 0.0f ? options.delta_time : 0.016f;
+    config.particles = simulation.getParticleCount();
+    config.obstacles = simulation.getObstacleCount();
+    config.matrix_size = simulation.getMatrixSize();
+    config.lazy_matrix = simulation.isMatrixProductLazy();
+    config.perf_counters = options.perf_counters;
+    config.interactions = simulation.areParticleInteractionsEnabled();
+    config.boundary = simulation.getBoundaryMode();
+    config.noise = simulation.getNoiseMode();
+    config.color_jitter = simulation.isColorJitterEnabled();
+    config.sort_interval = simulation.getSortInterval();
+    config.threads = thread_pool.getThreadCount();
+    config.seed = simulation.getSeed();
+    if (simulation.isComputeBackendEnabled()) {
+        config.compute = simulation.getComputeBackend().getDeviceName();
+    }
+    config.compute_check_interval = options.compute_check;
+    
+    std::cerr << "Benchmark: " << config.frames << " frames, dt " << config.delta_time
+              << ", " << config.particles << " particles, " << config.obstacles << " obstacles, "
+              << config.matrix_size << "x" << config.matrix_size << " matrix, "
+              << config.threads << " threads, seed " << config.seed << ", particles on " << config.compute
+              << std::endl;
+    
+    FrameStats frame_stats;
+    MetricsServer metrics;
+    if (!startMetrics(metrics, frame_stats, config.particles, config.threads, config.compute, options)) {
+        return 1;
+    }
+    
+    signal(SIGINT, signalHandler);
+    
+    BenchmarkReport report(config.frames);
+    using Clock = std::chrono::steady_clock;
+    const auto start = Clock::now();
+    
+    for (int frame = 0; frame < config.frames && running; ++frame) {
+        const auto frame_start = Clock::now();
+        simulation.update(config.delta_time);
+        const auto frame_end = Clock::now();
+        recordTrajectory(trajectory, simulation, options);
+        writeCheckpoint(simulation, options, true);
+        report.addFrame(simulation.getLastFrameTimings(),
+                        std::chrono::duration<double, std::milli>(frame_end - frame_start).count());
+        frame_stats.addFrame(std::chrono::duration_cast<std::chrono::nanoseconds>(frame_end - frame_start),
+                             simulation.getLastFrameTimings());
+        if (simulation.getPerfCounters().isOpen()) {
+            report.addCounters(simulation.getLastFrameCounters());
+        }
+        if (reference) {
+            reference->update(config.delta_time);
+            if (reference->getFrameIndex() % options.compute_check == 0) {
+                compareWithReference(simulation, *reference, config);
+            }
+        }
+    }
+    
+    const double wall_seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    if (reference) {
+        std::cerr << "Compute check: " << config.compute_checks << " comparisons every " << options.compute_check
+                  << " frames, max error " << config.compute_max_position_error << " px, "
+                  << config.compute_max_velocity_error << " px/s" << std::endl;
+        if (!simulation.isComputeBackendEnabled()) {
+            std::cerr << "Warning: the device failed during the run (" << simulation.getComputeBackend().getError()
+                      << "); the rest ran on the CPU" << std::endl;
+        }
+    }
+    closeTrajectory(trajectory, options);
+    writeCheckpoint(simulation, options, false);
+    if (!running) {
+        std::cerr << "Interrupted; reporting the frames that ran" << std::endl;
+    }
+    
+    if (options.report_path.empty()) {
+        report.writeJson(std::cout, config, simulation.getParticles(), simulation.getPerfCounters(), wall_seconds);
+        return 0;
+    }
+    
+    std::ofstream file(options.report_path);
+    if (!file) {
+        std::cerr << "Error: could not open '" << options.report_path << "' for writing" << std::endl;
+        return 1;
+    }
+    report.writeJson(file, config, simulation.getParticles(), simulation.getPerfCounters(), wall_seconds);
+    std::cerr << "Report written to " << options.report_path << std::endl;
+    return 0;
+}
+
+// --frames over a tile grid. Every rank steps its own tiles; rank 0 gathers
+// the particles and writes the report, whose state_hash matches the same run
+// without --domains.
+int runDomainMode(const AppOptions& options, int* argc, char*** argv) {
+    DomainDecomposition::initializeRuntime(argc, argv);
+    const bool root = DomainDecomposition::getRank() == 0;
+    int result = 0;
+    {
+        DomainDecomposition domains(WINDOW_WIDTH, WINDOW_HEIGHT, options.particles, options.seed, options.obstacles,
+                                    options.domain_columns, options.domain_rows);
+        ThreadPool thread_pool(options.threads);
+        for (int local = 0; local < domains.getLocalTileCount(); ++local) {
+            BrownianSimulation& tile = domains.getLocalTile(local);
+            tile.setMatrixSize(options.matrix_size);
+            tile.setLazyMatrixProduct(options.lazy_matrix);
+            tile.setBoundaryMode(options.boundary);
+            tile.setNoiseMode(options.noise);
+            tile.setColorJitter(options.color_jitter);
+            tile.setSortInterval(options.sort_interval);
+            tile.setThreadPool(&thread_pool);
+        }
+        
+        BenchmarkConfig config;
+        config.frames = options.frames;
+        config.delta_time = options.delta_time > 0.0f ? options.delta_time : 0.016f;
+        config.particles = options.particles;
+        config.obstacles = options.obstacles;
+        config.matrix_size = options.matrix_size;
+        config.lazy_matrix = options.lazy_matrix;
+        config.boundary = options.boundary;
+        config.noise = options.noise;
+        config.color_jitter = options.color_jitter;
+        config.sort_interval = options.sort_interval;
+        config.threads = thread_pool.getThreadCount();
+        config.seed = options.seed;
+        config.domain_columns = domains.getColumns();
+        config.domain_rows = domains.getRows();
+        config.ranks = DomainDecomposition::getRankCount();
+        
+        if (root) {
+            std::cerr << "Benchmark: " << config.frames << " frames, dt " << config.delta_time
+                      << ", " << config.particles << " particles in " << config.domain_columns << "x"
+                      << config.domain_rows << " tiles over " << config.ranks << " ranks"
+                      << (DomainDecomposition::hasMpi() ? "" : " (built without MPI)") << ", seed " << config.seed
+                      << std::endl;
+        }
+        
+        // With MPI every rank has to run the same number of frames, so
+        // Ctrl+C is left to mpirun there
+        if (!DomainDecomposition::hasMpi()) {
+            signal(SIGINT, signalHandler);
+        }
+        
+        // Rank 0 serves the metrics, its frames wait for every rank anyway. A
+        // port that fails only loses the metrics: every rank must run the frames.
+        FrameStats frame_stats;
+        MetricsServer metrics;
+        if (root) {
+            startMetrics(metrics, frame_stats, config.particles, config.threads, config.compute, options);
+        }
+        
+        BenchmarkReport report(config.frames);
+        using Clock = std::chrono::steady_clock;
+        const auto start = Clock::now();
+        std::size_t migrations = 0;
+        int frames_run = 0;
+        
+        for (int frame = 0; frame < config.frames && running; ++frame) {
+            const auto frame_start = Clock::now();
+            domains.update(config.delta_time);
+            const auto frame_end = Clock::now();
+            report.addFrame(domains.getLastFrameTimings(),
+                            std::chrono::duration<double, std::milli>(frame_end - frame_start).count());
+            frame_stats.addFrame(std::chrono::duration_cast<std::chrono::nanoseconds>(frame_end - frame_start),
+                                 domains.getLastFrameTimings());
+            migrations += domains.getLastMigrationCount();
+            ++frames_run;
+        }
         
-        std::cout << "Average FPS: " << std::fixed << std::setprecision(1) << avg_fps << std::endl;
-        std::cout << "Total frames: " << total_frames << std::endl;
-        std::cout << "Duration: " << std::fixed << std::setprecision(1) << total_duration << " seconds" << std::endl;
+        const double wall_seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        config.migrations_per_frame = frames_run > 0 ? static_cast<double>(migrations) / frames_run : 0.0;
+        ParticleStore particles;
+        domains.gatherParticles(particles);
         
-        running = false;
+        if (root) {
+            if (!running) {
+                std::cerr << "Interrupted; reporting the frames that ran" << std::endl;
+            }
+            if (options.report_path.empty()) {
+                report.writeJson(std::cout, config, particles, PerfCounters(), wall_seconds);
+            } else {
+                std::ofstream file(options.report_path);
+                if (file) {
+                    report.writeJson(file, config, particles, PerfCounters(), wall_seconds);
+                    std::cerr << "Report written to " << options.report_path << std::endl;
+                } else {
+                    std::cerr << "Error: could not open '" << options.report_path << "' for writing" << std::endl;
+                    result = 1;
+                }
+            }
+        }
+    }
+    DomainDecomposition::finalizeRuntime();
+    return result;
+}
+
+// --frames over many independent members (--ensemble replicas or --sweep
+// lines), each stepped on one worker; a JSON line per member goes to stdout
+// (or --report) in member order, progress to stderr
+int runEnsembleMode(const AppOptions& options) {
+    EnsembleMember base;
+    base.seed = options.seed;
+    base.particles = options.particles;
+    base.obstacles = options.obstacles;
+    base.matrix_size = options.matrix_size;
+    base.lazy_matrix = options.lazy_matrix;
+    base.delta_time = options.delta_time > 0.0f ? options.delta_time : 0.016f;
+    base.interactions = options.interactions;
+    base.stiffness = options.stiffness;
+    base.boundary = options.boundary;
+    base.noise = options.noise;
+    base.color_jitter = options.color_jitter;
+    base.sort_interval = options.sort_interval;
+    
+    std::vector<EnsembleMember> members;
+    if (options.sweep_path.empty()) {
+        for (int i = 0; i < options.ensemble; ++i) {
+            members.push_back(base);
+            members.back().seed = base.seed + i;
+        }
+    } else {
+        std::ifstream sweep(options.sweep_path);
+        std::string error;
+        if (!sweep) {
+            std::cerr << "Error: could not open '" << options.sweep_path << "'" << std::endl;
+            return 1;
+        }
+        if (!EnsembleRunner::parseSweep(sweep, base, members, error)) {
+            std::cerr << "Error: sweep '" << options.sweep_path << "', " << error << std::endl;
+            return 1;
+        }
+        if (members.empty()) {
+            std::cerr << "Error: sweep '" << options.sweep_path << "' has no members" << std::endl;
+            return 1;
+        }
+    }
+    
+    std::ofstream file;
+    if (!options.report_path.empty()) {
+        file.open(options.report_path);
+        if (!file) {
+            std::cerr << "Error: could not open '" << options.report_path << "' for writing" << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& out = options.report_path.empty() ? std::cout : file;
+    
+    ThreadPool thread_pool(options.threads);
+    std::cerr << "Ensemble: " << members.size() << " members, " << options.frames << " frames each, "
+              << thread_pool.getThreadCount() << " workers" << std::endl;
+    
+    signal(SIGINT, signalHandler);
+    
+    EnsembleRunner runner(WINDOW_WIDTH, WINDOW_HEIGHT, options.frames);
+    const auto start = std::chrono::steady_clock::now();
+    const std::size_t completed = runner.run(members, thread_pool, out, &running);
+    const double wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    
+    std::cerr << "Ensemble: " << completed << " of " << members.size() << " members completed in "
+              << std::fixed << std::setprecision(2) << wall_seconds << " s" << std::endl;
+    if (!running) {
+        std::cerr << "Interrupted; members that had started report the frames they ran" << std::endl;
+    }
+    if (!options.report_path.empty()) {
+        std::cerr << "Results written to " << options.report_path << std::endl;
     }
+    return 0;
 }
 
-void runHeadlessMode() {
+int runHeadlessMode(const AppOptions& options) {
     std::cout << "=== HEADLESS MODE ===" << std::endl;
-    std::cout << "Particles: " << PARTICLE_COUNT << std::endl;
-    std::cout << "Matrix operations: 280x280 per frame" << std::endl;
+    std::cout << "Particles: " << options.particles << std::endl;
+    std::cout << "Matrix operations: " << options.matrix_size << "x" << options.matrix_size
+              << (options.lazy_matrix ? " (lazy, recomputed on change)" : " per frame") << std::endl;
+    std::cout << "Particle kernels: " << ParticleKernels::getInstructionSetName() << std::endl;
+    std::cout << "Seed: " << options.seed << std::endl;
     std::cout << "Running indefinitely... Press Ctrl+C to stop and see results" << std::endl;
     
     // Setup signal handler
     signal(SIGINT, signalHandler);
     
     // Initialize simulation (no window needed)
-    BrownianSimulation simulation(WINDOW_WIDTH, WINDOW_HEIGHT, PARTICLE_COUNT);
+    BrownianSimulation simulation(WINDOW_WIDTH, WINDOW_HEIGHT, options.particles, options.seed, options.obstacles);
+    ThreadPool thread_pool(options.threads);
+    if (!configureSimulation(simulation, thread_pool, options)) {
+        return 1;
+    }
+    std::cout << "Threads: " << thread_pool.getThreadCount() << std::endl;
+    if (simulation.isComputeBackendEnabled()) {
+        std::cout << "Compute device: " << simulation.getComputeBackend().getDeviceName() << std::endl;
+    }
+    setupPerfCounters(simulation, options);
+    const bool counting = simulation.getPerfCounters().isOpen();
+    PhaseCounters second_counters;
+    TrajectoryWriter trajectory;
+    if (!openTrajectory(trajectory, simulation, options)) {
+        return 1;
+    }
+    FrameStats frame_stats;
+    MetricsServer metrics;
+    const std::string compute = simulation.isComputeBackendEnabled() ? simulation.getComputeBackend().getDeviceName()
+                                                                      : "cpu";
+    if (!startMetrics(metrics, frame_stats, simulation.getParticleCount(), thread_pool.getThreadCount(), compute,
+                      options)) {
+        return 1;
+    }
     
-    start_time = std::chrono::high_resolution_clock::now();
+    auto start_time = std::chrono::high_resolution_clock::now();
     auto last_time = start_time;
     auto last_fps_time = start_time;
     
     int frame_count = 0;
-    total_frames = 0;
+    int total_frames = 0;
     float total_frame_time = 0.0f;
     
     // Run until interrupted
     while (running) {
         auto frame_start = std::chrono::high_resolution_clock::now();
         auto current_time = frame_start;
-        float delta_time = std::chrono::duration<float>(current_time - last_time).count();
+        float delta_time = options.delta_time > 0.0f ? options.delta_time
+                                                     : std::chrono::duration<float>(current_time - last_time).count();
         last_time = current_time;
         
         // Update simulation (this is where the matrix operations happen)
         simulation.update(delta_time);
+        if (counting) {
+            second_counters += simulation.getLastFrameCounters();
+        }
+        recordTrajectory(trajectory, simulation, options);
+        writeCheckpoint(simulation, options, true);
         
         auto frame_end = std::chrono::high_resolution_clock::now();
         float frame_time = std::chrono::duration<float>(frame_end - frame_start).count();
         total_frame_time += frame_time;
+        frame_stats.addFrame(std::chrono::duration_cast<std::chrono::nanoseconds>(frame_end - frame_start),
+                             simulation.getLastFrameTimings());
         
         frame_count++;
         total_frames++;
@@ -77,129 +675,310 @@ void runHeadlessMode() {
             float avg_frame_time = total_frame_time / frame_count;
             std::cout << "FPS: " << std::fixed << std::setprecision(1) << fps 
                      << " | Avg frame time: " << std::setprecision(3) << (avg_frame_time * 1000.0f) << "ms"
+                     << " | p99: " << frame_stats.getSnapshot().p99_ms << "ms"
                      << " | Total frames: " << total_frames << std::endl;
+            if (counting) {
+                simulation.getPerfCounters().formatPhases(std::cout, second_counters, frame_count);
+                second_counters = PhaseCounters();
+            }
             frame_count = 0;
             total_frame_time = 0.0f;
             last_fps_time = current_time;
         }
     }
+    
+    closeTrajectory(trajectory, options);
+    writeCheckpoint(simulation, options, false);
+    
+    // Summary printed here rather than in the signal handler
+    auto end_time = std::chrono::high_resolution_clock::now();
+    float total_duration = std::chrono::duration<float>(end_time - start_time).count();
+    float avg_fps = total_duration > 0.0f ? total_frames / total_duration : 0.0f;
+    
+    std::cout << "\n\n=== INTERRUPTED BY USER ===" << std::endl;
+    std::cout << "Average FPS: " << std::fixed << std::setprecision(1) << avg_fps << std::endl;
+    std::cout << "Total frames: " << total_frames << std::endl;
+    std::cout << "Duration: " << std::fixed << std::setprecision(1) << total_duration << " seconds" << std::endl;
+    return 0;
 }
 
 int main(int argc, char* argv[]) {
+    PROFILE_THREAD("main");
+    
     // Parse command line arguments
-    bool headless = false;
+    AppOptions options;
+    options.seed = (static_cast<uint64_t>(std::random_device{}()) << 32) | std::random_device{}();
     for (int i = 1; i < argc; i++) {
-        if (std::string(argv[i]) == "-no-visualize" || std::string(argv[i]) == "--no-visualize") {
-            headless = true;
-            break;
+        std::string arg = argv[i];
+        uint64_t value = 0;
+        if (arg == "-no-visualize" || arg == "--no-visualize") {
+            options.headless = true;
+        } else if (arg == "--seed" && i + 1 < argc) {
+            if (!parseUnsigned(argv[++i], options.seed)) {
+                std::cout << "Error: invalid seed '" << argv[i] << "'\n";
+                return 1;
+            }
+        } else if (arg == "--threads" && i + 1 < argc) {
+            if (!parseUnsigned(argv[++i], value) || value > 1024) {
+                std::cout << "Error: invalid thread count '" << argv[i] << "'\n";
+                return 1;
+            }
+            options.threads = static_cast<int>(value);
+        } else if (arg == "--matrix-size" && i + 1 < argc) {
+            if (!parseUnsigned(argv[++i], value) || value < 1 || value > 4096) {
+                std::cout << "Error: invalid matrix size '" << argv[i] << "'\n";
+                return 1;
+            }
+            options.matrix_size = static_cast<int>(value);
+        } else if (arg == "--lazy-matrix") {
+            options.lazy_matrix = true;
+        } else if (arg == "--frames" && i + 1 < argc) {
+            if (!parseUnsigned(argv[++i], value) || value < 1 || value > 100000000) {
+                std::cout << "Error: invalid frame count '" << argv[i] << "'\n";
+                return 1;
+            }
+            options.frames = static_cast<int>(value);
+        } else if (arg == "--dt" && i + 1 < argc) {
+            if (!parseFloat(argv[++i], options.delta_time) || options.delta_time <= 0.0f || options.delta_time > 1.0f) {
+                std::cout << "Error: invalid timestep '" << argv[i] << "'\n";
+                return 1;
+            }
+        } else if (arg == "--particles" && i + 1 < argc) {
+            if (!parseUnsigned(argv[++i], value) || value > 10000000) {
+                std::cout << "Error: invalid particle count '" << argv[i] << "'\n";
+                return 1;
+            }
+            options.particles = static_cast<int>(value);
+        } else if (arg == "--obstacles" && i + 1 < argc) {
+            if (!parseUnsigned(argv[++i], value) || value > 1000) {
+                std::cout << "Error: invalid obstacle count '" << argv[i] << "'\n";
+                return 1;
+            }
+            options.obstacles = static_cast<int>(value);
+        } else if (arg == "--domains" && i + 1 < argc) {
+            char* end = nullptr;
+            const long columns = std::strtol(argv[++i], &end, 10);
+            const long rows = *end == 'x' ? std::strtol(end + 1, &end, 10) : 0;
+            if (*end != '\0' || columns < 1 || rows < 1 || columns * rows > 4096) {
+                std::cout << "Error: invalid domains '" << argv[i] << "' (columns x rows, e.g. 2x2)\n";
+                return 1;
+            }
+            options.domain_columns = static_cast<int>(columns);
+            options.domain_rows = static_cast<int>(rows);
+        } else if (arg == "--ensemble" && i + 1 < argc) {
+            if (!parseUnsigned(argv[++i], value) || value < 1 || value > 1000000) {
+                std::cout << "Error: invalid ensemble size '" << argv[i] << "'\n";
+                return 1;
+            }
+            options.ensemble = static_cast<int>(value);
+        } else if (arg == "--sweep" && i + 1 < argc) {
+            options.sweep_path = argv[++i];
+        } else if (arg == "--report" && i + 1 < argc) {
+            options.report_path = argv[++i];
+        } else if (arg == "--interactions") {
+            options.interactions = true;
+        } else if (arg == "--stiffness" && i + 1 < argc) {
+            if (!parseFloat(argv[++i], options.stiffness) || options.stiffness < 0.0f) {
+                std::cout << "Error: invalid stiffness '" << argv[i] << "'\n";
+                return 1;
+            }
+        } else if (arg == "--boundary" && i + 1 < argc) {
+            const std::string mode = argv[++i];
+            if (mode == "reflect") {
+                options.boundary = BoundaryMode::Reflect;
+            } else if (mode == "periodic") {
+                options.boundary = BoundaryMode::Periodic;
+            } else if (mode == "absorb") {
+                options.boundary = BoundaryMode::Absorb;
+            } else {
+                std::cout << "Error: invalid boundary '" << mode << "' (reflect, periodic, absorb)\n";
+                return 1;
+            }
+        } else if (arg == "--noise" && i + 1 < argc) {
+            const std::string mode = argv[++i];
+            if (mode == "uniform") {
+                options.noise = NoiseMode::Uniform;
+            } else if (mode == "gaussian") {
+                options.noise = NoiseMode::Gaussian;
+            } else {
+                std::cout << "Error: invalid noise '" << mode << "' (uniform, gaussian)\n";
+                return 1;
+            }
+        } else if (arg == "--compute" && i + 1 < argc) {
+            const std::string mode = argv[++i];
+            if (mode == "cpu") {
+                options.compute_device = false;
+            } else if (mode == "opencl") {
+                options.compute_device = true;
+            } else {
+                std::cout << "Error: invalid compute mode '" << mode << "' (cpu, opencl)\n";
+                return 1;
+            }
+        } else if (arg == "--compute-check" && i + 1 < argc) {
+            if (!parseUnsigned(argv[++i], value) || value < 1 || value > 100000000) {
+                std::cout << "Error: invalid compute check interval '" << argv[i] << "'\n";
+                return 1;
+            }
+            options.compute_check = static_cast<int>(value);
+        } else if (arg == "--no-color-jitter") {
+            options.color_jitter = false;
+        } else if (arg == "--sort-every" && i + 1 < argc) {
+            if (!parseUnsigned(argv[++i], value) || value < 1 || value > 100000000) {
+                std::cout << "Error: invalid sort interval '" << argv[i] << "'\n";
+                return 1;
+            }
+            options.sort_interval = static_cast<int>(value);
+        } else if (arg == "--perf-counters") {
+            options.perf_counters = true;
+        } else if (arg == "--trace" && i + 1 < argc) {
+            if (!Profiler::isEnabled()) {
+                std::cout << "Error: --trace needs a build with -DBROWNIAN_PROFILING\n";
+                return 1;
+            }
+            options.trace_path = argv[++i];
+        } else if (arg == "--trajectory" && i + 1 < argc) {
+            options.trajectory_path = argv[++i];
+        } else if (arg == "--trajectory-stride" && i + 1 < argc) {
+            if (!parseUnsigned(argv[++i], value) || value < 1 || value > 1000000) {
+                std::cout << "Error: invalid trajectory stride '" << argv[i] << "'\n";
+                return 1;
+            }
+            options.trajectory_stride = static_cast<int>(value);
+        } else if (arg == "--checkpoint" && i + 1 < argc) {
+            options.checkpoint_path = argv[++i];
+        } else if (arg == "--checkpoint-every" && i + 1 < argc) {
+            if (!parseUnsigned(argv[++i], value) || value < 1 || value > 100000000) {
+                std::cout << "Error: invalid checkpoint interval '" << argv[i] << "'\n";
+                return 1;
+            }
+            options.checkpoint_every = static_cast<int>(value);
+        } else if (arg == "--resume" && i + 1 < argc) {
+            options.resume_path = argv[++i];
+        } else if (arg == "--metrics-port" && i + 1 < argc) {
+            if (!parseUnsigned(argv[++i], value) || value < 1 || value > 65535) {
+                std::cout << "Error: invalid metrics port '" << argv[i] << "'\n";
+                return 1;
+            }
+            options.metrics_port = static_cast<int>(value);
+        } else if (arg == "--serial-render") {
+            options.serial_render = true;
+        } else if (arg == "--substeps" && i + 1 < argc) {
+            if (!parseUnsigned(argv[++i], value) || value < 1 || value > 64) {
+                std::cout << "Error: invalid substep count '" << argv[i] << "'\n";
+                return 1;
+            }
+            options.max_substeps = static_cast<int>(value);
+        } else if (arg == "--no-interpolate") {
+            options.interpolate = false;
+        } else if (arg == "--lod" && i + 1 < argc) {
+            const std::string mode = argv[++i];
+            if (mode == "off") {
+                options.lod = RenderLod::Off;
+            } else if (mode == "decimate") {
+                options.lod = RenderLod::Decimate;
+            } else if (mode == "density") {
+                options.lod = RenderLod::Density;
+            } else {
+                std::cout << "Error: invalid level of detail '" << mode << "' (off, decimate, density)\n";
+                return 1;
+            }
+        } else if (arg == "--render-budget" && i + 1 < argc) {
+            if (!parseUnsigned(argv[++i], value) || value < 1 || value > 100000000) {
+                std::cout << "Error: invalid render budget '" << argv[i] << "'\n";
+                return 1;
+            }
+            options.render_budget = static_cast<int>(value);
+        } else if (arg == "--help" || arg == "-h") {
+            printUsage(argv[0]);
+            return 0;
+        } else {
+            std::cout << "Error: unknown option '" << arg << "'\n";
+            printUsage(argv[0]);
+            return 1;
         }
     }
     
-    if (headless) {
-        runHeadlessMode();
-        return 0;
+    if (options.compute_check > 0 && (options.frames == 0 || !options.compute_device)) {
+        std::cout << "Error: --compute-check needs --frames and --compute opencl\n";
+        return 1;
     }
     
-    // Original graphical mode
-    // Debug: Print SFML version
-    std::cout << "SFML Version: " << SFML_VERSION_MAJOR << "." << SFML_VERSION_MINOR << "." << SFML_VERSION_PATCH << std::endl;
-    
-    // Create window with version-specific API
-#if SFML_VERSION_MAJOR >= 3
-    // SFML 3.x API
-    sf::RenderWindow window(sf::VideoMode(sf::Vector2u(WINDOW_WIDTH, WINDOW_HEIGHT)), 
-                           "Brownian Motion Simulation - C++ Zero Cost Conf Demo");
-#else
-    // SFML 2.x API  
-    sf::RenderWindow window(sf::VideoMode(WINDOW_WIDTH, WINDOW_HEIGHT), 
-                           "Brownian Motion Simulation - C++ Zero Cost Conf Demo");
-#endif
-    
-    window.setFramerateLimit(120); // Lock to 120 FPS for consistent performance comparison
-    window.setVerticalSyncEnabled(false); // Disable V-Sync
+    if (options.ensemble > 0 || !options.sweep_path.empty()) {
+        if (options.frames == 0 || (options.ensemble > 0 && !options.sweep_path.empty())) {
+            std::cout << "Error: --ensemble or --sweep (not both) needs --frames\n";
+            return 1;
+        }
+        if (options.domain_columns > 0 || options.perf_counters || options.compute_device ||
+            !options.trajectory_path.empty() || !options.checkpoint_path.empty() || !options.resume_path.empty() ||
+            options.metrics_port > 0) {
+            std::cout << "Error: --ensemble and --sweep do not support --domains, --perf-counters, --compute opencl, "
+                         "--trajectory, --checkpoint, --resume or --metrics-port\n";
+            return 1;
+        }
+        int result = runEnsembleMode(options);
+        writeTrace(options);
+        return result;
+    }
     
-    if (!window.isOpen()) {
-        std::cout << "Error: Could not create window!" << std::endl;
-        return -1;
+    if (options.domain_columns > 0) {
+        if (options.frames == 0) {
+            std::cout << "Error: --domains needs --frames\n";
+            return 1;
+        }
+        if (options.interactions || options.perf_counters || options.compute_device ||
+            !options.trajectory_path.empty() || !options.checkpoint_path.empty() || !options.resume_path.empty()) {
+            std::cout << "Error: --domains does not support --interactions, --perf-counters, --compute opencl, "
+                         "--trajectory, --checkpoint or --resume\n";
+            return 1;
+        }
+        int result = runDomainMode(options, &argc, &argv);
+        writeTrace(options);
+        return result;
     }
     
-    // Initialize components
-    BrownianSimulation simulation(WINDOW_WIDTH, WINDOW_HEIGHT, PARTICLE_COUNT);
-    FPSCounter fps_counter;
+    if (options.frames > 0) {
+        int result = runBenchmarkMode(options);
+        writeTrace(options);
+        return result;
+    }
     
-    if (!fps_counter.initialize()) {
-        std::cout << "Warning: Could not load font for FPS counter\n";
+    if (options.headless) {
+        int result = runHeadlessMode(options);
+        writeTrace(options);
+        return result;
     }
     
-    // Timing variables
-    auto last_time = std::chrono::high_resolution_clock::now();
+#if defined(BROWNIAN_VIEWER)
+    if (!options.trajectory_path.empty() || !options.checkpoint_path.empty() || options.metrics_port > 0) {
+        std::cout << "Error: --trajectory, --checkpoint and --metrics-port work in headless runs only "
+                     "(add --no-visualize or --frames)\n";
+        return 1;
+    }
+    BrownianSimulation simulation(WINDOW_WIDTH, WINDOW_HEIGHT, options.particles, options.seed, options.obstacles);
+    ThreadPool thread_pool(options.threads);
+    if (!configureSimulation(simulation, thread_pool, options)) {
+        return 1;
+    }
+    setupPerfCounters(simulation, options);
     
-    std::cout << "Brownian Motion Simulation Started\n";
-    std::cout << "Particles: " << simulation.getParticleCount() << "\n";
-    std::cout << "Window: " << WINDOW_WIDTH << "x" << WINDOW_HEIGHT << "\n";
-    std::cout << "Press ESC to exit, SPACE to reset\n";
+    ViewerOptions viewer_options;
+    viewer_options.pipelined = !options.serial_render;
+    if (options.delta_time > 0.0f) {
+        viewer_options.timestep = options.delta_time;
+    }
+    viewer_options.max_substeps = options.max_substeps;
+    viewer_options.interpolate = options.interpolate;
+    viewer_options.lod = options.lod;
+    viewer_options.render_budget = options.render_budget;
     
-    // Main game loop
-    while (window.isOpen()) {
-        // Calculate delta time
-        auto current_time = std::chrono::high_resolution_clock::now();
-        float delta_time = std::chrono::duration<float>(current_time - last_time).count();
-        last_time = current_time;
-        
-        // Handle events with version-specific API
-#if SFML_VERSION_MAJOR >= 3
-        // SFML 3.x event handling
-        while (auto event = window.pollEvent()) {
-            if (event->is<sf::Event::Closed>()) {
-                std::cout << "Window closed by user\n";
-                window.close();
-            }
-            
-            if (event->is<sf::Event::KeyPressed>()) {
-                auto key_event = event->getIf<sf::Event::KeyPressed>();
-                if (key_event->code == sf::Keyboard::Key::Escape) {
-                    std::cout << "Escape pressed - exiting\n";
-                    window.close();
-                } else if (key_event->code == sf::Keyboard::Key::Space) {
-                    simulation.resetParticles();
-                    std::cout << "Simulation reset\n";
-                }
-            }
-        }
+    int result = Viewer::run(simulation, thread_pool, viewer_options);
+    writeTrace(options);
+    return result;
 #else
-        // SFML 2.x event handling
-        sf::Event event;
-        while (window.pollEvent(event)) {
-            if (event.type == sf::Event::Closed) {
-                std::cout << "Window closed by user\n";
-                window.close();
-            }
-            
-            if (event.type == sf::Event::KeyPressed) {
-                if (event.key.code == sf::Keyboard::Escape) {
-                    std::cout << "Escape pressed - exiting\n";
-                    window.close();
-                } else if (event.key.code == sf::Keyboard::Space) {
-                    simulation.resetParticles();
-                    std::cout << "Simulation reset\n";
-                }
-            }
-        }
+    // Headless build (no SFML): nothing to draw, so run as --no-visualize
+    std::cout << "Built without the viewer; running headless (see --help for --frames)\n";
+    int result = runHeadlessMode(options);
+    writeTrace(options);
+    return result;
 #endif
-        
-        // Update simulation
-        simulation.update(delta_time);
-        fps_counter.update();
-        
-        // Render everything
-        window.clear(sf::Color::White);
-        
-        simulation.render(window);
-        fps_counter.render(window);
-        
-        window.display();
-    }
-    
-    std::cout << "Simulation ended\n";
-    return 0;
-} 
\ No newline at end of file
+}
@@ -0,0 +1,69 @@
+#include "mapped_file.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define BROWNIAN_HAS_MMAP 1
+#endif
+
+bool MappedFile::open(const std::string& path) {
+    close();
+    error.clear();
+
+#if defined(BROWNIAN_HAS_MMAP)
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = "could not open '" + path + "': " + std::strerror(errno);
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        void* view = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (view != MAP_FAILED) {
+            ::close(fd);
+            bytes = static_cast<const uint8_t*>(view);
+            length = static_cast<std::size_t>(info.st_size);
+            mapped = true;
+            return true;
+        }
+    }
+    ::close(fd);
+#endif
+
+    // No mmap: read the whole file once
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        error = "could not open '" + path + "': " + std::strerror(errno);
+        return false;
+    }
+    uint8_t block[1 << 16];
+    std::size_t count;
+    while ((count = std::fread(block, 1, sizeof(block), file)) > 0) {
+        buffer.insert(buffer.end(), block, block + count);
+    }
+    std::fclose(file);
+    if (buffer.empty()) {
+        error = "'" + path + "' is empty";
+        return false;
+    }
+    bytes = buffer.data();
+    length = buffer.size();
+    return true;
+}
+
+void MappedFile::close() {
+#if defined(BROWNIAN_HAS_MMAP)
+    if (mapped) {
+        munmap(const_cast<uint8_t*>(bytes), length);
+    }
+#endif
+    bytes = nullptr;
+    length = 0;
+    mapped = false;
+    buffer.clear();
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Read-only view of a whole file: memory-mapped where the platform has mmap,
+// otherwise read into memory once. Readers parse straight from data().
+class MappedFile {
+public:
+    MappedFile() : bytes(nullptr), length(0), mapped(false) {}
+    ~MappedFile() { close(); }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const { return bytes != nullptr; }
+    const uint8_t* data() const { return bytes; }
+    std::size_t size() const { return length; }
+    bool isMapped() const { return mapped; }
+    const std::string& getError() const { return error; }
+
+private:
+    const uint8_t* bytes;
+    std::size_t length;
+    bool mapped;
+    std::vector<uint8_t> buffer; // Used when the file could not be mapped
+    std::string error;
+};
@@ -0,0 +1,18 @@
+#include "matrix.h"
+#include <algorithm>
+
+void Matrix::resize(int rows, int cols) {
+    row_count = std::max(rows, 0);
+    col_count = std::max(cols, 0);
+    row_stride = paddedStride(col_count);
+    markModified();
+
+    // assign() reuses the existing buffer when it is large enough
+    storage.assign(static_cast<std::size_t>(row_count) * row_stride, 0.0f);
+}
+
+void Matrix::fill(float value) {
+    for (int i = 0; i < row_count; ++i) {
+        std::fill(row(i), row(i) + col_count, value);
+    }
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "aligned_allocator.h"
+
+// Non-owning view over a row-major block of floats with an explicit row stride.
+// A view of a whole Matrix keeps its alignment guarantees; sub-blocks may not.
+struct MatrixView {
+    float* data;
+    int rows;
+    int cols;
+    int stride; // Distance between rows, in floats
+
+    float* row(int i) const { return data + static_cast<std::size_t>(i) * stride; }
+    float& operator()(int i, int j) const { return row(i)[j]; }
+
+    MatrixView block(int row_offset, int col_offset, int block_rows, int block_cols) const {
+        return {row(row_offset) + col_offset, block_rows, block_cols, stride};
+    }
+};
+
+struct ConstMatrixView {
+    const float* data;
+    int rows;
+    int cols;
+    int stride;
+
+    ConstMatrixView(const float* data, int rows, int cols, int stride)
+        : data(data), rows(rows), cols(cols), stride(stride) {}
+    ConstMatrixView(const MatrixView& view)
+        : data(view.data), rows(view.rows), cols(view.cols), stride(view.stride) {}
+
+    const float* row(int i) const { return data + static_cast<std::size_t>(i) * stride; }
+    float operator()(int i, int j) const { return row(i)[j]; }
+
+    ConstMatrixView block(int row_offset, int col_offset, int block_rows, int block_cols) const {
+        return {row(row_offset) + col_offset, block_rows, block_cols, stride};
+    }
+};
+
+// What is known about a matrix's contents beyond its values; Identity and
+// Diagonal imply a square matrix
+enum class MatrixStructure {
+    General,
+    Identity,
+    Diagonal
+};
+
+// Dense float matrix in one 64-byte aligned, row-major buffer.
+// Rows are padded to a multiple of 16 floats, so every row starts on a cache
+// line and SIMD kernels can use aligned loads at the start of any row.
+// Padding is zero after resize().
+//
+// Every mutable access (resize, fill, non-const data/row/element/view) bumps a
+// version counter and drops the structure tag, so caches such as MatrixProduct
+// can tell when contents may have changed. Writes through a pointer or view
+// obtained earlier are not seen; call markModified() after them.
+class Matrix {
+public:
+    static constexpr int STRIDE_MULTIPLE = 16;
+
+    Matrix() : row_count(0), col_count(0), row_stride(0), version(0), structure(MatrixStructure::General) {}
+    Matrix(int rows, int cols) : Matrix() { resize(rows, cols); }
+
+    // Reshape and zero the contents; keeps the buffer if it is already big enough
+    void resize(int rows, int cols);
+    void fill(float value);
+
+    int getRows() const { return row_count; }
+    int getCols() const { return col_count; }
+    int getStride() const { return row_stride; }
+    bool empty() const { return row_count == 0 || col_count == 0; }
+
+    float* data() { markModified(); return storage.data(); }
+    const float* data() const { return storage.data(); }
+    float* row(int i) { markModified(); return storage.data() + static_cast<std::size_t>(i) * row_stride; }
+    const float* row(int i) const { return storage.data() + static_cast<std::size_t>(i) * row_stride; }
+
+    float& operator()(int i, int j) { return row(i)[j]; }
+    float operator()(int i, int j) const { return row(i)[j]; }
+
+    MatrixView view() { return {data(), row_count, col_count, row_stride}; }
+    ConstMatrixView view() const { return {data(), row_count, col_count, row_stride}; }
+
+    uint64_t getVersion() const { return version; }
+    void markModified() { ++version; structure = MatrixStructure::General; }
+
+    // Tag set by whoever built the contents (e.g. createIdentityMatrix); any
+    // later mutable access resets it to General
+    MatrixStructure getStructure() const { return structure; }
+    void setStructure(MatrixStructure value) { structure = value; }
+
+    static int paddedStride(int cols) {
+        return (cols + STRIDE_MULTIPLE - 1) / STRIDE_MULTIPLE * STRIDE_MULTIPLE;
+    }
+
+private:
+    int row_count;
+    int col_count;
+    int row_stride;
+    uint64_t version;
+    MatrixStructure structure;
+    AlignedVector<float> storage;
+};
@@ -1,19 +1,16 @@
 #include "matrix_operations.h"
+#include "simd_config.h" // SIMD headers for ultra-fast implementation
+#include "gemm.h"
+#include "thread_pool.h"
+#include "frame_arena.h"
+#include "profiler.h"
 #include <random>
 #include <algorithm>
 #include <cmath>
 
-// SIMD headers for ultra-fast implementation
-#if defined(__ARM_NEON) || defined(__ARM_NEON__)
-    #include <arm_neon.h>
-    #define USE_NEON
-#elif defined(__SSE2__) || defined(__SSE3__) || defined(__SSE4_1__) || defined(__AVX__)
-    #include <immintrin.h>
-    #define USE_SSE
-#endif
-
 // Auto-select slow implementation if no flag is specified
-#if !defined(USE_SLOW_MATRIX) && !defined(USE_FAST_MATRIX) && !defined(USE_ULTRA_FAST_MATRIX)
+#if !defined(USE_SLOW_MATRIX) && !defined(USE_FAST_MATRIX) && !defined(USE_ULTRA_FAST_MATRIX) && \
+    !defined(USE_GEMM_MATRIX)
     #define USE_SLOW_MATRIX
 #endif
 
@@ -21,25 +18,24 @@
 #if defined(USE_SLOW_MATRIX)
 
 void MatrixOperations::multiplyMatrices(
-    const std::vector<std::vector<float>>& a,
-    const std::vector<std::vector<float>>& b,
-    std::vector<std::vector<float>>& result) {
+    ConstMatrixView a,
+    ConstMatrixView b,
+    MatrixView result) {
 
-    if (a.empty() || b.empty() || a[0].size() != b.size()) {
+    if (a.rows == 0 || b.rows == 0 || a.cols != b.rows ||
+        result.rows != a.rows || result.cols != b.cols) {
         return;
     }
     
-    int rows_a = a.size();
-    int cols_a = a[0].size();
-    int cols_b = b[0].size();
-
-    result.resize(rows_a, std::vector<float>(cols_b, 0.0f));
+    int rows_a = a.rows;
+    int cols_a = a.cols;
+    int cols_b = b.cols;
 
     for (int i = 0; i < rows_a; ++i) {
         for (int j = 0; j < cols_b; ++j) {
-            result[i][j] = 0.0f;
+            result(i, j) = 0.0f;
             for (int k = 0; k < cols_a; ++k) {
-                result[i][j] += a[i][k] * b[k][j];
+                result(i, j) += a(i, k) * b(k, j);
             }
         }
     }
@@ -49,29 +45,36 @@ void MatrixOperations::multiplyMatrices(
 #elif defined(USE_FAST_MATRIX)
 
 void MatrixOperations::multiplyMatrices(
-    const std::vector<std::vector<float>>& a,
-    const std::vector<std::vector<float>>& b,
-    std::vector<std::vector<float>>& result) {
+    ConstMatrixView a,
+    ConstMatrixView b,
+    MatrixView result) {
     
-    if (a.empty() || b.empty() || a[0].size() != b.size()) {
+    if (a.rows == 0 || b.rows == 0 || a.cols != b.rows ||
+        result.rows != a.rows || result.cols != b.cols) {
         return;
     }
     
-    int rows_a = a.size();
-    int cols_a = a[0].size();
-    int cols_b = b[0].size();
+    int rows_a = a.rows;
+    int cols_a = a.cols;
+    int cols_b = b.cols;
     
-    std::vector<std::vector<float>> b_transposed(cols_b, std::vector<float>(cols_a));
+    // Transposed copy comes from the thread's scratch arena, released on return
+    FrameArena& arena = FrameArena::forThread();
+    FrameArena::Marker scratch(arena);
+    const int bt_stride = Matrix::paddedStride(cols_a);
+    MatrixView b_transposed{arena.allocateArray<float>(static_cast<std::size_t>(cols_b) * bt_stride),
+                            cols_b, cols_a, bt_stride};
     transposeMatrix(b, b_transposed);
     
-    result.resize(rows_a, std::vector<float>(cols_b, 0.0f));
-    
     for (int i = 0; i < rows_a; ++i) {
+        const float* a_row = a.row(i);
         for (int j = 0; j < cols_b; ++j) {
-            result[i][j] = 0.0f;
+            const float* bt_row = b_transposed.row(j);
+            float sum = 0.0f;
             for (int k = 0; k < cols_a; ++k) {
-                result[i][j] += a[i][k] * b_transposed[j][k];
+                sum += a_row[k] * bt_row[k];
             }
+            result(i, j) = sum;
         }
     }
 }
@@ -80,24 +83,28 @@ void MatrixOperations::multiplyMatrices(
 #elif defined(USE_ULTRA_FAST_MATRIX)
 
 void MatrixOperations::multiplyMatrices(
-    const std::vector<std::vector<float>>& a,
-    const std::vector<std::vector<float>>& b,
-    std::vector<std::vector<float>>& result) {
+    ConstMatrixView a,
+    ConstMatrixView b,
+    MatrixView result) {
     
-    if (a.empty() || b.empty() || a[0].size() != b.size()) {
+    if (a.rows == 0 || b.rows == 0 || a.cols != b.rows ||
+        result.rows != a.rows || result.cols != b.cols) {
         return;
     }
     
-    int rows_a = a.size();
-    int cols_a = a[0].size();
-    int cols_b = b[0].size();
+    int rows_a = a.rows;
+    int cols_a = a.cols;
+    int cols_b = b.cols;
     
-    // Transpose matrix B for better cache locality
-    std::vector<std::vector<float>> b_transposed(cols_b, std::vector<float>(cols_a));
+    // Transpose matrix B for better cache locality; rows are padded and 64-byte
+    // aligned. The copy comes from the thread's scratch arena, released on return.
+    FrameArena& arena = FrameArena::forThread();
+    FrameArena::Marker scratch(arena);
+    const int bt_stride = Matrix::paddedStride(cols_a);
+    MatrixView b_transposed{arena.allocateArray<float>(static_cast<std::size_t>(cols_b) * bt_stride),
+                            cols_b, cols_a, bt_stride};
     transposeMatrix(b, b_transposed);
     
-    result.resize(rows_a, std::vector<float>(cols_b, 0.0f));
-    
     // Block size optimized for cache performance
     const int block_size = 64;
     
@@ -109,7 +116,9 @@ void MatrixOperations::multiplyMatrices(
             
             // Inner block multiplication with SIMD
             for (int i = ii; i < max_i; ++i) {
+                const float* a_row = a.row(i);
                 for (int j = jj; j < max_j; ++j) {
+                    const float* bt_row = b_transposed.row(j);
                     
 #if defined(USE_NEON)
                     // ARM NEON implementation
@@ -118,8 +127,8 @@ void MatrixOperations::multiplyMatrices(
                     
                     // Process 4 elements at a time
                     for (; k <= cols_a - 4; k += 4) {
-                        float32x4_t a_vec = vld1q_f32(&a[i][k]);
-                        float32x4_t b_vec = vld1q_f32(&b_transposed[j][k]);
+                        float32x4_t a_vec = vld1q_f32(a_row + k);
+                        float32x4_t b_vec = vld1q_f32(bt_row + k);
                         sum_vec = vmlaq_f32(sum_vec, a_vec, b_vec);
                     }
                     
@@ -129,10 +138,10 @@ void MatrixOperations::multiplyMatrices(
                     
                     // Handle remaining elements
                     for (; k < cols_a; ++k) {
-                        sum += a[i][k] * b_transposed[j][k];
+                        sum += a_row[k] * bt_row[k];
                     }
                     
-                    result[i][j] = sum;
+                    result(i, j) = sum;
                     
 #elif defined(USE_SSE)
                     // Intel SSE implementation
@@ -141,8 +150,9 @@ void MatrixOperations::multiplyMatrices(
                     
                     // Process 4 elements at a time
                     for (; k <= cols_a - 4; k += 4) {
-                        __m128 a_vec = _mm_loadu_ps(&a[i][k]);
-                        __m128 b_vec = _mm_loadu_ps(&b_transposed[j][k]);
+                        // b_transposed is ours and aligned; a may be an arbitrary view
+                        __m128 a_vec = _mm_loadu_ps(a_row + k);
+                        __m128 b_vec = _mm_load_ps(bt_row + k);
                         sum_vec = _mm_add_ps(sum_vec, _mm_mul_ps(a_vec, b_vec));
                     }
                     
@@ -153,10 +163,10 @@ void MatrixOperations::multiplyMatrices(
                     
                     // Handle remaining elements
                     for (; k < cols_a; ++k) {
-                        sum += a[i][k] * b_transposed[j][k];
+                        sum += a_row[k] * bt_row[k];
                     }
                     
-                    result[i][j] = sum;
+                    result(i, j) = sum;
                     
 #else
                     // Fallback: manual unrolling without SIMD
@@ -165,18 +175,18 @@ void MatrixOperations::multiplyMatrices(
                     
                     // Unroll by 4 for better performance
                     for (; k <= cols_a - 4; k += 4) {
-                        sum += a[i][k] * b_transposed[j][k] +
-                               a[i][k+1] * b_transposed[j][k+1] +
-                               a[i][k+2] * b_transposed[j][k+2] +
-                               a[i][k+3] * b_transposed[j][k+3];
+                        sum += a_row[k] * bt_row[k] +
+                               a_row[k+1] * bt_row[k+1] +
+                               a_row[k+2] * bt_row[k+2] +
+                               a_row[k+3] * bt_row[k+3];
                     }
                     
                     // Handle remaining elements
                     for (; k < cols_a; ++k) {
-                        sum += a[i][k] * b_transposed[j][k];
+                        sum += a_row[k] * bt_row[k];
                     }
                     
-                    result[i][j] = sum;
+                    result(i, j) = sum;
 #endif
                 }
             }
@@ -184,42 +194,170 @@ void MatrixOperations::multiplyMatrices(
     }
 }
 
+// --- GEMM IMPLEMENTATION (packed panels + register-blocked FMA microkernel) ---
+#elif defined(USE_GEMM_MATRIX)
+
+void MatrixOperations::multiplyMatrices(
+    ConstMatrixView a,
+    ConstMatrixView b,
+    MatrixView result) {
+    
+    if (a.rows == 0 || b.rows == 0 || a.cols != b.rows ||
+        result.rows != a.rows || result.cols != b.cols) {
+        return;
+    }
+    
+    Gemm::multiply(a, b, result);
+}
+
 #endif
 
-void MatrixOperations::createIdentityMatrix(std::vector<std::vector<float>>& matrix, int size) {
-    matrix.resize(size, std::vector<float>(size, 0.0f));
+void MatrixOperations::multiplyMatrices(
+    const Matrix& a,
+    const Matrix& b,
+    Matrix& result) {
+    
+    if (a.empty() || b.empty() || a.getCols() != b.getRows()) {
+        return;
+    }
+    
+    if (result.getRows() != a.getRows() || result.getCols() != b.getCols()) {
+        result.resize(a.getRows(), b.getCols());
+    }
+    
+    multiplyMatrices(a.view(), b.view(), result.view());
+}
+
+const char* MatrixOperations::getImplementationName() {
+#if defined(USE_SLOW_MATRIX)
+    return "slow";
+#elif defined(USE_FAST_MATRIX)
+    return "fast";
+#elif defined(USE_ULTRA_FAST_MATRIX)
+    return "ultra";
+#else
+    return "gemm";
+#endif
+}
+
+std::size_t MatrixOperations::getScratchBytes(int rows, int cols, int depth) {
+#if defined(USE_FAST_MATRIX) || defined(USE_ULTRA_FAST_MATRIX)
+    (void)rows;
+    return static_cast<std::size_t>(cols) * Matrix::paddedStride(depth) * sizeof(float) + FrameArena::ALIGNMENT;
+#elif defined(USE_GEMM_MATRIX)
+    return Gemm::getScratchBytes(rows, cols, depth);
+#else
+    (void)rows;
+    (void)cols;
+    (void)depth;
+    return 0;
+#endif
+}
+
+void MatrixOperations::multiplyMatrices(
+    const Matrix& a,
+    const Matrix& b,
+    Matrix& result,
+    ThreadPool* pool) {
+    
+    if (a.empty() || b.empty() || a.getCols() != b.getRows()) {
+        return;
+    }
+    
+    if (result.getRows() != a.getRows() || result.getCols() != b.getCols()) {
+        result.resize(a.getRows(), b.getCols());
+    }
+    
+    multiplyMatrices(a.view(), b.view(), result.view(), pool);
+}
+
+void MatrixOperations::multiplyMatrices(
+    ConstMatrixView a,
+    ConstMatrixView b,
+    MatrixView result,
+    ThreadPool* pool) {
+    
+    if (a.rows == 0 || b.rows == 0 || a.cols != b.rows ||
+        result.rows != a.rows || result.cols != b.cols) {
+        return;
+    }
+    
+    const int rows = result.rows;
+    const int cols = result.cols;
+    const long long volume = static_cast<long long>(rows) * cols * a.cols;
+    if (!pool || pool->getThreadCount() == 1 || volume < PARALLEL_MIN_VOLUME) {
+        multiplyMatrices(a, b, result);
+        return;
+    }
+    
+    // Aim for about four tiles per worker so stealing can even out the load
+    const int threads = pool->getThreadCount();
+    const double ideal_edge = std::sqrt(static_cast<double>(rows) * cols / (4.0 * threads));
+    int tile = static_cast<int>(ideal_edge / PARALLEL_TILE_MULTIPLE + 0.5) * PARALLEL_TILE_MULTIPLE;
+    tile = std::min(std::max(tile, PARALLEL_TILE_MULTIPLE), PARALLEL_TILE_MAX);
+    
+    const int tile_rows = (rows + tile - 1) / tile;
+    const int tile_cols = (cols + tile - 1) / tile;
+    
+    // Size every worker's arena for one tile up front, so a worker that picks up
+    // its first tile late in a run does not allocate mid-frame
+    pool->reserveScratch(getScratchBytes(tile, tile, a.cols));
+    
+    // Each tile reads a row band of A and a column band of B and writes only its
+    // own block of the result; every element sees the same k order as before
+    pool->parallelForEach(static_cast<std::size_t>(tile_rows) * tile_cols, [&](std::size_t task, int) {
+        PROFILE_ZONE("MatrixOperations tile");
+        const int ii = static_cast<int>(task / tile_cols) * tile;
+        const int jj = static_cast<int>(task % tile_cols) * tile;
+        const int block_rows = std::min(tile, rows - ii);
+        const int block_cols = std::min(tile, cols - jj);
+        
+        multiplyMatrices(a.block(ii, 0, block_rows, a.cols),
+                         b.block(0, jj, b.rows, block_cols),
+                         result.block(ii, jj, block_rows, block_cols));
+    });
+}
+
+void MatrixOperations::createIdentityMatrix(Matrix& matrix, int size) {
+    matrix.resize(size, size);
     
     for (int i = 0; i < size; ++i) {
-        matrix[i][i] = 1.0f;
+        matrix(i, i) = 1.0f;
     }
+    matrix.setStructure(MatrixStructure::Identity);
 }
 
-void MatrixOperations::createRandomMatrix(std::vector<std::vector<float>>& matrix, int rows, int cols) {
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    static std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+void MatrixOperations::createRandomMatrix(Matrix& matrix, int rows, int cols, std::mt19937& rng) {
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
     
-    matrix.resize(rows, std::vector<float>(cols));
+    matrix.resize(rows, cols);
     
     for (int i = 0; i < rows; ++i) {
         for (int j = 0; j < cols; ++j) {
-            matrix[i][j] = dist(gen);
+            matrix(i, j) = dist(rng);
         }
     }
 }
 
-void MatrixOperations::transposeMatrix(
-    const std::vector<std::vector<float>>& input,
-    std::vector<std::vector<float>>& output) {
-    
+void MatrixOperations::transposeMatrix(const Matrix& input, Matrix& output) {
     if (input.empty()) {
         return;
     }
     
-    int rows = input.size();
-    int cols = input[0].size();
+    if (output.getRows() != input.getCols() || output.getCols() != input.getRows()) {
+        output.resize(input.getCols(), input.getRows());
+    }
     
-    output.resize(cols, std::vector<float>(rows));
+    transposeMatrix(input.view(), output.view());
+}
+
+void MatrixOperations::transposeMatrix(ConstMatrixView input, MatrixView output) {
+    if (input.rows == 0 || output.rows != input.cols || output.cols != input.rows) {
+        return;
+    }
+    
+    int rows = input.rows;
+    int cols = input.cols;
     
     // Блочное транспонирование для лучшей кэш-локальности
     const int block_size = 32;
@@ -231,9 +369,9 @@ void MatrixOperations::transposeMatrix(
             
             for (int ii = i; ii < max_i; ++ii) {
                 for (int jj = j; jj < max_j; ++jj) {
-                    output[jj][ii] = input[ii][jj];
+                    output(jj, ii) = input(ii, jj);
                 }
             }
         }
     }
-}
\ No newline at end of file
+}
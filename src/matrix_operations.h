@@ -1,22 +1,63 @@
 #pragma once
 
-#include <vector>
+#include <cstddef>
+#include <random>
+#include "matrix.h"
+
+class ThreadPool;
 
 class MatrixOperations {
 public:
     // Single matrix multiplication function - implementation varies based on build target
     // This ensures consistent naming in profiler flame graphs across all optimization levels
     static void multiplyMatrices(
-        const std::vector<std::vector<float>>& a,
-        const std::vector<std::vector<float>>& b,
-        std::vector<std::vector<float>>& result
+        const Matrix& a,
+        const Matrix& b,
+        Matrix& result
     );
     
-    // Helper functions
-    static void createIdentityMatrix(std::vector<std::vector<float>>& matrix, int size);
-    static void createRandomMatrix(std::vector<std::vector<float>>& matrix, int rows, int cols);
-    static void transposeMatrix(
-        const std::vector<std::vector<float>>& input,
-        std::vector<std::vector<float>>& output
+    // Same product on caller-owned storage; result must be a.rows x b.cols
+    static void multiplyMatrices(
+        ConstMatrixView a,
+        ConstMatrixView b,
+        MatrixView result
+    );
+    
+    // Tiled parallel product: the result is cut into square tiles (the ii/jj
+    // block loops) which the pool's workers multiply with the implementation
+    // above. Products smaller than PARALLEL_MIN_VOLUME, or a null / one-thread
+    // pool, run single-threaded. Results match the single-threaded call.
+    static void multiplyMatrices(
+        const Matrix& a,
+        const Matrix& b,
+        Matrix& result,
+        ThreadPool* pool
+    );
+    
+    static void multiplyMatrices(
+        ConstMatrixView a,
+        ConstMatrixView b,
+        MatrixView result,
+        ThreadPool* pool
     );
-}; 
\ No newline at end of file
+    
+    // m * n * k below which waking the pool costs more than it saves
+    static constexpr long long PARALLEL_MIN_VOLUME = 128LL * 128 * 128;
+    // Tile edges are multiples of 48, so they split evenly into GEMM micro-tiles
+    // (8, 12) and padded rows (16)
+    static constexpr int PARALLEL_TILE_MULTIPLE = 48;
+    static constexpr int PARALLEL_TILE_MAX = 480;
+    
+    // Build variant: "slow", "fast", "ultra" or "gemm"
+    static const char* getImplementationName();
+    
+    // Scratch arena bytes one single-threaded call of this shape needs
+    static std::size_t getScratchBytes(int rows, int cols, int depth);
+    
+    // Helper functions
+    static void createIdentityMatrix(Matrix& matrix, int size);
+    // Entries uniform in [-1, 1), drawn row by row from rng
+    static void createRandomMatrix(Matrix& matrix, int rows, int cols, std::mt19937& rng);
+    static void transposeMatrix(const Matrix& input, Matrix& output);
+    static void transposeMatrix(ConstMatrixView input, MatrixView output);
+};
@@ -0,0 +1,74 @@
+#include "matrix_product.h"
+#include "matrix_operations.h"
+#include <algorithm>
+
+const Matrix& MatrixProduct::evaluate(const Matrix& a, const Matrix& b, ThreadPool* pool) {
+    ++evaluation_count;
+
+    if (&a == a_matrix && &b == b_matrix &&
+        a.getVersion() == a_version && b.getVersion() == b_version) {
+        return result;
+    }
+
+    if (a.empty() || b.empty() || a.getCols() != b.getRows()) {
+        return result;
+    }
+
+    if (!multiplyStructured(a, b)) {
+        MatrixOperations::multiplyMatrices(a, b, result, pool);
+    }
+
+    ++recompute_count;
+    a_matrix = &a;
+    b_matrix = &b;
+    a_version = a.getVersion();
+    b_version = b.getVersion();
+    return result;
+}
+
+bool MatrixProduct::multiplyStructured(const Matrix& a, const Matrix& b) {
+    const MatrixStructure a_structure = a.getStructure();
+    const MatrixStructure b_structure = b.getStructure();
+    if (a_structure == MatrixStructure::General && b_structure == MatrixStructure::General) {
+        return false;
+    }
+
+    const int rows = a.getRows();
+    const int cols = b.getCols();
+    if (result.getRows() != rows || result.getCols() != cols) {
+        result.resize(rows, cols);
+    }
+    MatrixView out = result.view();
+
+    if (a_structure == MatrixStructure::Identity) {
+        // I * B = B
+        for (int i = 0; i < rows; ++i) {
+            std::copy(b.row(i), b.row(i) + cols, out.row(i));
+        }
+    } else if (b_structure == MatrixStructure::Identity) {
+        // A * I = A
+        for (int i = 0; i < rows; ++i) {
+            std::copy(a.row(i), a.row(i) + cols, out.row(i));
+        }
+    } else if (a_structure == MatrixStructure::Diagonal) {
+        // D * B scales row i of B by d_i
+        for (int i = 0; i < rows; ++i) {
+            const float scale = a(i, i);
+            const float* b_row = b.row(i);
+            float* out_row = out.row(i);
+            for (int j = 0; j < cols; ++j) {
+                out_row[j] = scale * b_row[j];
+            }
+        }
+    } else {
+        // A * D scales column j of A by d_j
+        for (int i = 0; i < rows; ++i) {
+            const float* a_row = a.row(i);
+            float* out_row = out.row(i);
+            for (int j = 0; j < cols; ++j) {
+                out_row[j] = a_row[j] * b(j, j);
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include "matrix.h"
+
+class ThreadPool;
+
+// Memoized product node: evaluate(a, b) recomputes a * b only when an operand
+// is a different matrix or its version changed since the last call, and
+// otherwise hands back the cached result. Operands tagged Identity or Diagonal
+// skip the full multiply (copy / row or column scaling).
+class MatrixProduct {
+public:
+    MatrixProduct() : a_version(0), b_version(0), a_matrix(nullptr), b_matrix(nullptr),
+                      evaluation_count(0), recompute_count(0) {}
+
+    const Matrix& evaluate(const Matrix& a, const Matrix& b, ThreadPool* pool = nullptr);
+
+    // Forget the cached result; the next evaluate() recomputes
+    void invalidate() { a_matrix = nullptr; b_matrix = nullptr; }
+
+    const Matrix& getResult() const { return result; }
+    uint64_t getEvaluationCount() const { return evaluation_count; }
+    uint64_t getRecomputeCount() const { return recompute_count; }
+
+private:
+    Matrix result;
+    uint64_t a_version;
+    uint64_t b_version;
+    const Matrix* a_matrix;
+    const Matrix* b_matrix;
+    uint64_t evaluation_count;
+    uint64_t recompute_count;
+
+    // Cheap paths for tagged operands; false when neither applies
+    bool multiplyStructured(const Matrix& a, const Matrix& b);
+};
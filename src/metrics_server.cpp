@@ -0,0 +1,263 @@
+#include "metrics_server.h"
+#include "frame_stats.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#define BROWNIAN_HAS_SOCKETS 1
+#endif
+
+namespace {
+
+// printf into a fixed buffer; output past the end is dropped
+class BufferWriter {
+public:
+    BufferWriter(char* data, std::size_t capacity) : data(data), capacity(capacity), length(0) {
+        data[0] = '\0';
+    }
+
+#if defined(__GNUC__)
+    __attribute__((format(printf, 2, 3)))
+#endif
+    void print(const char* format, ...) {
+        if (length + 1 >= capacity) {
+            return;
+        }
+        va_list args;
+        va_start(args, format);
+        const int written = std::vsnprintf(data + length, capacity - length, format, args);
+        va_end(args);
+        if (written > 0) {
+            length = std::min(length + static_cast<std::size_t>(written), capacity - 1);
+        }
+    }
+
+    std::size_t size() const { return length; }
+
+private:
+    char* data;
+    std::size_t capacity;
+    std::size_t length;
+};
+
+// A counter family is named without _total in OpenMetrics, with it in the
+// Prometheus text format; its samples end in _total in both
+void printCounterHeader(BufferWriter& out, bool openmetrics, const char* name, const char* help) {
+    const char* suffix = openmetrics ? "" : "_total";
+    out.print("# HELP %s%s %s\n# TYPE %s%s counter\n", name, suffix, help, name, suffix);
+}
+
+void printGauge(BufferWriter& out, const char* name, const char* help, double value) {
+    out.print("# HELP %s %s\n# TYPE %s gauge\n%s %.9g\n", name, help, name, name, value);
+}
+
+// Label value with \, " and newlines escaped
+std::string escapeLabel(const std::string& value) {
+    std::string escaped;
+    for (char c : value) {
+        if (c == '\\' || c == '"') {
+            escaped += '\\';
+            escaped += c;
+        } else if (c == '\n') {
+            escaped += "\\n";
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+} // namespace
+
+MetricsServer::MetricsServer() : listen_fd(-1), stats(nullptr), stopping(false), scrapes(0) {
+}
+
+MetricsServer::~MetricsServer() {
+    stop();
+}
+
+bool MetricsServer::start(int port, const FrameStats& frame_stats, const MetricsInfo& run_info) {
+    stop();
+    error.clear();
+    stats = &frame_stats;
+    info = run_info;
+    labels = "{kernels=\"" + escapeLabel(info.kernels) + "\",compute=\"" + escapeLabel(info.compute) + "\"}";
+
+#if defined(BROWNIAN_HAS_SOCKETS)
+    const int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        error = std::string("could not create a socket: ") + std::strerror(errno);
+        return false;
+    }
+    const int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    if (bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || listen(fd, 8) != 0) {
+        error = "could not listen on port " + std::to_string(port) + ": " + std::strerror(errno);
+        ::close(fd);
+        return false;
+    }
+
+    listen_fd = fd;
+    stopping = false;
+    thread = std::thread([this] { serveLoop(); });
+    return true;
+#else
+    (void)port;
+    error = "the metrics endpoint needs POSIX sockets";
+    return false;
+#endif
+}
+
+void MetricsServer::stop() {
+    if (thread.joinable()) {
+        stopping = true;
+        thread.join();
+    }
+#if defined(BROWNIAN_HAS_SOCKETS)
+    if (listen_fd >= 0) {
+        ::close(listen_fd);
+    }
+#endif
+    listen_fd = -1;
+}
+
+void MetricsServer::serveLoop() {
+#if defined(BROWNIAN_HAS_SOCKETS)
+    while (!stopping.load(std::memory_order_relaxed)) {
+        pollfd listening = {listen_fd, POLLIN, 0};
+        if (poll(&listening, 1, POLL_MS) <= 0) {
+            continue;
+        }
+        const int client = accept(listen_fd, nullptr, nullptr);
+        if (client < 0) {
+            continue;
+        }
+        serveClient(client);
+        ::close(client);
+    }
+#endif
+}
+
+void MetricsServer::serveClient(int client) {
+#if defined(BROWNIAN_HAS_SOCKETS)
+    // A scraper that stops talking must not hold up the next one for long
+    timeval timeout = {1, 0};
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+#if defined(SO_NOSIGPIPE)
+    const int no_sigpipe = 1;
+    setsockopt(client, SOL_SOCKET, SO_NOSIGPIPE, &no_sigpipe, sizeof(no_sigpipe));
+#endif
+#if defined(MSG_NOSIGNAL)
+    const int send_flags = MSG_NOSIGNAL;
+#else
+    const int send_flags = 0;
+#endif
+
+    // Only the request line and the Accept header matter
+    std::size_t received = 0;
+    while (received + 1 < REQUEST_BYTES) {
+        const ssize_t count = recv(client, request + received, REQUEST_BYTES - 1 - received, 0);
+        if (count <= 0) {
+            break;
+        }
+        received += static_cast<std::size_t>(count);
+        request[received] = '\0';
+        if (std::strstr(request, "\r\n\r\n")) {
+            break;
+        }
+    }
+    request[received] = '\0';
+
+    const bool head = std::strncmp(request, "HEAD ", 5) == 0;
+    const bool get = std::strncmp(request, "GET ", 4) == 0;
+    const char* path = request + (head ? 5 : 4);
+    const bool metrics = (get || head) && std::strncmp(path, "/metrics", 8) == 0 &&
+                         (path[8] == ' ' || path[8] == '?');
+    const bool openmetrics = std::strstr(request, "application/openmetrics-text") != nullptr;
+
+    const char* status = "200 OK";
+    const char* content_type = openmetrics ? "application/openmetrics-text; version=1.0.0; charset=utf-8"
+                                           : "text/plain; version=0.0.4; charset=utf-8";
+    std::size_t body_size = 0;
+    if (metrics) {
+        body_size = formatMetrics(openmetrics);
+    } else {
+        status = get || head ? "404 Not Found" : "405 Method Not Allowed";
+        content_type = "text/plain; charset=utf-8";
+        BufferWriter out(body, RESPONSE_BYTES);
+        out.print("Metrics are served at /metrics\n");
+        body_size = out.size();
+    }
+
+    char header[256];
+    const int header_size = std::snprintf(header, sizeof(header),
+                                          "HTTP/1.1 %s\r\nContent-Type: %s\r\nContent-Length: %zu\r\n"
+                                          "Connection: close\r\n\r\n",
+                                          status, content_type, body_size);
+    if (send(client, header, static_cast<std::size_t>(header_size), send_flags) != header_size || head) {
+        return;
+    }
+    std::size_t sent = 0;
+    while (sent < body_size) {
+        const ssize_t count = send(client, body + sent, body_size - sent, send_flags);
+        if (count <= 0) {
+            return;
+        }
+        sent += static_cast<std::size_t>(count);
+    }
+    if (metrics) {
+        scrapes.fetch_add(1, std::memory_order_relaxed);
+    }
+#else
+    (void)client;
+#endif
+}
+
+std::size_t MetricsServer::formatMetrics(bool openmetrics) {
+    const FrameStatsSnapshot snapshot = stats->getSnapshot();
+    BufferWriter out(body, RESPONSE_BYTES);
+
+    printGauge(out, "brownian_fps", "Frames per second over the recent window", snapshot.fps);
+
+    out.print("# HELP brownian_frame_seconds Frame time; quantiles over the last %zu frames\n"
+              "# TYPE brownian_frame_seconds summary\n", FrameStats::WINDOW);
+    const double quantiles[] = {0.5, 0.9, 0.99, 0.999};
+    const double values_ms[] = {snapshot.p50_ms, snapshot.p90_ms, snapshot.p99_ms, snapshot.p999_ms};
+    for (int i = 0; i < 4; ++i) {
+        out.print("brownian_frame_seconds{quantile=\"%g\"} %.9g\n", quantiles[i], values_ms[i] * 1e-3);
+    }
+    out.print("brownian_frame_seconds_sum %.9g\nbrownian_frame_seconds_count %llu\n", snapshot.total_seconds,
+              static_cast<unsigned long long>(snapshot.frames));
+    printGauge(out, "brownian_frame_max_seconds", "Longest frame in the recent window", snapshot.max_ms * 1e-3);
+
+    printCounterHeader(out, openmetrics, "brownian_phase_seconds", "Time spent in each update() phase");
+    out.print("brownian_phase_seconds_total{phase=\"matrix\"} %.9g\n", snapshot.matrix_seconds);
+    out.print("brownian_phase_seconds_total{phase=\"obstacles\"} %.9g\n", snapshot.obstacles_seconds);
+    out.print("brownian_phase_seconds_total{phase=\"particles\"} %.9g\n", snapshot.particles_seconds);
+
+    printGauge(out, "brownian_particles", "Particles simulated", static_cast<double>(info.particles));
+    printGauge(out, "brownian_threads", "Worker threads", info.threads);
+    if (openmetrics) {
+        out.print("# HELP brownian_run Kernels and compute device of the run\n# TYPE brownian_run info\n"
+                  "brownian_run_info%s 1\n# EOF\n", labels.c_str());
+    } else {
+        out.print("# HELP brownian_run_info Kernels and compute device of the run\n"
+                  "# TYPE brownian_run_info gauge\nbrownian_run_info%s 1\n", labels.c_str());
+    }
+    return out.size();
+}
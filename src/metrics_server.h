@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+class FrameStats;
+
+// Fixed facts about the run, exported next to the frame figures
+struct MetricsInfo {
+    std::size_t particles = 0;
+    int threads = 1;
+    std::string kernels; // ParticleKernels instruction set
+    std::string compute = "cpu";
+};
+
+// Minimal HTTP endpoint serving GET /metrics in the Prometheus text format,
+// or OpenMetrics when the scraper asks for it, from a FrameStats snapshot:
+// FPS, frame time quantiles over the recent window, and frame and per-phase
+// time totals for rate().
+//
+// One background thread accepts and answers scrapes one at a time. It only
+// reads getSnapshot(), so the frame loop never waits on a scrape, and it
+// formats into fixed buffers: no allocation can land inside update() and
+// trip the Debug allocation check. Needs POSIX sockets; elsewhere start()
+// fails.
+class MetricsServer {
+public:
+    MetricsServer();
+    ~MetricsServer();
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    // Listen on port on every interface; stats must outlive stop()
+    bool start(int port, const FrameStats& stats, const MetricsInfo& info);
+    void stop();
+
+    bool isRunning() const { return listen_fd >= 0; }
+    const std::string& getError() const { return error; }
+    uint64_t getScrapeCount() const { return scrapes.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr int POLL_MS = 100; // How often the thread checks for stop()
+    static constexpr std::size_t REQUEST_BYTES = 4096;
+    static constexpr std::size_t RESPONSE_BYTES = 8192;
+
+    int listen_fd;
+    std::string error;
+    const FrameStats* stats;
+    MetricsInfo info;
+    std::string labels; // Run info label set, formatted once in start()
+    std::thread thread;
+    std::atomic<bool> stopping;
+    std::atomic<uint64_t> scrapes;
+    char request[REQUEST_BYTES];
+    char body[RESPONSE_BYTES];
+
+    void serveLoop();
+    void serveClient(int client);
+    std::size_t formatMetrics(bool openmetrics);
+};
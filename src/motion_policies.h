@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include "particle_store.h"
+#include "particle_kernels.h"
+#include "counter_rng.h"
+
+// What happens at the world edges
+enum class BoundaryMode : uint8_t { Reflect, Periodic, Absorb };
+// Distribution of the per-frame velocity kicks
+enum class NoiseMode : uint8_t { Uniform, Gaussian };
+
+// Compile-time pieces of the particle step. BrownianSimulation instantiates
+// its per-range update for every combination of boundary, noise, color
+// jitter and obstacles, and picks the matching instantiation when the
+// configuration changes; the hot loop of a run then has no branches for
+// features it does not use, and these constants fold into it.
+namespace MotionPolicy {
+
+// Step coefficients, per second of simulated time
+constexpr float NOISE_SCALE = 2.0f;      // Make the motion more pronounced
+constexpr float DAMPING = 0.992f;        // Per step; more damping (was 0.995f)
+constexpr float POSITION_SCALE = 40.0f;  // Reduced from 60.0f
+constexpr float NOISE_AMPLITUDE = 50.0f; // Uniform kicks in [-A, A)
+
+// Slow color drift: a particle changes color when its roll exceeds the threshold
+constexpr float COLOR_CHANGE_THRESHOLD = 0.98f;
+constexpr int COLOR_STEP = 10;
+constexpr int COLOR_MAX = 200; // Darker colors for white background
+
+// Names as on the command line and in benchmark reports
+inline const char* boundaryName(BoundaryMode mode) {
+    switch (mode) {
+        case BoundaryMode::Periodic: return "periodic";
+        case BoundaryMode::Absorb: return "absorb";
+        default: return "reflect";
+    }
+}
+
+inline const char* noiseName(NoiseMode mode) {
+    return mode == NoiseMode::Gaussian ? "gaussian" : "uniform";
+}
+
+// Bounce off walls (softer bouncing, was -0.7f)
+struct ReflectBoundary {
+    static constexpr float RESTITUTION = -0.4f;
+
+    static void apply(ParticleStore& particles, float width, float height, std::size_t begin, std::size_t end) {
+        ParticleKernels::bounceWalls(particles, width, height, RESTITUTION, begin, end);
+    }
+};
+
+// Walls take all the normal momentum: a particle that reaches one stays on
+// it until the noise carries it back in
+struct AbsorbBoundary {
+    static constexpr float RESTITUTION = 0.0f;
+
+    static void apply(ParticleStore& particles, float width, float height, std::size_t begin, std::size_t end) {
+        ParticleKernels::bounceWalls(particles, width, height, RESTITUTION, begin, end);
+    }
+};
+
+// Opposite edges are joined: a center leaving one side re-enters on the
+// other, in [0, extent). Assumes a step moves less than one world extent.
+struct PeriodicBoundary {
+    static void apply(ParticleStore& particles, float width, float height, std::size_t begin, std::size_t end) {
+        wrapAxis(particles.pos_x.data(), width, begin, end);
+        wrapAxis(particles.pos_y.data(), height, begin, end);
+    }
+
+    // Two selects and no branch, so the compiler vectorizes it at any width
+    static void wrapAxis(float* pos, float extent, std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            float p = pos[i];
+            p += p < 0.0f ? extent : 0.0f;
+            p -= p >= extent ? extent : 0.0f;
+            pos[i] = p;
+        }
+    }
+};
+
+// Kicks uniform in [-NOISE_AMPLITUDE, NOISE_AMPLITUDE), straight from the SIMD Philox kernel
+struct UniformNoise {
+    static void generate(const CounterRng& rng, uint64_t frame, const uint32_t* ids,
+                         float* noise_x, float* noise_y, float* color_roll, std::size_t begin, std::size_t end) {
+        ParticleKernels::generateMotionNoise(rng, frame, -NOISE_AMPLITUDE, NOISE_AMPLITUDE, ids,
+                                             noise_x, noise_y, color_roll, begin, end);
+    }
+};
+
+// Gaussian kicks with the uniform policy's standard deviation (2A / sqrt(12)):
+// Box-Muller over the same Philox words, so the color roll is unchanged
+struct GaussianNoise {
+    static constexpr float SIGMA = 2.0f * NOISE_AMPLITUDE / 3.46410162f;
+    static constexpr float TWO_PI = 6.28318531f;
+
+    static void generate(const CounterRng& rng, uint64_t frame, const uint32_t* ids,
+                         float* noise_x, float* noise_y, float* color_roll, std::size_t begin, std::size_t end) {
+        ParticleKernels::generateMotionNoise(rng, frame, 0.0f, 1.0f, ids, noise_x, noise_y, color_roll, begin, end);
+        for (std::size_t i = begin; i < end; ++i) {
+            // 1 - u is in (0, 1], so the log is finite
+            const float radius = SIGMA * std::sqrt(-2.0f * std::log(1.0f - noise_x[i]));
+            const float angle = TWO_PI * noise_y[i];
+            noise_x[i] = radius * std::cos(angle);
+            noise_y[i] = radius * std::sin(angle);
+        }
+    }
+};
+
+} // namespace MotionPolicy
@@ -0,0 +1,364 @@
+#include "obstacle_kernels.h"
+#include "obstacle_system.h"
+#include "simd_config.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+using SweepFn = int (*)(const ObstacleTransforms&, const int*, int, const Vec2f&, const Vec2f&, float, float&);
+using OverlapFn = uint32_t (*)(const ObstacleTransforms&, const int*, int, const Vec2f&, float);
+
+// Times are fractions of the step; a shape the step misses reports this
+constexpr float MISS = 2.0f;
+
+// --- SCALAR IMPLEMENTATION (one lane at a time) ---
+
+// One slab of sweepBox(): entry and exit times of o + t * d into |x| <= e
+void sweepSlabScalar(float o, float d, float e, float& t_enter, float& t_exit, bool& entered, bool& miss) {
+    if (d == 0.0f) {
+        miss = miss || std::abs(o) > e;
+        return;
+    }
+    const float near_face = d > 0.0f ? -e : e;
+    const float t_near = (near_face - o) / d;
+    const float t_far = (-near_face - o) / d;
+    if (t_near > t_enter) {
+        t_enter = t_near;
+        entered = true;
+    }
+    t_exit = std::min(t_exit, t_far);
+}
+
+// Entry time of p + t * d into the box |x| <= hx, |y| <= hy; MISS when the
+// segment misses it or starts inside. An early exit after the first slab
+// would give the same answer: t_enter only grows and t_exit only shrinks.
+float sweepBoxScalar(float px, float py, float dx, float dy, float hx, float hy) {
+    float t_enter = 0.0f;
+    float t_exit = 1.0f;
+    bool entered = false;
+    bool miss = false;
+    sweepSlabScalar(px, dx, hx, t_enter, t_exit, entered, miss);
+    sweepSlabScalar(py, dy, hy, t_enter, t_exit, entered, miss);
+    return miss || !entered || t_enter > t_exit ? MISS : t_enter;
+}
+
+// Entry time of p + t * d into the circle |x - c| <= r; MISS when it starts
+// inside, moves away or passes by
+float sweepCircleScalar(float px, float py, float dx, float dy, float cx, float cy, float r) {
+    const float mx = px - cx;
+    const float my = py - cy;
+    const float a = dx * dx + dy * dy;
+    const float b = mx * dx + my * dy;
+    const float k = mx * mx + my * my - r * r;
+    const float discriminant = b * b - a * k;
+    if (k <= 0.0f || b >= 0.0f || discriminant < 0.0f) {
+        return MISS;
+    }
+    return (-b - std::sqrt(discriminant)) / a;
+}
+
+// Earliest entry of the step into the rounded rectangle of one obstacle, as
+// ObstacleSystem::checkLineRectangleCollision computes it
+float sweepLaneScalar(const ObstacleTransforms& transforms, int index,
+                      const Vec2f& start, const Vec2f& end, float radius) {
+    const float center_x = transforms.center_x[index];
+    const float center_y = transforms.center_y[index];
+    const float cos_a = transforms.cos_rotation[index];
+    const float sin_a = -transforms.sin_rotation[index]; // Into local space
+    const float half_width = transforms.half_width[index];
+    const float half_height = transforms.half_height[index];
+
+    const float start_x = start.x - center_x;
+    const float start_y = start.y - center_y;
+    const float end_x = end.x - center_x;
+    const float end_y = end.y - center_y;
+    const float local_x = start_x * cos_a - start_y * sin_a;
+    const float local_y = start_x * sin_a + start_y * cos_a;
+    const float motion_x = (end_x * cos_a - end_y * sin_a) - local_x;
+    const float motion_y = (end_x * sin_a + end_y * cos_a) - local_y;
+
+    const float outside_x = std::max(std::abs(local_x) - half_width, 0.0f);
+    const float outside_y = std::max(std::abs(local_y) - half_height, 0.0f);
+    if (outside_x * outside_x + outside_y * outside_y < radius * radius) {
+        return MISS;
+    }
+
+    float t = sweepBoxScalar(local_x, local_y, motion_x, motion_y, half_width + radius, half_height);
+    t = std::min(t, sweepBoxScalar(local_x, local_y, motion_x, motion_y, half_width, half_height + radius));
+    t = std::min(t, sweepCircleScalar(local_x, local_y, motion_x, motion_y, -half_width, -half_height, radius));
+    t = std::min(t, sweepCircleScalar(local_x, local_y, motion_x, motion_y, half_width, -half_height, radius));
+    t = std::min(t, sweepCircleScalar(local_x, local_y, motion_x, motion_y, -half_width, half_height, radius));
+    t = std::min(t, sweepCircleScalar(local_x, local_y, motion_x, motion_y, half_width, half_height, radius));
+    return t;
+}
+
+// The AABB reject and overlap test of the overlap pass, as
+// ObstacleSystem::checkPointRectangleCollision computes it
+bool overlapLaneScalar(const ObstacleTransforms& transforms, int index, const Vec2f& point, float radius) {
+    if (point.x < transforms.aabb_min_x[index] || point.x > transforms.aabb_max_x[index] ||
+        point.y < transforms.aabb_min_y[index] || point.y > transforms.aabb_max_y[index]) {
+        return false;
+    }
+    const float cos_a = transforms.cos_rotation[index];
+    const float sin_a = -transforms.sin_rotation[index];
+    const float half_width = transforms.half_width[index];
+    const float half_height = transforms.half_height[index];
+
+    const float offset_x = point.x - transforms.center_x[index];
+    const float offset_y = point.y - transforms.center_y[index];
+    const float local_x = offset_x * cos_a - offset_y * sin_a;
+    const float local_y = offset_x * sin_a + offset_y * cos_a;
+    const float outside_x = local_x - std::clamp(local_x, -half_width, half_width);
+    const float outside_y = local_y - std::clamp(local_y, -half_height, half_height);
+    return outside_x * outside_x + outside_y * outside_y < radius * radius;
+}
+
+// The first lane strictly below time_of_impact with the smallest time, the
+// order in which the per-obstacle loop would have accepted it
+int pickEarliest(const float* times, int count, float& time_of_impact) {
+    int first = -1;
+    for (int lane = 0; lane < count; ++lane) {
+        if (times[lane] < time_of_impact) {
+            time_of_impact = times[lane];
+            first = lane;
+        }
+    }
+    return first;
+}
+
+int sweepScalar(const ObstacleTransforms& transforms, const int* indices, int count,
+                const Vec2f& start, const Vec2f& end, float radius, float& time_of_impact) {
+    float times[ObstacleKernels::BATCH];
+    for (int lane = 0; lane < count; ++lane) {
+        times[lane] = sweepLaneScalar(transforms, indices[lane], start, end, radius);
+    }
+    return pickEarliest(times, count, time_of_impact);
+}
+
+uint32_t overlapScalar(const ObstacleTransforms& transforms, const int* indices, int count,
+                       const Vec2f& point, float radius) {
+    uint32_t hits = 0;
+    for (int lane = 0; lane < count; ++lane) {
+        hits |= static_cast<uint32_t>(overlapLaneScalar(transforms, indices[lane], point, radius)) << lane;
+    }
+    return hits;
+}
+
+// --- AVX2 IMPLEMENTATION (8 obstacles per call) ---
+#if defined(HAVE_AVX2_DISPATCH)
+
+// No FMA here: every lane has to round like the scalar tests above (and the
+// OpenCL kernel), or a batch could pick a different obstacle than the loop
+
+SIMD_TARGET_AVX2_NO_FMA
+inline __m256i laneMaskAvx2(int count) {
+    return _mm256_cmpgt_epi32(_mm256_set1_epi32(count), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+}
+
+SIMD_TARGET_AVX2_NO_FMA
+inline __m256 negateAvx2(__m256 v) {
+    return _mm256_xor_ps(v, _mm256_set1_ps(-0.0f));
+}
+
+SIMD_TARGET_AVX2_NO_FMA
+inline __m256 absAvx2(__m256 v) {
+    return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), v);
+}
+
+// Unused lanes were loaded as index 0, so the gathers stay in bounds
+SIMD_TARGET_AVX2_NO_FMA
+inline __m256 gatherAvx2(const std::vector<float>& values, __m256i indices) {
+    return _mm256_i32gather_ps(values.data(), indices, 4);
+}
+
+// Obstacle fields of a batch, one lane per obstacle
+struct ObstacleLanesAvx2 {
+    __m256 valid; // Lanes [0, count)
+    __m256 center_x;
+    __m256 center_y;
+    __m256 cos_a;
+    __m256 sin_a; // Negated: rotates into local space
+    __m256 half_width;
+    __m256 half_height;
+
+    SIMD_TARGET_AVX2_NO_FMA
+    ObstacleLanesAvx2(const ObstacleTransforms& transforms, const int* indices, int count) {
+        const __m256i mask = laneMaskAvx2(count);
+        const __m256i lanes = _mm256_maskload_epi32(indices, mask);
+        valid = _mm256_castsi256_ps(mask);
+        center_x = gatherAvx2(transforms.center_x, lanes);
+        center_y = gatherAvx2(transforms.center_y, lanes);
+        cos_a = gatherAvx2(transforms.cos_rotation, lanes);
+        sin_a = negateAvx2(gatherAvx2(transforms.sin_rotation, lanes));
+        half_width = gatherAvx2(transforms.half_width, lanes);
+        half_height = gatherAvx2(transforms.half_height, lanes);
+    }
+};
+
+SIMD_TARGET_AVX2_NO_FMA
+inline void sweepSlabAvx2(__m256 o, __m256 d, __m256 e, __m256& t_enter, __m256& t_exit,
+                          __m256& entered, __m256& miss) {
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 still = _mm256_cmp_ps(d, zero, _CMP_EQ_OQ);
+    miss = _mm256_or_ps(miss, _mm256_and_ps(still, _mm256_cmp_ps(absAvx2(o), e, _CMP_GT_OQ)));
+
+    // Still lanes divide by zero here; their results are blended away
+    const __m256 near_face = _mm256_blendv_ps(e, negateAvx2(e), _mm256_cmp_ps(d, zero, _CMP_GT_OQ));
+    const __m256 t_near = _mm256_div_ps(_mm256_sub_ps(near_face, o), d);
+    const __m256 t_far = _mm256_div_ps(_mm256_sub_ps(negateAvx2(near_face), o), d);
+    const __m256 later = _mm256_andnot_ps(still, _mm256_cmp_ps(t_near, t_enter, _CMP_GT_OQ));
+    t_enter = _mm256_blendv_ps(t_enter, t_near, later);
+    entered = _mm256_or_ps(entered, later);
+    t_exit = _mm256_blendv_ps(_mm256_min_ps(t_far, t_exit), t_exit, still);
+}
+
+SIMD_TARGET_AVX2_NO_FMA
+inline __m256 sweepBoxAvx2(__m256 px, __m256 py, __m256 dx, __m256 dy, __m256 hx, __m256 hy) {
+    __m256 t_enter = _mm256_setzero_ps();
+    __m256 t_exit = _mm256_set1_ps(1.0f);
+    __m256 entered = _mm256_setzero_ps();
+    __m256 miss = _mm256_setzero_ps();
+    sweepSlabAvx2(px, dx, hx, t_enter, t_exit, entered, miss);
+    sweepSlabAvx2(py, dy, hy, t_enter, t_exit, entered, miss);
+    miss = _mm256_or_ps(_mm256_or_ps(miss, _mm256_cmp_ps(t_enter, t_exit, _CMP_GT_OQ)),
+                        _mm256_andnot_ps(entered, _mm256_castsi256_ps(_mm256_set1_epi32(-1))));
+    return _mm256_blendv_ps(t_enter, _mm256_set1_ps(MISS), miss);
+}
+
+// a = |d|^2 and r2 = r * r are shared by the four corners
+SIMD_TARGET_AVX2_NO_FMA
+inline __m256 sweepCircleAvx2(__m256 px, __m256 py, __m256 dx, __m256 dy, __m256 a,
+                              __m256 cx, __m256 cy, __m256 r2) {
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 mx = _mm256_sub_ps(px, cx);
+    const __m256 my = _mm256_sub_ps(py, cy);
+    const __m256 b = _mm256_add_ps(_mm256_mul_ps(mx, dx), _mm256_mul_ps(my, dy));
+    const __m256 k = _mm256_sub_ps(_mm256_add_ps(_mm256_mul_ps(mx, mx), _mm256_mul_ps(my, my)), r2);
+    const __m256 discriminant = _mm256_sub_ps(_mm256_mul_ps(b, b), _mm256_mul_ps(a, k));
+    const __m256 miss = _mm256_or_ps(_mm256_or_ps(_mm256_cmp_ps(k, zero, _CMP_LE_OQ), _mm256_cmp_ps(b, zero, _CMP_GE_OQ)),
+                                     _mm256_cmp_ps(discriminant, zero, _CMP_LT_OQ));
+    const __m256 t = _mm256_div_ps(_mm256_sub_ps(negateAvx2(b), _mm256_sqrt_ps(discriminant)), a);
+    return _mm256_blendv_ps(t, _mm256_set1_ps(MISS), miss);
+}
+
+SIMD_TARGET_AVX2_NO_FMA
+int sweepAvx2(const ObstacleTransforms& transforms, const int* indices, int count,
+              const Vec2f& start, const Vec2f& end, float radius, float& time_of_impact) {
+    const ObstacleLanesAvx2 obstacle(transforms, indices, count);
+    const __m256 r = _mm256_set1_ps(radius);
+    const __m256 r2 = _mm256_set1_ps(radius * radius);
+
+    const __m256 start_x = _mm256_sub_ps(_mm256_set1_ps(start.x), obstacle.center_x);
+    const __m256 start_y = _mm256_sub_ps(_mm256_set1_ps(start.y), obstacle.center_y);
+    const __m256 end_x = _mm256_sub_ps(_mm256_set1_ps(end.x), obstacle.center_x);
+    const __m256 end_y = _mm256_sub_ps(_mm256_set1_ps(end.y), obstacle.center_y);
+    const __m256 px = _mm256_sub_ps(_mm256_mul_ps(start_x, obstacle.cos_a), _mm256_mul_ps(start_y, obstacle.sin_a));
+    const __m256 py = _mm256_add_ps(_mm256_mul_ps(start_x, obstacle.sin_a), _mm256_mul_ps(start_y, obstacle.cos_a));
+    const __m256 dx = _mm256_sub_ps(
+        _mm256_sub_ps(_mm256_mul_ps(end_x, obstacle.cos_a), _mm256_mul_ps(end_y, obstacle.sin_a)), px);
+    const __m256 dy = _mm256_sub_ps(
+        _mm256_add_ps(_mm256_mul_ps(end_x, obstacle.sin_a), _mm256_mul_ps(end_y, obstacle.cos_a)), py);
+
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 outside_x = _mm256_max_ps(_mm256_sub_ps(absAvx2(px), obstacle.half_width), zero);
+    const __m256 outside_y = _mm256_max_ps(_mm256_sub_ps(absAvx2(py), obstacle.half_height), zero);
+    const __m256 inside = _mm256_cmp_ps(
+        _mm256_add_ps(_mm256_mul_ps(outside_x, outside_x), _mm256_mul_ps(outside_y, outside_y)), r2, _CMP_LT_OQ);
+
+    const __m256 hw = obstacle.half_width;
+    const __m256 hh = obstacle.half_height;
+    const __m256 a = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+    __m256 t = sweepBoxAvx2(px, py, dx, dy, _mm256_add_ps(hw, r), hh);
+    t = _mm256_min_ps(t, sweepBoxAvx2(px, py, dx, dy, hw, _mm256_add_ps(hh, r)));
+    t = _mm256_min_ps(t, sweepCircleAvx2(px, py, dx, dy, a, negateAvx2(hw), negateAvx2(hh), r2));
+    t = _mm256_min_ps(t, sweepCircleAvx2(px, py, dx, dy, a, hw, negateAvx2(hh), r2));
+    t = _mm256_min_ps(t, sweepCircleAvx2(px, py, dx, dy, a, negateAvx2(hw), hh, r2));
+    t = _mm256_min_ps(t, sweepCircleAvx2(px, py, dx, dy, a, hw, hh, r2));
+    t = _mm256_blendv_ps(_mm256_set1_ps(MISS), t, _mm256_andnot_ps(inside, obstacle.valid));
+
+    // Most batches hit nothing: one compare for all eight
+    if (_mm256_movemask_ps(_mm256_cmp_ps(t, _mm256_set1_ps(time_of_impact), _CMP_LT_OQ)) == 0) {
+        return -1;
+    }
+    alignas(32) float times[ObstacleKernels::BATCH];
+    _mm256_store_ps(times, t);
+    return pickEarliest(times, count, time_of_impact);
+}
+
+SIMD_TARGET_AVX2_NO_FMA
+uint32_t overlapAvx2(const ObstacleTransforms& transforms, const int* indices, int count,
+                     const Vec2f& point, float radius) {
+    const __m256i lanes = _mm256_maskload_epi32(indices, laneMaskAvx2(count));
+    const __m256 x = _mm256_set1_ps(point.x);
+    const __m256 y = _mm256_set1_ps(point.y);
+    const __m256 outside_box = _mm256_or_ps(
+        _mm256_or_ps(_mm256_cmp_ps(x, gatherAvx2(transforms.aabb_min_x, lanes), _CMP_LT_OQ),
+                     _mm256_cmp_ps(x, gatherAvx2(transforms.aabb_max_x, lanes), _CMP_GT_OQ)),
+        _mm256_or_ps(_mm256_cmp_ps(y, gatherAvx2(transforms.aabb_min_y, lanes), _CMP_LT_OQ),
+                     _mm256_cmp_ps(y, gatherAvx2(transforms.aabb_max_y, lanes), _CMP_GT_OQ)));
+
+    const ObstacleLanesAvx2 obstacle(transforms, indices, count);
+    const __m256 offset_x = _mm256_sub_ps(x, obstacle.center_x);
+    const __m256 offset_y = _mm256_sub_ps(y, obstacle.center_y);
+    const __m256 local_x = _mm256_sub_ps(_mm256_mul_ps(offset_x, obstacle.cos_a), _mm256_mul_ps(offset_y, obstacle.sin_a));
+    const __m256 local_y = _mm256_add_ps(_mm256_mul_ps(offset_x, obstacle.sin_a), _mm256_mul_ps(offset_y, obstacle.cos_a));
+    const __m256 outside_x = _mm256_sub_ps(
+        local_x, _mm256_min_ps(_mm256_max_ps(local_x, negateAvx2(obstacle.half_width)), obstacle.half_width));
+    const __m256 outside_y = _mm256_sub_ps(
+        local_y, _mm256_min_ps(_mm256_max_ps(local_y, negateAvx2(obstacle.half_height)), obstacle.half_height));
+    const __m256 overlap = _mm256_cmp_ps(
+        _mm256_add_ps(_mm256_mul_ps(outside_x, outside_x), _mm256_mul_ps(outside_y, outside_y)),
+        _mm256_set1_ps(radius * radius), _CMP_LT_OQ);
+
+    return static_cast<uint32_t>(_mm256_movemask_ps(_mm256_andnot_ps(outside_box, _mm256_and_ps(overlap, obstacle.valid))));
+}
+
+#endif
+
+// --- RUNTIME DISPATCH ---
+
+struct KernelTable {
+    SweepFn sweep;
+    OverlapFn overlap;
+    const char* name;
+};
+
+KernelTable selectKernels() {
+#if defined(HAVE_AVX2_DISPATCH)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return {sweepAvx2, overlapAvx2, "AVX2"};
+    }
+#endif
+    return {sweepScalar, overlapScalar, "scalar"};
+}
+
+const KernelTable& kernels() {
+    static const KernelTable table = selectKernels();
+    return table;
+}
+
+} // namespace
+
+int ObstacleKernels::sweepBatch(const ObstacleTransforms& transforms, const int* indices, int count,
+                                const Vec2f& start, const Vec2f& end, float radius, float& time_of_impact) {
+    if (count <= 0) {
+        return -1;
+    }
+
+    return kernels().sweep(transforms, indices, count, start, end, radius, time_of_impact);
+}
+
+uint32_t ObstacleKernels::overlapBatch(const ObstacleTransforms& transforms, const int* indices, int count,
+                                       const Vec2f& point, float radius) {
+    if (count <= 0) {
+        return 0;
+    }
+
+    return kernels().overlap(transforms, indices, count, point, radius);
+}
+
+const char* ObstacleKernels::getInstructionSetName() {
+    return kernels().name;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include "core_types.h"
+
+struct ObstacleTransforms;
+
+// Narrow phase of one particle against a batch of up to BATCH obstacles
+// (indices into ObstacleTransforms), without a branch per obstacle. Like
+// ParticleKernels the instruction set is picked once at runtime: AVX2 tests
+// the whole batch in one pass, other CPUs run the same branchless lanes one
+// by one. Each lane repeats, rounding for rounding, ObstacleSystem's
+// single-obstacle tests, so a batch picks the obstacle the per-obstacle loop
+// would have picked.
+class ObstacleKernels {
+public:
+    static constexpr int BATCH = 8;
+
+    // Swept step start -> end against the batch's rectangles grown by radius
+    // (lanes the particle starts inside are skipped). Returns the first lane
+    // whose time of impact is below time_of_impact and lowers it to that
+    // time, or -1 when none is.
+    static int sweepBatch(const ObstacleTransforms& transforms, const int* indices, int count,
+                          const Vec2f& start, const Vec2f& end, float radius, float& time_of_impact);
+
+    // Bit per lane whose margin-grown AABB holds point and whose rectangle
+    // the particle circle overlaps
+    static uint32_t overlapBatch(const ObstacleTransforms& transforms, const int* indices, int count,
+                                 const Vec2f& point, float radius);
+
+    // Name of the instruction set picked by the runtime dispatcher
+    static const char* getInstructionSetName();
+};
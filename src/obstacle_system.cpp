@@ -1,32 +1,45 @@
 #include "obstacle_system.h"
+#include "obstacle_kernels.h"
+#include "frame_arena.h"
+#include "checkpoint.h"
+#include "profiler.h"
 #include <cmath>
 #include <algorithm>
 
 Obstacle::Obstacle(float x, float y, float w, float h) 
     : position(x, y), velocity(0, 0), size(w, h), rotation(0), angular_velocity(0) {
-    
-    // Random color for visual distinction
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    static std::uniform_int_distribution<> color_dist(50, 255);
-    
-    color = sf::Color(
-        color_dist(gen),
-        color_dist(gen), 
-        color_dist(gen),
-        180 // Semi-transparent
-    );
-    
-    // Random angular velocity
-    static std::uniform_real_distribution<> angular_dist(-2.0f, 2.0f);
-    angular_velocity = angular_dist(gen);
 }
 
-ObstacleSystem::ObstacleSystem(int width, int height, int obstacle_count) 
-    : rng(std::random_device{}()),
-      direction_dist(-1.0f, 1.0f),
+void ObstacleTransforms::resize(std::size_t count) {
+    center_x.resize(count);
+    center_y.resize(count);
+    cos_rotation.resize(count);
+    sin_rotation.resize(count);
+    half_width.resize(count);
+    half_height.resize(count);
+    aabb_min_x.resize(count);
+    aabb_min_y.resize(count);
+    aabb_max_x.resize(count);
+    aabb_max_y.resize(count);
+}
+
+ObstacleSystem::ObstacleSystem(int width, int height, int obstacle_count)
+    : ObstacleSystem(width, height, obstacle_count, std::random_device{}()) {
+}
+
+ObstacleSystem::ObstacleSystem(int width, int height, int obstacle_count, uint64_t seed) 
+    : direction_dist(-1.0f, 1.0f),
       window_width(width), 
-      window_height(height) {
+      window_height(height),
+      collision_margin(8.0f),
+      grid_columns(std::max(1, static_cast<int>(std::ceil(width / GRID_CELL_SIZE)))),
+      grid_rows(std::max(1, static_cast<int>(std::ceil(height / GRID_CELL_SIZE)))),
+      cell_obstacles(nullptr),
+      frame_arena(nullptr) {
+    
+    // Salted so obstacles don't share a stream with the particle initialization
+    std::seed_seq sequence{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32), 0x0B57AC1Eu};
+    rng.seed(sequence);
     
     obstacles.reserve(obstacle_count);
     
@@ -40,7 +53,9 @@ ObstacleSystem::ObstacleSystem(int width, int height, int obstacle_count)
         float w = size_dist(rng);
         float h = size_dist(rng);
         
-        obstacles.emplace_back(x_dist(rng), y_dist(rng), w, h);
+        float x = x_dist(rng);
+        float y = y_dist(rng);
+        addObstacle(x, y, w, h);
         
         // Give obstacles initial velocity
         obstacles.back().velocity.x = vel_dist(rng);
@@ -49,9 +64,114 @@ ObstacleSystem::ObstacleSystem(int width, int height, int obstacle_count)
 }
 
 void ObstacleSystem::update(float delta_time) {
+    PROFILE_ZONE("ObstacleSystem::update");
+    
     // Deep call hierarchy for interesting flame graph
     updateObstacleMovement(delta_time);
     handleObstacleBoundaries();
+    updateCollisionData();
+}
+
+void ObstacleSystem::setCollisionMargin(float margin) {
+    collision_margin = margin;
+    updateCollisionData();
+}
+
+void ObstacleSystem::updateCollisionData() {
+    updateTransforms();
+    rebuildGrid();
+}
+
+void ObstacleSystem::updateTransforms() {
+    transforms.resize(obstacles.size());
+    
+    for (std::size_t i = 0; i < obstacles.size(); ++i) {
+        const Obstacle& obstacle = obstacles[i];
+        float cos_a = std::cos(obstacle.rotation);
+        float sin_a = std::sin(obstacle.rotation);
+        float half_width = obstacle.size.x / 2;
+        float half_height = obstacle.size.y / 2;
+        
+        // Extents of the rotated rectangle along the world axes
+        float extent_x = std::abs(cos_a) * half_width + std::abs(sin_a) * half_height + collision_margin;
+        float extent_y = std::abs(sin_a) * half_width + std::abs(cos_a) * half_height + collision_margin;
+        
+        transforms.center_x[i] = obstacle.position.x;
+        transforms.center_y[i] = obstacle.position.y;
+        transforms.cos_rotation[i] = cos_a;
+        transforms.sin_rotation[i] = sin_a;
+        transforms.half_width[i] = half_width;
+        transforms.half_height[i] = half_height;
+        transforms.aabb_min_x[i] = obstacle.position.x - extent_x;
+        transforms.aabb_min_y[i] = obstacle.position.y - extent_y;
+        transforms.aabb_max_x[i] = obstacle.position.x + extent_x;
+        transforms.aabb_max_y[i] = obstacle.position.y + extent_y;
+    }
+}
+
+void ObstacleSystem::rebuildGrid() {
+    const int cell_count = grid_columns * grid_rows;
+    cell_start.assign(cell_count + 1, 0);
+    
+    // Cell range covered by an obstacle's cached AABB (already includes the margin)
+    auto cellRange = [this](int index, int& x0, int& y0, int& x1, int& y1) {
+        x0 = std::clamp(static_cast<int>(std::floor(transforms.aabb_min_x[index] / GRID_CELL_SIZE)), 0, grid_columns - 1);
+        x1 = std::clamp(static_cast<int>(std::floor(transforms.aabb_max_x[index] / GRID_CELL_SIZE)), 0, grid_columns - 1);
+        y0 = std::clamp(static_cast<int>(std::floor(transforms.aabb_min_y[index] / GRID_CELL_SIZE)), 0, grid_rows - 1);
+        y1 = std::clamp(static_cast<int>(std::floor(transforms.aabb_max_y[index] / GRID_CELL_SIZE)), 0, grid_rows - 1);
+    };
+    
+    // Counting sort: count entries per cell, prefix-sum, then scatter in obstacle order
+    const int obstacle_count = static_cast<int>(obstacles.size());
+    int x0, y0, x1, y1;
+    for (int index = 0; index < obstacle_count; ++index) {
+        cellRange(index, x0, y0, x1, y1);
+        for (int y = y0; y <= y1; ++y) {
+            for (int x = x0; x <= x1; ++x) {
+                ++cell_start[y * grid_columns + x + 1];
+            }
+        }
+    }
+    
+    for (int cell = 0; cell < cell_count; ++cell) {
+        cell_start[cell + 1] += cell_start[cell];
+    }
+    
+    const int entry_count = cell_start[cell_count];
+    if (frame_arena) {
+        cell_obstacles = frame_arena->allocateArray<int>(entry_count);
+    } else {
+        cell_obstacle_storage.resize(entry_count);
+        cell_obstacles = cell_obstacle_storage.data();
+    }
+    for (int index = 0; index < obstacle_count; ++index) {
+        cellRange(index, x0, y0, x1, y1);
+        for (int y = y0; y <= y1; ++y) {
+            for (int x = x0; x <= x1; ++x) {
+                int cell = y * grid_columns + x;
+                cell_obstacles[cell_start[cell]++] = index;
+            }
+        }
+    }
+    
+    // The scatter advanced every start to the next cell's start; shift back
+    for (int cell = cell_count; cell > 0; --cell) {
+        cell_start[cell] = cell_start[cell - 1];
+    }
+    cell_start[0] = 0;
+}
+
+std::size_t ObstacleSystem::getFrameScratchBytes() const {
+    // An obstacle's AABB never exceeds its circumscribed circle grown by the
+    // margin; a span of d pixels touches at most floor(d / cell) + 2 cells
+    std::size_t entries = 0;
+    for (const auto& obstacle : obstacles) {
+        float span = std::hypot(obstacle.size.x, obstacle.size.y) + 2 * collision_margin;
+        int cells_per_axis = static_cast<int>(span / GRID_CELL_SIZE) + 2;
+        entries += static_cast<std::size_t>(std::min(cells_per_axis, grid_columns)) *
+                   std::min(cells_per_axis, grid_rows);
+    }
+    return entries * sizeof(int) + FrameArena::ALIGNMENT;
 }
 
 void ObstacleSystem::updateObstacleMovement(float delta_time) {
@@ -120,15 +240,101 @@ void ObstacleSystem::handleObstacleBoundaries() {
     }
 }
 
-bool ObstacleSystem::handleParticleCollision(sf::Vector2f& particle_pos, sf::Vector2f& particle_velocity, float particle_radius) {
-    sf::Vector2f original_pos = particle_pos;
+bool ObstacleSystem::handleParticleCollision(const Vec2f& previous_pos, Vec2f& particle_pos,
+                                             Vec2f& particle_velocity, float particle_radius) const {
+    // Swept pass: the earliest time of impact over every obstacle the step's
+    // segment can reach. The segment may leave the end cell, so all cells under
+    // its bounding box are visited; an obstacle listed in several of them just
+    // yields the same time again. Obstacles that pass the AABB reject are
+    // tested in batches of ObstacleKernels::BATCH, in the order they were met.
+    const float sweep_min_x = std::min(previous_pos.x, particle_pos.x);
+    const float sweep_max_x = std::max(previous_pos.x, particle_pos.x);
+    const float sweep_min_y = std::min(previous_pos.y, particle_pos.y);
+    const float sweep_max_y = std::max(previous_pos.y, particle_pos.y);
+    
+    if (sweep_max_x > sweep_min_x || sweep_max_y > sweep_min_y) {
+        const int x0 = std::clamp(static_cast<int>(sweep_min_x / GRID_CELL_SIZE), 0, grid_columns - 1);
+        const int x1 = std::clamp(static_cast<int>(sweep_max_x / GRID_CELL_SIZE), 0, grid_columns - 1);
+        const int y0 = std::clamp(static_cast<int>(sweep_min_y / GRID_CELL_SIZE), 0, grid_rows - 1);
+        const int y1 = std::clamp(static_cast<int>(sweep_max_y / GRID_CELL_SIZE), 0, grid_rows - 1);
+        
+        int batch[ObstacleKernels::BATCH];
+        int batch_size = 0;
+        int first_index = -1;
+        float first_time = 1.0f;
+        auto testBatch = [&]() {
+            const int lane = ObstacleKernels::sweepBatch(transforms, batch, batch_size, previous_pos, particle_pos,
+                                                         particle_radius, first_time);
+            if (lane >= 0) {
+                first_index = batch[lane];
+            }
+            batch_size = 0;
+        };
+        
+        for (int y = y0; y <= y1; ++y) {
+            for (int x = x0; x <= x1; ++x) {
+                const int cell = y * grid_columns + x;
+                for (int entry = cell_start[cell]; entry < cell_start[cell + 1]; ++entry) {
+                    const int index = cell_obstacles[entry];
+                    if (sweep_max_x < transforms.aabb_min_x[index] || sweep_min_x > transforms.aabb_max_x[index] ||
+                        sweep_max_y < transforms.aabb_min_y[index] || sweep_min_y > transforms.aabb_max_y[index]) {
+                        continue;
+                    }
+                    
+                    batch[batch_size++] = index;
+                    if (batch_size == ObstacleKernels::BATCH) {
+                        testBatch();
+                    }
+                }
+            }
+        }
+        if (batch_size > 0) {
+            testBatch();
+        }
+        
+        // The batch found the time; the contact point and normal come from the
+        // scalar test on that one obstacle. Both are built to round alike, but a
+        // compiler allowed to contract or reorder float math may still make the
+        // winner miss there; the hit must not be lost, so redo the sweep scalar.
+        CollisionInfo first_hit = first_index >= 0
+            ? checkLineRectangleCollision(previous_pos, particle_pos, first_index, particle_radius)
+            : CollisionInfo{false, Vec2f(), Vec2f(), 0.0f, 1.0f};
+        if (first_index >= 0 && !first_hit.has_collision) {
+            first_hit = sweepCells(previous_pos, particle_pos, particle_radius, x0, x1, y0, y1);
+        }
+        if (first_hit.has_collision) {
+            // Stop at the contact point, backed off a hair so the next frame
+            // starts outside, and send the velocity back off the surface
+            particle_pos = first_hit.collision_point + first_hit.collision_normal * CONTACT_OFFSET;
+            particle_velocity = reflectVelocity(particle_velocity, first_hit.collision_normal) * 0.8f;
+            return true;
+        }
+    }
+    
+    // Overlap pass: the particle started inside (an obstacle moved onto it);
+    // only obstacles registered in the end position's cell can touch it. Each
+    // push moves the particle, so the rest of its batch is tested again.
     bool any_collision = false;
+    int cell_x = std::clamp(static_cast<int>(particle_pos.x / GRID_CELL_SIZE), 0, grid_columns - 1);
+    int cell_y = std::clamp(static_cast<int>(particle_pos.y / GRID_CELL_SIZE), 0, grid_rows - 1);
+    int cell = cell_y * grid_columns + cell_x;
     
-    for (const auto& obstacle : obstacles) {
-        // First check if particle is currently inside obstacle
-        CollisionInfo point_collision = checkPointRectangleCollision(particle_pos, obstacle, particle_radius);
+    const int cell_end = cell_start[cell + 1];
+    for (int entry = cell_start[cell]; entry < cell_end; entry += ObstacleKernels::BATCH) {
+        const int* indices = cell_obstacles + entry;
+        const int count = std::min(ObstacleKernels::BATCH, cell_end - entry);
+        uint32_t hits = ObstacleKernels::overlapBatch(transforms, indices, count, particle_pos, particle_radius);
         
-        if (point_collision.has_collision) {
+        for (int lane = 0; hits != 0 && lane < count; ++lane) {
+            if (!(hits & (1u << lane))) {
+                continue;
+            }
+            
+            CollisionInfo point_collision = checkPointRectangleCollision(particle_pos, indices[lane], particle_radius);
+            if (!point_collision.has_collision) {
+                continue;
+            }
+            
             // Push particle out of obstacle
             particle_pos = particle_pos + point_collision.collision_normal * point_collision.penetration_depth;
             
@@ -139,183 +345,319 @@ bool ObstacleSystem::handleParticleCollision(sf::Vector2f& particle_pos, sf::Vec
             particle_velocity = particle_velocity * 0.7f;
             
             any_collision = true;
-        } else {
-            // Check trajectory collision
-            sf::Vector2f next_pos = particle_pos; // particle_pos is already updated position
-            CollisionInfo trajectory_collision = checkLineRectangleCollision(original_pos, next_pos, obstacle, particle_radius);
-            
-            if (trajectory_collision.has_collision) {
-                // Stop particle at collision point
-                particle_pos = trajectory_collision.collision_point - trajectory_collision.collision_normal * particle_radius;
-                
-                // Reflect velocity
-                particle_velocity = reflectVelocity(particle_velocity, trajectory_collision.collision_normal);
-                
-                // Dampen velocity
-                particle_velocity = particle_velocity * 0.8f;
-                
-                any_collision = true;
-            }
+            hits = ObstacleKernels::overlapBatch(transforms, indices, count, particle_pos, particle_radius) &
+                   (~0u << (lane + 1));
         }
     }
     
     return any_collision;
 }
 
-ObstacleSystem::CollisionInfo ObstacleSystem::checkPointRectangleCollision(const sf::Vector2f& point, const Obstacle& obstacle, float particle_radius) {
+ObstacleSystem::CollisionInfo ObstacleSystem::checkPointRectangleCollision(const Vec2f& point, int obstacle_index, float particle_radius) const {
     CollisionInfo info;
     info.has_collision = false;
+    info.time_of_impact = 0.0f;
     
-    // Transform point to obstacle's local coordinate system
-    sf::Vector2f local_point = point - obstacle.position;
-    local_point = rotateVector(local_point, -obstacle.rotation);
+    const Vec2f center(transforms.center_x[obstacle_index], transforms.center_y[obstacle_index]);
+    const float cos_a = transforms.cos_rotation[obstacle_index];
+    const float sin_a = transforms.sin_rotation[obstacle_index];
     
-    // Expanded rectangle dimensions (to account for particle radius)
-    float half_width = obstacle.size.x / 2 + particle_radius;
-    float half_height = obstacle.size.y / 2 + particle_radius;
+    // Transform point to obstacle's local coordinate system (inverse rotation)
+    Vec2f local_point = rotateVector(point - center, cos_a, -sin_a);
     
-    // Check if point is inside expanded rectangle
-    if (std::abs(local_point.x) <= half_width && std::abs(local_point.y) <= half_height) {
-        info.has_collision = true;
-        
-        // Calculate penetration depth and normal
-        float penetration_x = half_width - std::abs(local_point.x);
-        float penetration_y = half_height - std::abs(local_point.y);
-        
-        sf::Vector2f local_normal;
+    const float half_width = transforms.half_width[obstacle_index];
+    const float half_height = transforms.half_height[obstacle_index];
+    
+    // Closest point of the rectangle; the particle overlaps when it is nearer
+    // than its radius (same rounded shape the swept test uses)
+    const Vec2f closest(std::clamp(local_point.x, -half_width, half_width),
+                               std::clamp(local_point.y, -half_height, half_height));
+    const Vec2f offset = local_point - closest;
+    const float distance_squared = offset.x * offset.x + offset.y * offset.y;
+    if (distance_squared >= particle_radius * particle_radius) {
+        return info;
+    }
+    info.has_collision = true;
+    
+    Vec2f local_normal;
+    if (distance_squared > 0.0f) {
+        // Center outside the rectangle: push straight away from the closest point
+        const float distance = std::sqrt(distance_squared);
+        local_normal = offset / distance;
+        info.penetration_depth = particle_radius - distance;
+    } else {
+        // Center inside: leave through the nearest face
+        float penetration_x = half_width + particle_radius - std::abs(local_point.x);
+        float penetration_y = half_height + particle_radius - std::abs(local_point.y);
         if (penetration_x < penetration_y) {
-            // Horizontal collision
-            local_normal.x = (local_point.x > 0) ? 1.0f : -1.0f;
-            local_normal.y = 0.0f;
+            local_normal = Vec2f((local_point.x > 0) ? 1.0f : -1.0f, 0.0f);
             info.penetration_depth = penetration_x;
         } else {
-            // Vertical collision
-            local_normal.x = 0.0f;
-            local_normal.y = (local_point.y > 0) ? 1.0f : -1.0f;
+            local_normal = Vec2f(0.0f, (local_point.y > 0) ? 1.0f : -1.0f);
             info.penetration_depth = penetration_y;
         }
-        
-        // Transform normal back to world coordinates
-        info.collision_normal = rotateVector(local_normal, obstacle.rotation);
-        info.collision_point = point;
     }
     
+    // Transform normal back to world coordinates
+    info.collision_normal = rotateVector(local_normal, cos_a, sin_a);
+    info.collision_point = point;
+    
     return info;
 }
 
-ObstacleSystem::CollisionInfo ObstacleSystem::checkLineRectangleCollision(const sf::Vector2f& line_start, const sf::Vector2f& line_end, const Obstacle& obstacle, float particle_radius) {
+namespace {
+
+// Entry time in [0, 1] of the segment p + t * d into the box |x| <= hx,
+// |y| <= hy (slab method); sets the entry face normal. Returns > 1 on a miss
+// or when p is already inside.
+float sweepBox(const Vec2f& p, const Vec2f& d, float hx, float hy, Vec2f& normal) {
+    float t_enter = 0.0f;
+    float t_exit = 1.0f;
+    Vec2f enter_normal(0.0f, 0.0f);
+    bool entered = false;
+    
+    const float origin[2] = {p.x, p.y};
+    const float direction[2] = {d.x, d.y};
+    const float extent[2] = {hx, hy};
+    for (int axis = 0; axis < 2; ++axis) {
+        if (direction[axis] == 0.0f) {
+            if (std::abs(origin[axis]) > extent[axis]) {
+                return 2.0f;
+            }
+            continue;
+        }
+        // Near face is the one on the side the segment comes from
+        const float side = direction[axis] > 0.0f ? -1.0f : 1.0f;
+        const float t_near = (side * extent[axis] - origin[axis]) / direction[axis];
+        const float t_far = (-side * extent[axis] - origin[axis]) / direction[axis];
+        if (t_near > t_enter) {
+            t_enter = t_near;
+            enter_normal = axis == 0 ? Vec2f(side, 0.0f) : Vec2f(0.0f, side);
+            entered = true;
+        }
+        t_exit = std::min(t_exit, t_far);
+        if (t_enter > t_exit) {
+            return 2.0f;
+        }
+    }
+    
+    if (!entered) {
+        return 2.0f; // Starts inside
+    }
+    normal = enter_normal;
+    return t_enter;
+}
+
+// Entry time in [0, 1] of p + t * d into the circle |x - c| <= r; > 1 on a miss
+float sweepCircle(const Vec2f& p, const Vec2f& d, const Vec2f& c, float r) {
+    const Vec2f m = p - c;
+    const float a = d.x * d.x + d.y * d.y;
+    const float b = m.x * d.x + m.y * d.y;
+    const float k = m.x * m.x + m.y * m.y - r * r;
+    if (k <= 0.0f || b >= 0.0f) {
+        return 2.0f; // Starts inside, or moves away
+    }
+    const float discriminant = b * b - a * k;
+    if (discriminant < 0.0f) {
+        return 2.0f;
+    }
+    return (-b - std::sqrt(discriminant)) / a;
+}
+
+} // namespace
+
+ObstacleSystem::CollisionInfo ObstacleSystem::sweepCells(const Vec2f& line_start, const Vec2f& line_end,
+                                                         float particle_radius, int x0, int x1, int y0, int y1) const {
+    const float sweep_min_x = std::min(line_start.x, line_end.x);
+    const float sweep_max_x = std::max(line_start.x, line_end.x);
+    const float sweep_min_y = std::min(line_start.y, line_end.y);
+    const float sweep_max_y = std::max(line_start.y, line_end.y);
+    
+    CollisionInfo first_hit{false, Vec2f(), Vec2f(), 0.0f, 1.0f};
+    for (int y = y0; y <= y1; ++y) {
+        for (int x = x0; x <= x1; ++x) {
+            const int cell = y * grid_columns + x;
+            for (int entry = cell_start[cell]; entry < cell_start[cell + 1]; ++entry) {
+                const int index = cell_obstacles[entry];
+                if (sweep_max_x < transforms.aabb_min_x[index] || sweep_min_x > transforms.aabb_max_x[index] ||
+                    sweep_max_y < transforms.aabb_min_y[index] || sweep_min_y > transforms.aabb_max_y[index]) {
+                    continue;
+                }
+                
+                CollisionInfo hit = checkLineRectangleCollision(line_start, line_end, index, particle_radius);
+                if (hit.has_collision && hit.time_of_impact < first_hit.time_of_impact) {
+                    first_hit = hit;
+                }
+            }
+        }
+    }
+    return first_hit;
+}
+
+ObstacleSystem::CollisionInfo ObstacleSystem::checkLineRectangleCollision(const Vec2f& line_start, const Vec2f& line_end, int obstacle_index, float particle_radius) const {
     CollisionInfo info;
     info.has_collision = false;
+    info.time_of_impact = 1.0f;
     
-    // For simplicity, we'll check if the line passes through the expanded rectangle
-    // Transform both points to obstacle's local coordinate system
-    sf::Vector2f local_start = line_start - obstacle.position;
-    local_start = rotateVector(local_start, -obstacle.rotation);
+    const Vec2f center(transforms.center_x[obstacle_index], transforms.center_y[obstacle_index]);
+    const float cos_a = transforms.cos_rotation[obstacle_index];
+    const float sin_a = transforms.sin_rotation[obstacle_index];
+    const float half_width = transforms.half_width[obstacle_index];
+    const float half_height = transforms.half_height[obstacle_index];
     
-    sf::Vector2f local_end = line_end - obstacle.position;
-    local_end = rotateVector(local_end, -obstacle.rotation);
+    // Work in obstacle-local space, where the rectangle is axis aligned
+    const Vec2f local_start = rotateVector(line_start - center, cos_a, -sin_a);
+    const Vec2f local_end = rotateVector(line_end - center, cos_a, -sin_a);
+    const Vec2f motion = local_end - local_start;
     
-    // Expanded rectangle dimensions
-    float half_width = obstacle.size.x / 2 + particle_radius;
-    float half_height = obstacle.size.y / 2 + particle_radius;
+    // Starting inside the rounded rectangle is the overlap pass's job
+    const float outside_x = std::max(std::abs(local_start.x) - half_width, 0.0f);
+    const float outside_y = std::max(std::abs(local_start.y) - half_height, 0.0f);
+    if (outside_x * outside_x + outside_y * outside_y < particle_radius * particle_radius) {
+        return info;
+    }
     
-    // Simple AABB line intersection check
-    // If start is outside and end is inside, or vice versa, there's a collision
-    bool start_inside = (std::abs(local_start.x) <= half_width && std::abs(local_start.y) <= half_height);
-    bool end_inside = (std::abs(local_end.x) <= half_width && std::abs(local_end.y) <= half_height);
+    // The particle circle hits the rectangle exactly when its center hits the
+    // Minkowski sum: a rounded rectangle, i.e. the union of two boxes (grown
+    // along x or along y) and four corner circles. The union's entry time is
+    // the earliest entry into any of them.
+    Vec2f local_normal;
+    Vec2f box_normal;
+    float t_hit = sweepBox(local_start, motion, half_width + particle_radius, half_height, box_normal);
+    local_normal = box_normal;
+    float t = sweepBox(local_start, motion, half_width, half_height + particle_radius, box_normal);
+    if (t < t_hit) {
+        t_hit = t;
+        local_normal = box_normal;
+    }
     
-    if (!start_inside && end_inside) {
-        // Particle is entering the obstacle
-        info.has_collision = true;
-        
-        // Find collision point along the line (simplified)
-        float t = 0.5f; // Midpoint approximation
-        sf::Vector2f local_collision = local_start + (local_end - local_start) * t;
-        
-        // Calculate normal based on which edge was hit
-        sf::Vector2f local_normal;
-        if (std::abs(local_collision.x) / half_width > std::abs(local_collision.y) / half_height) {
-            // Hit vertical edge
-            local_normal.x = (local_collision.x > 0) ? 1.0f : -1.0f;
-            local_normal.y = 0.0f;
-        } else {
-            // Hit horizontal edge
-            local_normal.x = 0.0f;
-            local_normal.y = (local_collision.y > 0) ? 1.0f : -1.0f;
+    int hit_corner = -1;
+    const Vec2f corners[4] = {
+        Vec2f(-half_width, -half_height), Vec2f(half_width, -half_height),
+        Vec2f(-half_width, half_height), Vec2f(half_width, half_height)
+    };
+    for (int corner = 0; corner < 4; ++corner) {
+        t = sweepCircle(local_start, motion, corners[corner], particle_radius);
+        if (t < t_hit) {
+            t_hit = t;
+            hit_corner = corner;
         }
-        
-        // Transform back to world coordinates
-        info.collision_normal = rotateVector(local_normal, obstacle.rotation);
-        info.collision_point = obstacle.position + rotateVector(local_collision, obstacle.rotation);
-        info.penetration_depth = 0.0f;
     }
     
+    if (t_hit > 1.0f) {
+        return info;
+    }
+    
+    const Vec2f local_contact = local_start + motion * t_hit;
+    if (hit_corner >= 0) {
+        local_normal = (local_contact - corners[hit_corner]) / particle_radius;
+    }
+    
+    info.has_collision = true;
+    info.time_of_impact = t_hit;
+    info.collision_normal = rotateVector(local_normal, cos_a, sin_a);
+    info.collision_point = center + rotateVector(local_contact, cos_a, sin_a); // Particle center at impact
+    info.penetration_depth = 0.0f;
     return info;
 }
 
-sf::Vector2f ObstacleSystem::reflectVelocity(const sf::Vector2f& velocity, const sf::Vector2f& normal) {
+Vec2f ObstacleSystem::reflectVelocity(const Vec2f& velocity, const Vec2f& normal) const {
     // Reflection formula: v' = v - 2(v·n)n
     float dot_product = velocity.x * normal.x + velocity.y * normal.y;
-    return sf::Vector2f(
+    return Vec2f(
         velocity.x - 2.0f * dot_product * normal.x,
         velocity.y - 2.0f * dot_product * normal.y
     );
 }
 
-sf::Vector2f ObstacleSystem::rotateVector(const sf::Vector2f& vec, float angle) {
-    float cos_a = cos(angle);
-    float sin_a = sin(angle);
-    
-    return sf::Vector2f(
+Vec2f ObstacleSystem::rotateVector(const Vec2f& vec, float cos_a, float sin_a) const {
+    return Vec2f(
         vec.x * cos_a - vec.y * sin_a,
         vec.x * sin_a + vec.y * cos_a
     );
 }
 
-sf::Vector2f ObstacleSystem::normalizeVector(const sf::Vector2f& vec) {
+Vec2f ObstacleSystem::normalizeVector(const Vec2f& vec) const {
     float magnitude = sqrt(vec.x * vec.x + vec.y * vec.y);
     
     if (magnitude < 0.0001f) {
-        return sf::Vector2f(0, 0);
+        return Vec2f(0, 0);
     }
     
-    return sf::Vector2f(vec.x / magnitude, vec.y / magnitude);
+    return Vec2f(vec.x / magnitude, vec.y / magnitude);
 }
 
-void ObstacleSystem::render(sf::RenderWindow& window) {
-    sf::RectangleShape rectangle;
+void ObstacleSystem::addObstacle(float x, float y, float w, float h) {
+    obstacles.emplace_back(x, y, w, h);
+    Obstacle& obstacle = obstacles.back();
     
-    for (const auto& obstacle : obstacles) {
-        rectangle.setSize(obstacle.size);
-        
-        // SFML version-specific origin setting
-#if SFML_VERSION_MAJOR >= 3
-        // SFML 3.x API - uses sf::Vector2f
-        rectangle.setOrigin(sf::Vector2f(obstacle.size.x / 2, obstacle.size.y / 2));
-#else
-        // SFML 2.x API - uses separate x, y parameters
-        rectangle.setOrigin(obstacle.size.x / 2, obstacle.size.y / 2);
-#endif
-        rectangle.setPosition(obstacle.position);
-        
-        // SFML version-specific rotation setting
-#if SFML_VERSION_MAJOR >= 3
-        // SFML 3.x API - uses sf::degrees
-        rectangle.setRotation(sf::degrees(obstacle.rotation * 180.0f / M_PI));
-#else
-        // SFML 2.x API - uses degrees directly
-        rectangle.setRotation(obstacle.rotation * 180.0f / M_PI);
-#endif
-        rectangle.setFillColor(obstacle.color);
-        rectangle.setOutlineThickness(2.0f);
-        rectangle.setOutlineColor(sf::Color(0, 0, 0, 100));
-        
-        window.draw(rectangle);
+    // Random color for visual distinction
+    std::uniform_int_distribution<> color_dist(50, 255);
+    int r = color_dist(rng);
+    int g = color_dist(rng);
+    int b = color_dist(rng);
+    obstacle.color = Color(r, g, b, 180); // Semi-transparent
+    
+    // Random angular velocity
+    std::uniform_real_distribution<float> angular_dist(-2.0f, 2.0f);
+    obstacle.angular_velocity = angular_dist(rng);
+    
+    updateCollisionData();
+}
+
+void ObstacleSystem::saveCheckpoint(CheckpointWriter& writer) const {
+    writer.beginSection(CheckpointFormat::sectionTag('O', 'B', 'S', 'T'));
+    writer.write<int32_t>(window_width);
+    writer.write<int32_t>(window_height);
+    writer.write(collision_margin);
+    writer.write<uint64_t>(obstacles.size());
+    for (const Obstacle& obstacle : obstacles) {
+        writer.write(obstacle.position);
+        writer.write(obstacle.velocity);
+        writer.write(obstacle.size);
+        writer.write(obstacle.rotation);
+        writer.write(obstacle.angular_velocity);
+        writer.write(obstacle.color);
     }
+    writer.writeRng(rng);
 }
 
-void ObstacleSystem::addObstacle(float x, float y, float w, float h) {
-    obstacles.emplace_back(x, y, w, h);
+bool ObstacleSystem::loadCheckpoint(CheckpointReader& reader) {
+    constexpr uint64_t MAX_OBSTACLES = 1 << 20;
+    
+    int32_t width = 0, height = 0;
+    float margin = 0.0f;
+    uint64_t count = 0;
+    if (!reader.expectSection(CheckpointFormat::sectionTag('O', 'B', 'S', 'T'), "obstacles") ||
+        !reader.read(width) || !reader.read(height) || !reader.read(margin) ||
+        !reader.readCount(count, MAX_OBSTACLES)) {
+        return false;
+    }
+    if (width != window_width || height != window_height) {
+        return reader.fail("checkpoint obstacles are for a " + std::to_string(width) + "x" +
+                           std::to_string(height) + " world");
+    }
+    
+    // Read everything before touching our state, so a bad file changes nothing
+    std::vector<Obstacle> loaded(count, Obstacle(0, 0, 0, 0));
+    for (Obstacle& obstacle : loaded) {
+        reader.read(obstacle.position);
+        reader.read(obstacle.velocity);
+        reader.read(obstacle.size);
+        reader.read(obstacle.rotation);
+        reader.read(obstacle.angular_velocity);
+        reader.read(obstacle.color);
+    }
+    std::mt19937 loaded_rng;
+    if (!reader.readRng(loaded_rng)) {
+        return false;
+    }
+    
+    obstacles = std::move(loaded);
+    rng = loaded_rng;
+    collision_margin = margin;
+    updateCollisionData();
+    return true;
 }
 
 void ObstacleSystem::resetObstacles() {
@@ -330,4 +672,6 @@ void ObstacleSystem::resetObstacles() {
         obstacle.velocity.y = vel_dist(rng);
         obstacle.rotation = 0;
     }
+    
+    updateCollisionData();
 } 
\ No newline at end of file
@@ -2,62 +2,146 @@
 
 #include <vector>
 #include <random>
-#include <SFML/Graphics.hpp>
+#include <cstddef>
+#include <cstdint>
+#include "core_types.h"
+
+class FrameArena;
+class CheckpointWriter;
+class CheckpointReader;
 
 struct Obstacle {
-    sf::Vector2f position;        // Center position
-    sf::Vector2f velocity;        // Movement velocity
-    sf::Vector2f size;           // Width and height
+    Vec2f position;        // Center position
+    Vec2f velocity;        // Movement velocity
+    Vec2f size;           // Width and height
     float rotation;              // Current rotation angle (radians)
     float angular_velocity;      // Rotation speed (radians/second)
-    sf::Color color;            // Visual color
+    Color color;            // Visual color
     
     Obstacle(float x, float y, float w, float h);
 };
 
+// Narrow-phase data for every obstacle, computed once per frame so collision
+// tests never evaluate trig. Index i matches ObstacleSystem::obstacles[i].
+// Local coordinates: local = R^T * (point - center), world = R * local,
+// with R = [cos -sin; sin cos].
+struct ObstacleTransforms {
+    std::vector<float> center_x;
+    std::vector<float> center_y;
+    std::vector<float> cos_rotation;
+    std::vector<float> sin_rotation;
+    std::vector<float> half_width;   // Half extents of the rectangle itself
+    std::vector<float> half_height;
+    std::vector<float> aabb_min_x;   // World AABB grown by the collision margin
+    std::vector<float> aabb_min_y;
+    std::vector<float> aabb_max_x;
+    std::vector<float> aabb_max_y;
+    
+    void resize(std::size_t count);
+};
+
 class ObstacleSystem {
 private:
     std::vector<Obstacle> obstacles;
+    ObstacleTransforms transforms;
     std::mt19937 rng;
     std::uniform_real_distribution<float> direction_dist;
     
     int window_width;
     int window_height;
     
+    // Broad phase: uniform grid over the window in CSR form. Cell c lists, in
+    // obstacle order, every obstacle whose bounding circle grown by
+    // collision_margin overlaps it, so a particle only tests its own cell.
+    // Obstacles are binned by their cached world AABB (GRID_CELL_SIZE cells).
+    float collision_margin;
+    int grid_columns;
+    int grid_rows;
+    std::vector<int> cell_start;     // grid_columns * grid_rows + 1 offsets
+    int* cell_obstacles;             // obstacle indices, grouped by cell
+    
+    // The cell lists only live until the next rebuild, so they come from the
+    // owner's frame arena when one is attached, else from cell_obstacle_storage
+    FrameArena* frame_arena;
+    std::vector<int> cell_obstacle_storage;
+    
     // Helper functions for collision detection and force calculation
-    sf::Vector2f rotateVector(const sf::Vector2f& vec, float angle);
-    sf::Vector2f normalizeVector(const sf::Vector2f& vec);
-    bool isPointNearRotatedRectangle(const sf::Vector2f& point, const Obstacle& obstacle, float& distance);
-    sf::Vector2f calculateRepulsionForce(const sf::Vector2f& particle_pos, const Obstacle& obstacle);
+    Vec2f rotateVector(const Vec2f& vec, float cos_a, float sin_a) const;
+    Vec2f normalizeVector(const Vec2f& vec) const;
+    bool isPointNearRotatedRectangle(const Vec2f& point, const Obstacle& obstacle, float& distance);
+    Vec2f calculateRepulsionForce(const Vec2f& particle_pos, const Obstacle& obstacle);
     
 public:
+    static constexpr float GRID_CELL_SIZE = 64.0f;
+    // Distance a swept particle is left off the surface it hit
+    static constexpr float CONTACT_OFFSET = 0.01f;
+    
     ObstacleSystem(int width, int height, int obstacle_count = 5);
+    ObstacleSystem(int width, int height, int obstacle_count, uint64_t seed);
+    
+    // cell_obstacles may point into our own storage
+    ObstacleSystem(const ObstacleSystem&) = delete;
+    ObstacleSystem& operator=(const ObstacleSystem&) = delete;
     
     void update(float delta_time);
-    void render(sf::RenderWindow& window);
     
-    // Collision detection and response
-    bool handleParticleCollision(sf::Vector2f& particle_pos, sf::Vector2f& particle_velocity, float particle_radius);
+    // Collision detection and response for one step from previous_pos to
+    // particle_pos (read-only, safe to call from several threads). The step is
+    // swept against the obstacles' current poses and stops at the exact time
+    // of impact, so fast particles cannot tunnel through thin obstacles.
+    bool handleParticleCollision(const Vec2f& previous_pos, Vec2f& particle_pos,
+                                 Vec2f& particle_velocity, float particle_radius) const;
     
     // Obstacle management
     void addObstacle(float x, float y, float w, float h);
     void resetObstacles();
     int getObstacleCount() const { return obstacles.size(); }
+    const std::vector<Obstacle>& getObstacles() const { return obstacles; }
+    // Current frame's poses (valid after update()), e.g. for drawing
+    const ObstacleTransforms& getTransforms() const { return transforms; }
+    // Broad-phase grid size in GRID_CELL_SIZE cells (ComputeBackend replays the binning)
+    int getGridColumns() const { return grid_columns; }
+    int getGridRows() const { return grid_rows; }
+    
+    // Obstacles, their RNG and the collision margin; the per-frame transforms
+    // and grid are rebuilt on load. The world size must match the checkpoint's.
+    void saveCheckpoint(CheckpointWriter& writer) const;
+    bool loadCheckpoint(CheckpointReader& reader);
+    
+    // Largest particle radius (plus per-frame slack) the broad phase must cover
+    void setCollisionMargin(float margin);
+    
+    // Frame arena the grid cell lists are drawn from (not owned, nullptr = own
+    // storage). It must not be reset between a rebuild and the queries after it.
+    void setFrameArena(FrameArena* arena) { frame_arena = arena; }
+    // Upper bound on the arena bytes one grid rebuild takes, whatever the rotations
+    std::size_t getFrameScratchBytes() const;
     
 private:
     void updateObstacleMovement(float delta_time);
     void handleObstacleBoundaries();
+    void updateTransforms();
+    void rebuildGrid();
+    void updateCollisionData(); // Transforms, then the grid built from them
     
     // Collision detection helpers
     struct CollisionInfo {
         bool has_collision;
-        sf::Vector2f collision_point;
-        sf::Vector2f collision_normal;
+        Vec2f collision_point;
+        Vec2f collision_normal;
         float penetration_depth;
+        float time_of_impact; // Swept tests: fraction of the step, in [0, 1]
     };
     
-    CollisionInfo checkLineRectangleCollision(const sf::Vector2f& line_start, const sf::Vector2f& line_end, 
-                                            const Obstacle& obstacle, float particle_radius);
-    CollisionInfo checkPointRectangleCollision(const sf::Vector2f& point, const Obstacle& obstacle, float particle_radius);
-    sf::Vector2f reflectVelocity(const sf::Vector2f& velocity, const sf::Vector2f& normal);
+    // Exact time of impact of a particle moving from line_start to line_end
+    // against the rectangle grown by particle_radius with rounded corners;
+    // collision_point is the particle center at impact
+    CollisionInfo checkLineRectangleCollision(const Vec2f& line_start, const Vec2f& line_end, 
+                                            int obstacle_index, float particle_radius) const;
+    // Earliest swept hit over the grid cells [x0, x1] x [y0, y1], testing one
+    // obstacle at a time; the fallback when a batch and the scalar test disagree
+    CollisionInfo sweepCells(const Vec2f& line_start, const Vec2f& line_end, float particle_radius,
+                             int x0, int x1, int y0, int y1) const;
+    CollisionInfo checkPointRectangleCollision(const Vec2f& point, int obstacle_index, float particle_radius) const;
+    Vec2f reflectVelocity(const Vec2f& velocity, const Vec2f& normal) const;
 }; 
\ No newline at end of file
@@ -0,0 +1,153 @@
+#include "particle_interactions.h"
+#include "frame_arena.h"
+#include "thread_pool.h"
+#include "profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+ParticleInteractions::ParticleInteractions()
+    : cell_size(1.0f),
+      grid_columns(1),
+      grid_rows(1),
+      stiffness(DEFAULT_STIFFNESS),
+      contact_count(0),
+      cell_start(nullptr),
+      sorted_index(nullptr),
+      sorted_x(nullptr),
+      sorted_y(nullptr),
+      sorted_radius(nullptr) {
+}
+
+void ParticleInteractions::configure(float world_width, float world_height, float max_radius) {
+    // Two particles touch when their centers are closer than r_i + r_j <= 2 * max_radius
+    cell_size = std::max(2.0f * max_radius, 1.0f);
+    grid_columns = std::max(1, static_cast<int>(std::ceil(world_width / cell_size)));
+    grid_rows = std::max(1, static_cast<int>(std::ceil(world_height / cell_size)));
+}
+
+std::size_t ParticleInteractions::getFrameScratchBytes(std::size_t particle_count) const {
+    const std::size_t cells = static_cast<std::size_t>(grid_columns) * grid_rows + 1;
+    // Cell starts, cell keys, sorted indices and three float arrays, each
+    // rounded up to the arena alignment
+    return (cells + 2 * particle_count) * sizeof(int) + 3 * particle_count * sizeof(float) +
+           6 * FrameArena::ALIGNMENT;
+}
+
+int ParticleInteractions::cellOf(float x, float y) const {
+    // Particles slightly outside the world (before the wall bounce) go to the border cells
+    const int cell_x = std::clamp(static_cast<int>(x / cell_size), 0, grid_columns - 1);
+    const int cell_y = std::clamp(static_cast<int>(y / cell_size), 0, grid_rows - 1);
+    return cell_y * grid_columns + cell_x;
+}
+
+void ParticleInteractions::build(const ParticleStore& particles, FrameArena& arena) {
+    const int cell_count = grid_columns * grid_rows;
+    const int count = static_cast<int>(particles.size());
+
+    cell_start = arena.allocateArray<int>(cell_count + 1);
+    int* cell_key = arena.allocateArray<int>(count);
+    sorted_index = arena.allocateArray<int>(count);
+    sorted_x = arena.allocateArray<float>(count);
+    sorted_y = arena.allocateArray<float>(count);
+    sorted_radius = arena.allocateArray<float>(count);
+    std::fill(cell_start, cell_start + cell_count + 1, 0);
+
+    // Counting sort by cell key: count per cell, prefix-sum, then scatter in
+    // particle order, so the order inside a cell is deterministic
+    for (int i = 0; i < count; ++i) {
+        cell_key[i] = cellOf(particles.pos_x[i], particles.pos_y[i]);
+        ++cell_start[cell_key[i] + 1];
+    }
+    for (int cell = 0; cell < cell_count; ++cell) {
+        cell_start[cell + 1] += cell_start[cell];
+    }
+    for (int i = 0; i < count; ++i) {
+        sorted_index[cell_start[cell_key[i]]++] = i;
+    }
+
+    // The scatter advanced every start to the next cell's start; shift back
+    for (int cell = cell_count; cell > 0; --cell) {
+        cell_start[cell] = cell_start[cell - 1];
+    }
+    cell_start[0] = 0;
+
+    // Cell-ordered copies, so neighbor scans read contiguous memory
+    for (int slot = 0; slot < count; ++slot) {
+        const int i = sorted_index[slot];
+        sorted_x[slot] = particles.pos_x[i];
+        sorted_y[slot] = particles.pos_y[i];
+        sorted_radius[slot] = particles.radius[i];
+    }
+}
+
+std::size_t ParticleInteractions::applyCells(ParticleStore& particles, float velocity_scale, int begin, int end) const {
+    std::size_t contacts = 0;
+    for (int cell = begin; cell < end; ++cell) {
+        const int cell_x = cell % grid_columns;
+        const int cell_y = cell / grid_columns;
+        const int x0 = std::max(cell_x - 1, 0);
+        const int x1 = std::min(cell_x + 1, grid_columns - 1);
+        const int y0 = std::max(cell_y - 1, 0);
+        const int y1 = std::min(cell_y + 1, grid_rows - 1);
+
+        for (int a = cell_start[cell]; a < cell_start[cell + 1]; ++a) {
+            const float x = sorted_x[a];
+            const float y = sorted_y[a];
+            const float radius = sorted_radius[a];
+            float force_x = 0.0f;
+            float force_y = 0.0f;
+
+            // Neighbor rows are contiguous runs of the sorted arrays
+            for (int ny = y0; ny <= y1; ++ny) {
+                const int row = ny * grid_columns;
+                for (int b = cell_start[row + x0]; b < cell_start[row + x1 + 1]; ++b) {
+                    const float dx = x - sorted_x[b];
+                    const float dy = y - sorted_y[b];
+                    const float contact = radius + sorted_radius[b];
+                    const float distance_squared = dx * dx + dy * dy;
+                    // b == a gives distance 0 and is skipped with exact duplicates
+                    if (distance_squared >= contact * contact || distance_squared == 0.0f) {
+                        continue;
+                    }
+                    const float distance = std::sqrt(distance_squared);
+                    const float push = (contact - distance) / distance;
+                    force_x += dx * push;
+                    force_y += dy * push;
+                    ++contacts;
+                }
+            }
+
+            if (force_x != 0.0f || force_y != 0.0f) {
+                const int i = sorted_index[a];
+                particles.vel_x[i] += force_x * velocity_scale;
+                particles.vel_y[i] += force_y * velocity_scale;
+            }
+        }
+    }
+    return contacts;
+}
+
+void ParticleInteractions::apply(ParticleStore& particles, float delta_time, FrameArena& arena, ThreadPool* pool) {
+    PROFILE_ZONE("ParticleInteractions::apply");
+
+    {
+        PROFILE_ZONE("ParticleInteractions::build");
+        build(particles, arena);
+    }
+
+    // Forces only read the sorted copies and each cell writes the velocities
+    // of its own particles, so cells need no synchronization
+    const float velocity_scale = stiffness * delta_time;
+    const int cell_count = grid_columns * grid_rows;
+    if (pool) {
+        std::atomic<std::size_t> contacts(0);
+        pool->parallelFor(cell_count, CELL_CHUNK_SIZE, [&](std::size_t begin, std::size_t end, int) {
+            contacts.fetch_add(applyCells(particles, velocity_scale, static_cast<int>(begin), static_cast<int>(end)),
+                               std::memory_order_relaxed);
+        });
+        contact_count = contacts.load(std::memory_order_relaxed) / 2;
+    } else {
+        contact_count = applyCells(particles, velocity_scale, 0, cell_count) / 2;
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include "particle_store.h"
+
+class FrameArena;
+class ThreadPool;
+
+// Soft-sphere repulsion between particles, found through a cell list.
+//
+// Every frame the particles are counting-sorted by the key of the grid cell
+// their center is in, and positions and radii are copied into that order. The
+// cell edge covers the largest contact distance, so a particle only meets
+// particles in its own cell and the 8 around it: building and evaluating are
+// both linear in the particle count.
+//
+// Forces are gathered per particle (each pair is evaluated from both sides),
+// so cells can be processed on any worker in any order with identical results.
+class ParticleInteractions {
+public:
+    static constexpr float DEFAULT_STIFFNESS = 200.0f;
+
+    ParticleInteractions();
+
+    // World the particles live in and the largest particle radius; sets the cell size
+    void configure(float world_width, float world_height, float max_radius);
+
+    // Overlapping particles i and j get
+    //   velocity_i += stiffness * (r_i + r_j - distance) * delta_time
+    // along the direction from j to i
+    void setStiffness(float value) { stiffness = value; }
+    float getStiffness() const { return stiffness; }
+
+    // Arena bytes one apply() takes for this many particles
+    std::size_t getFrameScratchBytes(std::size_t particle_count) const;
+
+    // Rebuild the cell list from the current positions and add the repulsion
+    // to every particle's velocity. Scratch comes from arena, which must stay
+    // alive until apply() returns; pool may be nullptr.
+    void apply(ParticleStore& particles, float delta_time, FrameArena& arena, ThreadPool* pool);
+
+    // Overlapping pairs seen by the last apply()
+    std::size_t getContactCount() const { return contact_count; }
+
+private:
+    float cell_size;
+    int grid_columns;
+    int grid_rows;
+    float stiffness;
+    std::size_t contact_count;
+
+    // Cells per parallel work item; a multiple of ThreadPool::CHUNK_ALIGNMENT
+    static constexpr std::size_t CELL_CHUNK_SIZE = 512;
+
+    // Cell list of the frame in progress (arena memory)
+    int* cell_start;        // grid_columns * grid_rows + 1 offsets into the sorted arrays
+    int* sorted_index;      // Particle index of every sorted slot
+    float* sorted_x;
+    float* sorted_y;
+    float* sorted_radius;
+
+    int cellOf(float x, float y) const;
+    void build(const ParticleStore& particles, FrameArena& arena);
+    // Forces for the particles of cells [begin, end); returns the contacts seen
+    std::size_t applyCells(ParticleStore& particles, float velocity_scale, int begin, int end) const;
+};
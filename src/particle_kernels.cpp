@@ -0,0 +1,513 @@
+#include "particle_kernels.h"
+#include "simd_config.h"
+#include <algorithm>
+
+namespace {
+
+using IntegrateFn = void (*)(float*, float*, float*, float*, const float*, const float*,
+                             std::size_t, const IntegrationStep&);
+using BounceFn = void (*)(float*, float*, float*, float*, const float*,
+                          std::size_t, float, float, float);
+using NoiseFn = void (*)(const CounterRng&, uint64_t, float, float, const uint32_t*, float*, float*, float*,
+                         std::size_t, std::size_t);
+
+// Philox key schedule and counter words shared by every implementation
+struct PhiloxKeys {
+    uint32_t key0[CounterRng::ROUNDS];
+    uint32_t key1[CounterRng::ROUNDS];
+
+    explicit PhiloxKeys(const CounterRng& rng) {
+        uint32_t k0 = rng.getKey0();
+        uint32_t k1 = rng.getKey1();
+        for (int round = 0; round < CounterRng::ROUNDS; ++round) {
+            key0[round] = k0;
+            key1[round] = k1;
+            k0 += CounterRng::WEYL_0;
+            k1 += CounterRng::WEYL_1;
+        }
+    }
+};
+
+// --- SCALAR IMPLEMENTATION (also handles SIMD tails) ---
+
+void integrateScalar(float* pos_x, float* pos_y, float* vel_x, float* vel_y,
+                     const float* noise_x, const float* noise_y,
+                     std::size_t count, const IntegrationStep& step) {
+    for (std::size_t i = 0; i < count; ++i) {
+        vel_x[i] = (vel_x[i] + noise_x[i] * step.noise_scale) * step.damping;
+        vel_y[i] = (vel_y[i] + noise_y[i] * step.noise_scale) * step.damping;
+        pos_x[i] += vel_x[i] * step.position_scale;
+        pos_y[i] += vel_y[i] * step.position_scale;
+    }
+}
+
+void bounceAxisScalar(float* pos, float* vel, const float* radius, std::size_t count,
+                      float extent, float restitution) {
+    for (std::size_t i = 0; i < count; ++i) {
+        const float r = radius[i];
+        if (pos[i] <= r || pos[i] >= extent - r) {
+            vel[i] *= restitution;
+            pos[i] = std::max(r, std::min(pos[i], extent - r));
+        }
+    }
+}
+
+void noiseScalar(const CounterRng& rng, uint64_t frame, float noise_low, float noise_high, const uint32_t* ids,
+                 float* noise_x, float* noise_y, float* color_roll,
+                 std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; ++i) {
+        CounterRng::Block block = rng.generate(ids[i], frame, CounterRng::STREAM_MOTION);
+        noise_x[i] = CounterRng::toRange(block[0], noise_low, noise_high);
+        noise_y[i] = CounterRng::toRange(block[1], noise_low, noise_high);
+        color_roll[i] = CounterRng::toUnitFloat(block[2]);
+    }
+}
+
+[[maybe_unused]]
+void bounceScalar(float* pos_x, float* pos_y, float* vel_x, float* vel_y, const float* radius,
+                  std::size_t count, float width, float height, float restitution) {
+    bounceAxisScalar(pos_x, vel_x, radius, count, width, restitution);
+    bounceAxisScalar(pos_y, vel_y, radius, count, height, restitution);
+}
+
+// --- AVX2 IMPLEMENTATION (8 particles per iteration) ---
+#if defined(HAVE_AVX2_DISPATCH)
+
+// Lanes [0, remaining) set, for masked loads and stores of a tail. The AVX2
+// kernels finish their arrays this way rather than with the scalar loop, so a
+// particle gets the same (fused) arithmetic whatever its index: results do not
+// depend on where chunks or domain tiles end.
+SIMD_TARGET_AVX2
+inline __m256i tailMaskAvx2(std::size_t remaining) {
+    return _mm256_cmpgt_epi32(_mm256_set1_epi32(static_cast<int>(remaining)), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+}
+
+SIMD_TARGET_AVX2
+void integrateAvx2(float* pos_x, float* pos_y, float* vel_x, float* vel_y,
+                   const float* noise_x, const float* noise_y,
+                   std::size_t count, const IntegrationStep& step) {
+    const __m256 noise_scale = _mm256_set1_ps(step.noise_scale);
+    const __m256 damping = _mm256_set1_ps(step.damping);
+    const __m256 position_scale = _mm256_set1_ps(step.position_scale);
+
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 vx = _mm256_fmadd_ps(_mm256_loadu_ps(noise_x + i), noise_scale, _mm256_loadu_ps(vel_x + i));
+        __m256 vy = _mm256_fmadd_ps(_mm256_loadu_ps(noise_y + i), noise_scale, _mm256_loadu_ps(vel_y + i));
+        vx = _mm256_mul_ps(vx, damping);
+        vy = _mm256_mul_ps(vy, damping);
+
+        _mm256_storeu_ps(vel_x + i, vx);
+        _mm256_storeu_ps(vel_y + i, vy);
+        _mm256_storeu_ps(pos_x + i, _mm256_fmadd_ps(vx, position_scale, _mm256_loadu_ps(pos_x + i)));
+        _mm256_storeu_ps(pos_y + i, _mm256_fmadd_ps(vy, position_scale, _mm256_loadu_ps(pos_y + i)));
+    }
+
+    if (i < count) {
+        const __m256i mask = tailMaskAvx2(count - i);
+        __m256 vx = _mm256_fmadd_ps(_mm256_maskload_ps(noise_x + i, mask), noise_scale,
+                                    _mm256_maskload_ps(vel_x + i, mask));
+        __m256 vy = _mm256_fmadd_ps(_mm256_maskload_ps(noise_y + i, mask), noise_scale,
+                                    _mm256_maskload_ps(vel_y + i, mask));
+        vx = _mm256_mul_ps(vx, damping);
+        vy = _mm256_mul_ps(vy, damping);
+
+        _mm256_maskstore_ps(vel_x + i, mask, vx);
+        _mm256_maskstore_ps(vel_y + i, mask, vy);
+        _mm256_maskstore_ps(pos_x + i, mask, _mm256_fmadd_ps(vx, position_scale, _mm256_maskload_ps(pos_x + i, mask)));
+        _mm256_maskstore_ps(pos_y + i, mask, _mm256_fmadd_ps(vy, position_scale, _mm256_maskload_ps(pos_y + i, mask)));
+    }
+
+    // GCC leaves out the vzeroupper it normally ends AVX functions with when
+    // they finish in a tail call (as bounceAxisAvx2 does); dirty upper halves
+    // would slow every later SSE instruction (libm included), so the AVX2
+    // kernels clear them themselves
+    _mm256_zeroupper();
+}
+
+// 32x32 -> 64 bit multiply of all 8 lanes, split into high and low words
+SIMD_TARGET_AVX2
+inline void mulhiloAvx2(__m256i a, __m256i multiplier, __m256i& hi, __m256i& lo) {
+    __m256i even = _mm256_mul_epu32(a, multiplier);
+    __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), multiplier);
+    lo = _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xAA);
+    hi = _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xAA);
+}
+
+// Motion block for the 8 particle ids in c0: noise x/y in [low, low + range)
+// and the color roll, as CounterRng::toRange / toUnitFloat (may differ from
+// the scalar mapping in the last ulp once fused)
+struct MotionLanesAvx2 {
+    __m256 x;
+    __m256 y;
+    __m256 roll;
+};
+
+SIMD_TARGET_AVX2
+inline MotionLanesAvx2 motionLanesAvx2(__m256i c0, uint64_t frame, const PhiloxKeys& keys,
+                                       __m256 low, __m256 noise_scale) {
+    const __m256i multiplier0 = _mm256_set1_epi32(static_cast<int>(CounterRng::MULTIPLIER_0));
+    const __m256i multiplier1 = _mm256_set1_epi32(static_cast<int>(CounterRng::MULTIPLIER_1));
+    __m256i c1 = _mm256_set1_epi32(static_cast<int>(static_cast<uint32_t>(frame)));
+    __m256i c2 = _mm256_set1_epi32(static_cast<int>(static_cast<uint32_t>(frame >> 32)));
+    __m256i c3 = _mm256_set1_epi32(static_cast<int>(CounterRng::STREAM_MOTION));
+
+    for (int round = 0; round < CounterRng::ROUNDS; ++round) {
+        __m256i hi0, lo0, hi1, lo1;
+        mulhiloAvx2(c0, multiplier0, hi0, lo0);
+        mulhiloAvx2(c2, multiplier1, hi1, lo1);
+
+        c0 = _mm256_xor_si256(_mm256_xor_si256(hi1, c1), _mm256_set1_epi32(static_cast<int>(keys.key0[round])));
+        c1 = lo1;
+        c2 = _mm256_xor_si256(_mm256_xor_si256(hi0, c3), _mm256_set1_epi32(static_cast<int>(keys.key1[round])));
+        c3 = lo0;
+    }
+
+    const __m256 unit_scale = _mm256_set1_ps(1.0f / 16777216.0f);
+    MotionLanesAvx2 lanes;
+    lanes.x = _mm256_add_ps(low, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(c0, 8)), noise_scale));
+    lanes.y = _mm256_add_ps(low, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(c1, 8)), noise_scale));
+    lanes.roll = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(c2, 8)), unit_scale);
+    return lanes;
+}
+
+SIMD_TARGET_AVX2
+void noiseAvx2(const CounterRng& rng, uint64_t frame, float noise_low, float noise_high, const uint32_t* ids,
+               float* noise_x, float* noise_y, float* color_roll,
+               std::size_t begin, std::size_t end) {
+    const PhiloxKeys keys(rng);
+    const __m256 low = _mm256_set1_ps(noise_low);
+    const __m256 noise_scale = _mm256_set1_ps((noise_high - noise_low) * (1.0f / 16777216.0f));
+
+    std::size_t i = begin;
+    for (; i + 8 <= end; i += 8) {
+        const __m256i c0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ids + i));
+        const MotionLanesAvx2 lanes = motionLanesAvx2(c0, frame, keys, low, noise_scale);
+        _mm256_storeu_ps(noise_x + i, lanes.x);
+        _mm256_storeu_ps(noise_y + i, lanes.y);
+        _mm256_storeu_ps(color_roll + i, lanes.roll);
+    }
+
+    if (i < end) {
+        const __m256i mask = tailMaskAvx2(end - i);
+        const __m256i c0 = _mm256_maskload_epi32(reinterpret_cast<const int*>(ids + i), mask);
+        const MotionLanesAvx2 lanes = motionLanesAvx2(c0, frame, keys, low, noise_scale);
+        _mm256_maskstore_ps(noise_x + i, mask, lanes.x);
+        _mm256_maskstore_ps(noise_y + i, mask, lanes.y);
+        _mm256_maskstore_ps(color_roll + i, mask, lanes.roll);
+    }
+
+    _mm256_zeroupper(); // See integrateAvx2
+}
+
+SIMD_TARGET_AVX2
+void bounceAxisAvx2(float* pos, float* vel, const float* radius, std::size_t count,
+                    float extent, float restitution) {
+    const __m256 extent_vec = _mm256_set1_ps(extent);
+    const __m256 restitution_vec = _mm256_set1_ps(restitution);
+
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 r = _mm256_loadu_ps(radius + i);
+        __m256 upper = _mm256_sub_ps(extent_vec, r);
+        __m256 p = _mm256_loadu_ps(pos + i);
+        __m256 v = _mm256_loadu_ps(vel + i);
+
+        __m256 hit = _mm256_or_ps(_mm256_cmp_ps(p, r, _CMP_LE_OQ), _mm256_cmp_ps(p, upper, _CMP_GE_OQ));
+        v = _mm256_blendv_ps(v, _mm256_mul_ps(v, restitution_vec), hit);
+        p = _mm256_max_ps(r, _mm256_min_ps(p, upper));
+
+        _mm256_storeu_ps(pos + i, p);
+        _mm256_storeu_ps(vel + i, v);
+    }
+
+    _mm256_zeroupper(); // See integrateAvx2
+    bounceAxisScalar(pos + i, vel + i, radius + i, count - i, extent, restitution);
+}
+
+SIMD_TARGET_AVX2
+void bounceAvx2(float* pos_x, float* pos_y, float* vel_x, float* vel_y, const float* radius,
+                std::size_t count, float width, float height, float restitution) {
+    bounceAxisAvx2(pos_x, vel_x, radius, count, width, restitution);
+    bounceAxisAvx2(pos_y, vel_y, radius, count, height, restitution);
+}
+
+#endif
+
+// --- SSE2 IMPLEMENTATION (4 particles per iteration, x86 baseline) ---
+#if defined(USE_SSE)
+
+void integrateSse(float* pos_x, float* pos_y, float* vel_x, float* vel_y,
+                  const float* noise_x, const float* noise_y,
+                  std::size_t count, const IntegrationStep& step) {
+    const __m128 noise_scale = _mm_set1_ps(step.noise_scale);
+    const __m128 damping = _mm_set1_ps(step.damping);
+    const __m128 position_scale = _mm_set1_ps(step.position_scale);
+
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 vx = _mm_add_ps(_mm_loadu_ps(vel_x + i), _mm_mul_ps(_mm_loadu_ps(noise_x + i), noise_scale));
+        __m128 vy = _mm_add_ps(_mm_loadu_ps(vel_y + i), _mm_mul_ps(_mm_loadu_ps(noise_y + i), noise_scale));
+        vx = _mm_mul_ps(vx, damping);
+        vy = _mm_mul_ps(vy, damping);
+
+        _mm_storeu_ps(vel_x + i, vx);
+        _mm_storeu_ps(vel_y + i, vy);
+        _mm_storeu_ps(pos_x + i, _mm_add_ps(_mm_loadu_ps(pos_x + i), _mm_mul_ps(vx, position_scale)));
+        _mm_storeu_ps(pos_y + i, _mm_add_ps(_mm_loadu_ps(pos_y + i), _mm_mul_ps(vy, position_scale)));
+    }
+
+    integrateScalar(pos_x + i, pos_y + i, vel_x + i, vel_y + i, noise_x + i, noise_y + i, count - i, step);
+}
+
+// 32x32 -> 64 bit multiply of all 4 lanes, split into high and low words
+inline void mulhiloSse(__m128i a, __m128i multiplier, __m128i& hi, __m128i& lo) {
+    __m128i even = _mm_shuffle_epi32(_mm_mul_epu32(a, multiplier), _MM_SHUFFLE(3, 1, 2, 0));
+    __m128i odd = _mm_shuffle_epi32(_mm_mul_epu32(_mm_srli_epi64(a, 32), multiplier), _MM_SHUFFLE(3, 1, 2, 0));
+    lo = _mm_unpacklo_epi32(even, odd);
+    hi = _mm_unpackhi_epi32(even, odd);
+}
+
+void noiseSse(const CounterRng& rng, uint64_t frame, float noise_low, float noise_high, const uint32_t* ids,
+              float* noise_x, float* noise_y, float* color_roll,
+              std::size_t begin, std::size_t end) {
+    const PhiloxKeys keys(rng);
+    const __m128i multiplier0 = _mm_set1_epi32(static_cast<int>(CounterRng::MULTIPLIER_0));
+    const __m128i multiplier1 = _mm_set1_epi32(static_cast<int>(CounterRng::MULTIPLIER_1));
+    const __m128 low = _mm_set1_ps(noise_low);
+    const __m128 noise_scale = _mm_set1_ps((noise_high - noise_low) * (1.0f / 16777216.0f));
+    const __m128 unit_scale = _mm_set1_ps(1.0f / 16777216.0f);
+
+    std::size_t i = begin;
+    for (; i + 4 <= end; i += 4) {
+        __m128i c0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ids + i));
+        __m128i c1 = _mm_set1_epi32(static_cast<int>(static_cast<uint32_t>(frame)));
+        __m128i c2 = _mm_set1_epi32(static_cast<int>(static_cast<uint32_t>(frame >> 32)));
+        __m128i c3 = _mm_set1_epi32(static_cast<int>(CounterRng::STREAM_MOTION));
+
+        for (int round = 0; round < CounterRng::ROUNDS; ++round) {
+            __m128i hi0, lo0, hi1, lo1;
+            mulhiloSse(c0, multiplier0, hi0, lo0);
+            mulhiloSse(c2, multiplier1, hi1, lo1);
+
+            c0 = _mm_xor_si128(_mm_xor_si128(hi1, c1), _mm_set1_epi32(static_cast<int>(keys.key0[round])));
+            c1 = lo1;
+            c2 = _mm_xor_si128(_mm_xor_si128(hi0, c3), _mm_set1_epi32(static_cast<int>(keys.key1[round])));
+            c3 = lo0;
+        }
+
+        __m128 x = _mm_cvtepi32_ps(_mm_srli_epi32(c0, 8));
+        __m128 y = _mm_cvtepi32_ps(_mm_srli_epi32(c1, 8));
+        __m128 roll = _mm_cvtepi32_ps(_mm_srli_epi32(c2, 8));
+        _mm_storeu_ps(noise_x + i, _mm_add_ps(low, _mm_mul_ps(x, noise_scale)));
+        _mm_storeu_ps(noise_y + i, _mm_add_ps(low, _mm_mul_ps(y, noise_scale)));
+        _mm_storeu_ps(color_roll + i, _mm_mul_ps(roll, unit_scale));
+    }
+
+    noiseScalar(rng, frame, noise_low, noise_high, ids, noise_x, noise_y, color_roll, i, end);
+}
+
+void bounceAxisSse(float* pos, float* vel, const float* radius, std::size_t count,
+                   float extent, float restitution) {
+    const __m128 extent_vec = _mm_set1_ps(extent);
+    const __m128 restitution_vec = _mm_set1_ps(restitution);
+
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 r = _mm_loadu_ps(radius + i);
+        __m128 upper = _mm_sub_ps(extent_vec, r);
+        __m128 p = _mm_loadu_ps(pos + i);
+        __m128 v = _mm_loadu_ps(vel + i);
+
+        // SSE2 has no blendv, so select with and/andnot/or
+        __m128 hit = _mm_or_ps(_mm_cmple_ps(p, r), _mm_cmpge_ps(p, upper));
+        v = _mm_or_ps(_mm_and_ps(hit, _mm_mul_ps(v, restitution_vec)), _mm_andnot_ps(hit, v));
+        p = _mm_max_ps(r, _mm_min_ps(p, upper));
+
+        _mm_storeu_ps(pos + i, p);
+        _mm_storeu_ps(vel + i, v);
+    }
+
+    bounceAxisScalar(pos + i, vel + i, radius + i, count - i, extent, restitution);
+}
+
+void bounceSse(float* pos_x, float* pos_y, float* vel_x, float* vel_y, const float* radius,
+               std::size_t count, float width, float height, float restitution) {
+    bounceAxisSse(pos_x, vel_x, radius, count, width, restitution);
+    bounceAxisSse(pos_y, vel_y, radius, count, height, restitution);
+}
+
+#endif
+
+// --- NEON IMPLEMENTATION (4 particles per iteration) ---
+#if defined(USE_NEON)
+
+void integrateNeon(float* pos_x, float* pos_y, float* vel_x, float* vel_y,
+                   const float* noise_x, const float* noise_y,
+                   std::size_t count, const IntegrationStep& step) {
+    const float32x4_t noise_scale = vdupq_n_f32(step.noise_scale);
+    const float32x4_t damping = vdupq_n_f32(step.damping);
+    const float32x4_t position_scale = vdupq_n_f32(step.position_scale);
+
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t vx = vmlaq_f32(vld1q_f32(vel_x + i), vld1q_f32(noise_x + i), noise_scale);
+        float32x4_t vy = vmlaq_f32(vld1q_f32(vel_y + i), vld1q_f32(noise_y + i), noise_scale);
+        vx = vmulq_f32(vx, damping);
+        vy = vmulq_f32(vy, damping);
+
+        vst1q_f32(vel_x + i, vx);
+        vst1q_f32(vel_y + i, vy);
+        vst1q_f32(pos_x + i, vmlaq_f32(vld1q_f32(pos_x + i), vx, position_scale));
+        vst1q_f32(pos_y + i, vmlaq_f32(vld1q_f32(pos_y + i), vy, position_scale));
+    }
+
+    integrateScalar(pos_x + i, pos_y + i, vel_x + i, vel_y + i, noise_x + i, noise_y + i, count - i, step);
+}
+
+// 32x32 -> 64 bit multiply of all 4 lanes, split into high and low words
+inline void mulhiloNeon(uint32x4_t a, uint32x2_t multiplier, uint32x4_t& hi, uint32x4_t& lo) {
+    uint32x4_t low_half = vreinterpretq_u32_u64(vmull_u32(vget_low_u32(a), multiplier));
+    uint32x4_t high_half = vreinterpretq_u32_u64(vmull_u32(vget_high_u32(a), multiplier));
+    uint32x4x2_t words = vuzpq_u32(low_half, high_half);
+    lo = words.val[0];
+    hi = words.val[1];
+}
+
+void noiseNeon(const CounterRng& rng, uint64_t frame, float noise_low, float noise_high, const uint32_t* ids,
+               float* noise_x, float* noise_y, float* color_roll,
+               std::size_t begin, std::size_t end) {
+    const PhiloxKeys keys(rng);
+    const uint32x2_t multiplier0 = vdup_n_u32(CounterRng::MULTIPLIER_0);
+    const uint32x2_t multiplier1 = vdup_n_u32(CounterRng::MULTIPLIER_1);
+    const float32x4_t low = vdupq_n_f32(noise_low);
+    const float32x4_t noise_scale = vdupq_n_f32((noise_high - noise_low) * (1.0f / 16777216.0f));
+    const float32x4_t unit_scale = vdupq_n_f32(1.0f / 16777216.0f);
+
+    std::size_t i = begin;
+    for (; i + 4 <= end; i += 4) {
+        uint32x4_t c0 = vld1q_u32(ids + i);
+        uint32x4_t c1 = vdupq_n_u32(static_cast<uint32_t>(frame));
+        uint32x4_t c2 = vdupq_n_u32(static_cast<uint32_t>(frame >> 32));
+        uint32x4_t c3 = vdupq_n_u32(CounterRng::STREAM_MOTION);
+
+        for (int round = 0; round < CounterRng::ROUNDS; ++round) {
+            uint32x4_t hi0, lo0, hi1, lo1;
+            mulhiloNeon(c0, multiplier0, hi0, lo0);
+            mulhiloNeon(c2, multiplier1, hi1, lo1);
+
+            c0 = veorq_u32(veorq_u32(hi1, c1), vdupq_n_u32(keys.key0[round]));
+            c1 = lo1;
+            c2 = veorq_u32(veorq_u32(hi0, c3), vdupq_n_u32(keys.key1[round]));
+            c3 = lo0;
+        }
+
+        float32x4_t x = vcvtq_f32_u32(vshrq_n_u32(c0, 8));
+        float32x4_t y = vcvtq_f32_u32(vshrq_n_u32(c1, 8));
+        float32x4_t roll = vcvtq_f32_u32(vshrq_n_u32(c2, 8));
+        vst1q_f32(noise_x + i, vaddq_f32(low, vmulq_f32(x, noise_scale)));
+        vst1q_f32(noise_y + i, vaddq_f32(low, vmulq_f32(y, noise_scale)));
+        vst1q_f32(color_roll + i, vmulq_f32(roll, unit_scale));
+    }
+
+    noiseScalar(rng, frame, noise_low, noise_high, ids, noise_x, noise_y, color_roll, i, end);
+}
+
+void bounceAxisNeon(float* pos, float* vel, const float* radius, std::size_t count,
+                    float extent, float restitution) {
+    const float32x4_t extent_vec = vdupq_n_f32(extent);
+    const float32x4_t restitution_vec = vdupq_n_f32(restitution);
+
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t r = vld1q_f32(radius + i);
+        float32x4_t upper = vsubq_f32(extent_vec, r);
+        float32x4_t p = vld1q_f32(pos + i);
+        float32x4_t v = vld1q_f32(vel + i);
+
+        uint32x4_t hit = vorrq_u32(vcleq_f32(p, r), vcgeq_f32(p, upper));
+        v = vbslq_f32(hit, vmulq_f32(v, restitution_vec), v);
+        p = vmaxq_f32(r, vminq_f32(p, upper));
+
+        vst1q_f32(pos + i, p);
+        vst1q_f32(vel + i, v);
+    }
+
+    bounceAxisScalar(pos + i, vel + i, radius + i, count - i, extent, restitution);
+}
+
+void bounceNeon(float* pos_x, float* pos_y, float* vel_x, float* vel_y, const float* radius,
+                std::size_t count, float width, float height, float restitution) {
+    bounceAxisNeon(pos_x, vel_x, radius, count, width, restitution);
+    bounceAxisNeon(pos_y, vel_y, radius, count, height, restitution);
+}
+
+#endif
+
+// --- RUNTIME DISPATCH ---
+
+struct KernelTable {
+    NoiseFn noise;
+    IntegrateFn integrate;
+    BounceFn bounce;
+    const char* name;
+};
+
+KernelTable selectKernels() {
+#if defined(HAVE_AVX2_DISPATCH)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return {noiseAvx2, integrateAvx2, bounceAvx2, "AVX2"};
+    }
+#endif
+#if defined(USE_SSE)
+    return {noiseSse, integrateSse, bounceSse, "SSE2"};
+#elif defined(USE_NEON)
+    return {noiseNeon, integrateNeon, bounceNeon, "NEON"};
+#else
+    return {noiseScalar, integrateScalar, bounceScalar, "scalar"};
+#endif
+}
+
+const KernelTable& kernels() {
+    static const KernelTable table = selectKernels();
+    return table;
+}
+
+} // namespace
+
+void ParticleKernels::generateMotionNoise(const CounterRng& rng, uint64_t frame, float noise_low, float noise_high,
+                                          const uint32_t* ids, float* noise_x, float* noise_y, float* color_roll,
+                                          std::size_t begin, std::size_t end) {
+    if (begin >= end) {
+        return;
+    }
+
+    kernels().noise(rng, frame, noise_low, noise_high, ids, noise_x, noise_y, color_roll, begin, end);
+}
+
+void ParticleKernels::integrate(ParticleStore& particles, const float* noise_x, const float* noise_y,
+                                const IntegrationStep& step, std::size_t begin, std::size_t end) {
+    if (begin >= end) {
+        return;
+    }
+
+    kernels().integrate(particles.pos_x.data() + begin, particles.pos_y.data() + begin,
+                        particles.vel_x.data() + begin, particles.vel_y.data() + begin,
+                        noise_x + begin, noise_y + begin, end - begin, step);
+}
+
+void ParticleKernels::bounceWalls(ParticleStore& particles, float width, float height, float restitution,
+                                  std::size_t begin, std::size_t end) {
+    if (begin >= end) {
+        return;
+    }
+
+    kernels().bounce(particles.pos_x.data() + begin, particles.pos_y.data() + begin,
+                     particles.vel_x.data() + begin, particles.vel_y.data() + begin,
+                     particles.radius.data() + begin, end - begin, width, height, restitution);
+}
+
+const char* ParticleKernels::getInstructionSetName() {
+    return kernels().name;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "particle_store.h"
+#include "counter_rng.h"
+
+// Coefficients for one integration step:
+//   velocity = (velocity + noise * noise_scale) * damping
+//   position += velocity * position_scale
+struct IntegrationStep {
+    float noise_scale;
+    float damping;
+    float position_scale;
+};
+
+// Hot particle loops with explicit SIMD implementations.
+// The instruction set is chosen once at runtime (AVX2 when the CPU has it,
+// otherwise SSE2 / NEON / scalar), so one binary runs at full width everywhere.
+class ParticleKernels {
+public:
+    // Philox motion stream for particles [begin, end) at the given frame, keyed
+    // by ids[i] (ParticleStore::id): noise_x/noise_y uniform in
+    // [noise_low, noise_high), color_roll uniform in [0, 1)
+    static void generateMotionNoise(const CounterRng& rng, uint64_t frame, float noise_low, float noise_high,
+                                    const uint32_t* ids, float* noise_x, float* noise_y, float* color_roll,
+                                    std::size_t begin, std::size_t end);
+
+    // Noise + damping + position step for particles [begin, end)
+    static void integrate(ParticleStore& particles, const float* noise_x, const float* noise_y,
+                          const IntegrationStep& step, std::size_t begin, std::size_t end);
+
+    // Branchless wall bounce: clamp into [radius, extent - radius] and scale the
+    // velocity component by restitution where a wall was touched
+    static void bounceWalls(ParticleStore& particles, float width, float height, float restitution,
+                            std::size_t begin, std::size_t end);
+
+    // Name of the instruction set picked by the runtime dispatcher
+    static const char* getInstructionSetName();
+};
@@ -0,0 +1,51 @@
+#include "particle_store.h"
+
+void ParticleStore::reserve(std::size_t count) {
+    pos_x.reserve(count);
+    pos_y.reserve(count);
+    vel_x.reserve(count);
+    vel_y.reserve(count);
+    radius.reserve(count);
+    color.reserve(count);
+    id.reserve(count);
+}
+
+void ParticleStore::clear() {
+    pos_x.clear();
+    pos_y.clear();
+    vel_x.clear();
+    vel_y.clear();
+    radius.clear();
+    color.clear();
+    id.clear();
+}
+
+void ParticleStore::add(float x, float y, float vx, float vy, float r, const Color& c) {
+    id.push_back(static_cast<uint32_t>(size()));
+    pos_x.push_back(x);
+    pos_y.push_back(y);
+    vel_x.push_back(vx);
+    vel_y.push_back(vy);
+    radius.push_back(r);
+    color.push_back(c);
+}
+
+void ParticleStore::append(const ParticleStore& source, std::size_t i) {
+    pos_x.push_back(source.pos_x[i]);
+    pos_y.push_back(source.pos_y[i]);
+    vel_x.push_back(source.vel_x[i]);
+    vel_y.push_back(source.vel_y[i]);
+    radius.push_back(source.radius[i]);
+    color.push_back(source.color[i]);
+    id.push_back(source.id[i]);
+}
+
+void ParticleStore::resize(std::size_t count) {
+    pos_x.resize(count);
+    pos_y.resize(count);
+    vel_x.resize(count);
+    vel_y.resize(count);
+    radius.resize(count);
+    color.resize(count);
+    id.resize(count);
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "aligned_allocator.h"
+#include "core_types.h"
+
+// Structure-of-arrays particle storage.
+// Hot data (position, velocity) lives in its own contiguous arrays, so the
+// integration loop streams only those and never pulls colors through the cache.
+//
+// id is a particle's identity, fixed at creation: it keys the particle's
+// random streams, so a particle draws the same noise wherever it sits in the
+// arrays (e.g. after migrating to another domain tile).
+struct ParticleStore {
+    AlignedVector<float> pos_x;
+    AlignedVector<float> pos_y;
+    AlignedVector<float> vel_x;
+    AlignedVector<float> vel_y;
+    AlignedVector<float> radius;
+    AlignedVector<Color> color;
+    AlignedVector<uint32_t> id;
+
+    void reserve(std::size_t count);
+    void clear();
+    // New particle with id = size()
+    void add(float x, float y, float vx, float vy, float r, const Color& c);
+    // Copy of particle i of source, id included
+    void append(const ParticleStore& source, std::size_t i);
+    void resize(std::size_t count);
+
+    std::size_t size() const { return pos_x.size(); }
+    bool empty() const { return pos_x.empty(); }
+};
@@ -0,0 +1,226 @@
+#include "perf_counters.h"
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <ostream>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+PerfCounterValues& PerfCounterValues::operator+=(const PerfCounterValues& other) {
+    for (int i = 0; i < PERF_EVENT_COUNT; ++i) {
+        counts[i] += other.counts[i];
+    }
+    return *this;
+}
+
+double PerfCounterValues::ipc() const {
+    return counts[PERF_CYCLES] > 0 ?
+        static_cast<double>(counts[PERF_INSTRUCTIONS]) / static_cast<double>(counts[PERF_CYCLES]) : 0.0;
+}
+
+PerfCounterValues operator-(const PerfCounterValues& end, const PerfCounterValues& start) {
+    PerfCounterValues delta;
+    for (int i = 0; i < PERF_EVENT_COUNT; ++i) {
+        // Scaled multiplexed counts can step back a little; clamp at zero
+        delta.counts[i] = end.counts[i] > start.counts[i] ? end.counts[i] - start.counts[i] : 0;
+    }
+    return delta;
+}
+
+PhaseCounters& PhaseCounters::operator+=(const PhaseCounters& other) {
+    matrix += other.matrix;
+    obstacles += other.obstacles;
+    particles += other.particles;
+    return *this;
+}
+
+PerfCounters::PerfCounters() : leader_fd(-1), open_count(0) {
+    for (int i = 0; i < PERF_EVENT_COUNT; ++i) {
+        fds[i] = -1;
+        slots[i] = -1;
+    }
+}
+
+PerfCounters::~PerfCounters() {
+    close();
+}
+
+const char* PerfCounters::getEventName(int event) {
+    switch (event) {
+        case PERF_CYCLES: return "cycles";
+        case PERF_INSTRUCTIONS: return "instructions";
+        case PERF_L1D_MISSES: return "l1d_misses";
+        case PERF_LLC_MISSES: return "llc_misses";
+        case PERF_BRANCH_MISSES: return "branch_misses";
+        default: return "unknown";
+    }
+}
+
+#if defined(__linux__)
+
+namespace {
+
+void describeEvent(int event, perf_event_attr& attr) {
+    switch (event) {
+        case PERF_CYCLES:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+        case PERF_INSTRUCTIONS:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+        case PERF_L1D_MISSES:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_L1D |
+                          (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                          (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            break;
+        case PERF_LLC_MISSES:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CACHE_MISSES;
+            break;
+        case PERF_BRANCH_MISSES:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+            break;
+    }
+}
+
+} // namespace
+
+bool PerfCounters::open() {
+    close();
+
+    int first_errno = 0;
+    for (int event = 0; event < PERF_EVENT_COUNT; ++event) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        describeEvent(event, attr);
+        attr.disabled = leader_fd < 0 ? 1 : 0; // The leader starts the whole group
+        attr.exclude_kernel = 1;               // User space only: allowed up to paranoid level 2
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        // pid 0, cpu -1: this thread, on whichever CPU it runs
+        const int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, leader_fd, 0));
+        if (fd < 0) {
+            if (first_errno == 0) {
+                first_errno = errno;
+            }
+            continue;
+        }
+        if (leader_fd < 0) {
+            leader_fd = fd;
+        }
+        fds[event] = fd;
+        slots[event] = open_count++;
+    }
+
+    if (leader_fd < 0) {
+        error = std::string("perf_event_open failed: ") + std::strerror(first_errno);
+        return false;
+    }
+
+    ioctl(leader_fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(leader_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    error.clear();
+    return true;
+}
+
+void PerfCounters::close() {
+    for (int i = 0; i < PERF_EVENT_COUNT; ++i) {
+        if (fds[i] >= 0) {
+            ::close(fds[i]);
+        }
+        fds[i] = -1;
+        slots[i] = -1;
+    }
+    leader_fd = -1;
+    open_count = 0;
+}
+
+bool PerfCounters::read(PerfCounterValues& values) const {
+    values = PerfCounterValues();
+    if (leader_fd < 0) {
+        return false;
+    }
+
+    // PERF_FORMAT_GROUP layout: nr, time_enabled, time_running, value[nr]
+    uint64_t buffer[3 + PERF_EVENT_COUNT];
+    const ssize_t bytes = ::read(leader_fd, buffer, sizeof(buffer));
+    if (bytes < static_cast<ssize_t>(3 * sizeof(uint64_t))) {
+        return false;
+    }
+    const uint64_t count = buffer[0];
+    const uint64_t enabled = buffer[1];
+    const uint64_t running = buffer[2];
+    if (running == 0) {
+        return false; // The group never got onto the PMU
+    }
+    const double scale = running < enabled ? static_cast<double>(enabled) / running : 1.0;
+
+    for (int event = 0; event < PERF_EVENT_COUNT; ++event) {
+        if (slots[event] >= 0 && static_cast<uint64_t>(slots[event]) < count) {
+            values.counts[event] = static_cast<uint64_t>(buffer[3 + slots[event]] * scale);
+        }
+    }
+    return true;
+}
+
+#else
+
+bool PerfCounters::open() {
+    error = "perf_event counters need Linux";
+    return false;
+}
+
+void PerfCounters::close() {
+}
+
+bool PerfCounters::read(PerfCounterValues& values) const {
+    values = PerfCounterValues();
+    return false;
+}
+
+#endif
+
+void PerfCounters::formatPhases(std::ostream& out, const PhaseCounters& counters, double frames) const {
+    if (frames <= 0.0) {
+        return;
+    }
+    const std::ios_base::fmtflags flags = out.flags();
+    const std::streamsize precision = out.precision();
+    out << std::fixed;
+
+    auto writePhase = [&](const char* name, const PerfCounterValues& values) {
+        out << std::left << std::setw(10) << name << std::right;
+        if (hasEvent(PERF_CYCLES) && hasEvent(PERF_INSTRUCTIONS)) {
+            out << " IPC " << std::setprecision(2) << values.ipc();
+        }
+        if (hasEvent(PERF_CYCLES)) {
+            out << " | " << std::setprecision(2) << values.counts[PERF_CYCLES] / frames / 1e6 << "M cyc";
+        }
+        const int misses[] = {PERF_L1D_MISSES, PERF_LLC_MISSES, PERF_BRANCH_MISSES};
+        const char* labels[] = {"L1D", "LLC", "br"};
+        for (int i = 0; i < 3; ++i) {
+            if (hasEvent(misses[i])) {
+                out << " | " << labels[i] << " " << std::setprecision(1)
+                    << values.counts[misses[i]] / frames / 1e3 << "k";
+            }
+        }
+        out << "\n";
+    };
+    writePhase("matrix", counters.matrix);
+    writePhase("obstacles", counters.obstacles);
+    writePhase("particles", counters.particles);
+
+    out.flags(flags);
+    out.precision(precision);
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+// Hardware events counted per simulation phase
+enum PerfEvent {
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_L1D_MISSES,   // L1 data cache read misses
+    PERF_LLC_MISSES,   // Last level cache misses
+    PERF_BRANCH_MISSES,
+    PERF_EVENT_COUNT
+};
+
+struct PerfCounterValues {
+    uint64_t counts[PERF_EVENT_COUNT] = {};
+
+    PerfCounterValues& operator+=(const PerfCounterValues& other);
+    double ipc() const;
+};
+
+// Difference of two running totals, event by event
+PerfCounterValues operator-(const PerfCounterValues& end, const PerfCounterValues& start);
+
+// Counter deltas of one update() (or a sum over several)
+struct PhaseCounters {
+    PerfCounterValues matrix;
+    PerfCounterValues obstacles;
+    PerfCounterValues particles;
+
+    PhaseCounters& operator+=(const PhaseCounters& other);
+};
+
+// One perf_event_open group over PerfEvent, counting user-space events of the
+// thread that called open(). All events are read with a single read() on the
+// group leader, so a sample costs one syscall and never allocates.
+//
+// Events the CPU or kernel does not expose are skipped; if none opens (not
+// Linux, containers, perf_event_paranoid > 2, VMs without a PMU) open()
+// returns false and getError() says why. Multiplexed counts are scaled by
+// enabled / running time.
+class PerfCounters {
+public:
+    PerfCounters();
+    ~PerfCounters();
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool open();
+    void close();
+
+    bool isOpen() const { return leader_fd >= 0; }
+    bool hasEvent(int event) const { return slots[event] >= 0; }
+    const std::string& getError() const { return error; }
+
+    // Running totals since open(); events that are not open read as zero
+    bool read(PerfCounterValues& values) const;
+
+    // JSON-friendly name, e.g. "llc_misses"
+    static const char* getEventName(int event);
+
+    // One line per phase with IPC and per-frame misses, for the overlay and
+    // the headless log; events that are not open are left out
+    void formatPhases(std::ostream& out, const PhaseCounters& counters, double frames) const;
+
+private:
+    int leader_fd;
+    int fds[PERF_EVENT_COUNT];
+    int slots[PERF_EVENT_COUNT]; // Position in the group read, -1 if not open
+    int open_count;
+    std::string error;
+};
@@ -0,0 +1,154 @@
+#include "profiler.h"
+
+#if defined(BROWNIAN_PROFILING)
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+namespace {
+
+struct ZoneEvent {
+    const char* name;
+    uint64_t start_ns;
+    uint64_t end_ns;
+    uint32_t depth;
+};
+
+// Written only by its thread; write_index is published with release so the
+// reader sees complete records
+struct ThreadBuffer {
+    std::unique_ptr<ZoneEvent[]> events{new ZoneEvent[Profiler::EVENTS_PER_THREAD]};
+    std::atomic<uint64_t> write_index{0};
+    uint64_t summary_cursor = 0; // Reader side: first event not yet summarized
+    uint32_t depth = 0;
+    uint32_t thread_id = 0;
+    const char* name = "thread";
+};
+
+// Buffers outlive their threads so a trace can still be written at exit
+std::mutex registry_mutex;
+std::vector<std::unique_ptr<ThreadBuffer>>& registry() {
+    static std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    return buffers;
+}
+
+thread_local ThreadBuffer* current_buffer = nullptr;
+
+ThreadBuffer& threadBuffer() {
+    if (!current_buffer) {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        registry().push_back(std::make_unique<ThreadBuffer>());
+        current_buffer = registry().back().get();
+        current_buffer->thread_id = static_cast<uint32_t>(registry().size());
+    }
+    return *current_buffer;
+}
+
+// Oldest event still in the ring
+uint64_t firstRetained(uint64_t write_index) {
+    return write_index > Profiler::EVENTS_PER_THREAD ? write_index - Profiler::EVENTS_PER_THREAD : 0;
+}
+
+} // namespace
+
+uint64_t Profiler::now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Profiler::registerThread(const char* name) {
+    threadBuffer().name = name;
+}
+
+uint32_t Profiler::enterZone() {
+    return threadBuffer().depth++;
+}
+
+void Profiler::recordZone(const char* name, uint64_t start_ns, uint32_t depth) {
+    ThreadBuffer& buffer = *current_buffer; // Set up by enterZone()
+    const uint64_t index = buffer.write_index.load(std::memory_order_relaxed);
+    buffer.events[index % EVENTS_PER_THREAD] = {name, start_ns, now(), depth};
+    buffer.write_index.store(index + 1, std::memory_order_release);
+    buffer.depth = depth;
+}
+
+int Profiler::collectSummary(ZoneSummary* out, int max_zones) {
+    int count = 0;
+
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    for (auto& buffer : registry()) {
+        const uint64_t end = buffer->write_index.load(std::memory_order_acquire);
+        for (uint64_t index = std::max(buffer->summary_cursor, firstRetained(end)); index < end; ++index) {
+            const ZoneEvent& event = buffer->events[index % EVENTS_PER_THREAD];
+
+            // Zone names are string literals, so pointers identify zones
+            int slot = 0;
+            while (slot < count && out[slot].name != event.name) {
+                ++slot;
+            }
+            if (slot == count) {
+                if (count == max_zones) {
+                    continue;
+                }
+                out[count++] = {event.name, event.depth, 0, 0.0, event.start_ns};
+            }
+
+            ZoneSummary& summary = out[slot];
+            summary.depth = std::max(summary.depth, event.depth);
+            summary.first_start_ns = std::min(summary.first_start_ns, event.start_ns);
+            summary.total_ms += (event.end_ns - event.start_ns) / 1e6;
+            ++summary.calls;
+        }
+        buffer->summary_cursor = end;
+    }
+
+    std::sort(out, out + count, [](const ZoneSummary& a, const ZoneSummary& b) {
+        return a.first_start_ns < b.first_start_ns;
+    });
+    return count;
+}
+
+void Profiler::writeChromeTrace(std::ostream& out) {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+
+    uint64_t origin = UINT64_MAX;
+    for (auto& buffer : registry()) {
+        const uint64_t end = buffer->write_index.load(std::memory_order_acquire);
+        for (uint64_t index = firstRetained(end); index < end; ++index) {
+            origin = std::min(origin, buffer->events[index % EVENTS_PER_THREAD].start_ns);
+        }
+    }
+
+    const std::ios_base::fmtflags flags = out.flags();
+    const std::streamsize precision = out.precision();
+    out << std::fixed << std::setprecision(3); // Microseconds, to the nanosecond
+
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    bool first = true;
+    for (auto& buffer : registry()) {
+        out << (first ? "" : ",\n")
+            << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << buffer->thread_id
+            << ", \"args\": {\"name\": \"" << buffer->name << "\"}}";
+        first = false;
+
+        const uint64_t end = buffer->write_index.load(std::memory_order_acquire);
+        for (uint64_t index = firstRetained(end); index < end; ++index) {
+            const ZoneEvent& event = buffer->events[index % EVENTS_PER_THREAD];
+            out << ",\n{\"name\": \"" << event.name << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << buffer->thread_id
+                << ", \"ts\": " << (event.start_ns - origin) / 1000.0
+                << ", \"dur\": " << (event.end_ns - event.start_ns) / 1000.0 << "}";
+        }
+    }
+    out << "\n]}\n";
+
+    out.flags(flags);
+    out.precision(precision);
+}
+
+#endif
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+
+// Scoped-zone profiler.
+//
+//   PROFILE_ZONE("ObstacleSystem::update");  // times the enclosing scope
+//   PROFILE_THREAD("ThreadPool worker");     // optional: set up this thread's buffer now
+//
+// Each zone writes one {name, start, end, depth} record into a ring buffer
+// owned by the calling thread, so recording takes no lock and never allocates
+// after the thread's first zone. Timestamps come from steady_clock.
+//
+// Built only with -DBROWNIAN_PROFILING; otherwise the macros expand to nothing
+// and the Profiler API below turns into empty inline stubs.
+
+// Per-zone totals since the previous collectSummary() call
+struct ZoneSummary {
+    const char* name;
+    uint32_t depth;    // Deepest nesting seen; pool helpers start at 0, the caller's copy nests properly
+    uint32_t calls;
+    double total_ms;   // Summed over all threads
+    uint64_t first_start_ns;
+};
+
+#if defined(BROWNIAN_PROFILING)
+
+class Profiler {
+public:
+    static constexpr std::size_t EVENTS_PER_THREAD = 16384;
+    static constexpr int MAX_SUMMARY_ZONES = 32;
+
+    static constexpr bool isEnabled() { return true; }
+
+    static void registerThread(const char* name);
+
+    // Aggregates zones finished since the last call, ordered by first start
+    // time (parents before children). Call while no zones are being recorded,
+    // e.g. between frames. Returns the number of entries written.
+    static int collectSummary(ZoneSummary* out, int max_zones);
+
+    // Every zone still held in the ring buffers, as Chrome trace / Perfetto
+    // JSON ("X" complete events, one tid per thread)
+    static void writeChromeTrace(std::ostream& out);
+
+    static uint64_t now();
+    static void recordZone(const char* name, uint64_t start_ns, uint32_t depth);
+    static uint32_t enterZone();
+};
+
+class ProfileZone {
+public:
+    explicit ProfileZone(const char* name) : name(name), depth(Profiler::enterZone()), start(Profiler::now()) {}
+    ~ProfileZone() { Profiler::recordZone(name, start, depth); }
+
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+    const char* name;
+    uint32_t depth;
+    uint64_t start;
+};
+
+#define BROWNIAN_PROFILE_CONCAT_(a, b) a##b
+#define BROWNIAN_PROFILE_CONCAT(a, b) BROWNIAN_PROFILE_CONCAT_(a, b)
+#define PROFILE_ZONE(name) ProfileZone BROWNIAN_PROFILE_CONCAT(profile_zone_, __LINE__)(name)
+#define PROFILE_THREAD(name) Profiler::registerThread(name)
+
+#else
+
+class Profiler {
+public:
+    static constexpr bool isEnabled() { return false; }
+    static int collectSummary(ZoneSummary*, int) { return 0; }
+    static void writeChromeTrace(std::ostream&) {}
+};
+
+#define PROFILE_ZONE(name) ((void)0)
+#define PROFILE_THREAD(name) ((void)0)
+
+#endif
@@ -0,0 +1,61 @@
+#include "render_snapshot.h"
+#include "simulation.h"
+#include "profiler.h"
+
+namespace {
+
+template <typename T>
+void copyStrided(AlignedVector<T>& target, const AlignedVector<T>& source, std::size_t stride) {
+    if (stride <= 1) {
+        target.assign(source.begin(), source.end());
+        return;
+    }
+    target.resize((source.size() + stride - 1) / stride);
+    for (std::size_t i = 0, j = 0; i < source.size(); i += stride, ++j) {
+        target[j] = source[i];
+    }
+}
+
+} // namespace
+
+void RenderSnapshot::capturePrevious(const BrownianSimulation& simulation, std::size_t stride) {
+    const ParticleStore& particles = simulation.getParticles();
+    copyStrided(previous_x, particles.pos_x, stride);
+    copyStrided(previous_y, particles.pos_y, stride);
+    previous_order = simulation.getParticleOrder();
+}
+
+void RenderSnapshot::capture(const BrownianSimulation& simulation, std::size_t capture_stride) {
+    PROFILE_ZONE("RenderSnapshot::capture");
+
+    const ParticleStore& particles = simulation.getParticles();
+    stride = capture_stride > 0 ? capture_stride : 1;
+    copyStrided(pos_x, particles.pos_x, stride);
+    copyStrided(pos_y, particles.pos_y, stride);
+    copyStrided(radius, particles.radius, stride);
+    copyStrided(color, particles.color, stride);
+
+    const ObstacleSystem& obstacle_system = simulation.getObstacleSystem();
+    const std::vector<Obstacle>& obstacles = obstacle_system.getObstacles();
+    const ObstacleTransforms& transforms = obstacle_system.getTransforms();
+    obstacle_x.assign(transforms.center_x.begin(), transforms.center_x.end());
+    obstacle_y.assign(transforms.center_y.begin(), transforms.center_y.end());
+    obstacle_cos.assign(transforms.cos_rotation.begin(), transforms.cos_rotation.end());
+    obstacle_sin.assign(transforms.sin_rotation.begin(), transforms.sin_rotation.end());
+    obstacle_half_width.assign(transforms.half_width.begin(), transforms.half_width.end());
+    obstacle_half_height.assign(transforms.half_height.begin(), transforms.half_height.end());
+    obstacle_color.resize(obstacles.size());
+    for (std::size_t i = 0; i < obstacles.size(); ++i) {
+        obstacle_color[i] = obstacles[i].color;
+    }
+
+    world_width = static_cast<float>(simulation.getWidth());
+    world_height = static_cast<float>(simulation.getHeight());
+    frame_index = simulation.getFrameIndex();
+    particle_order = simulation.getParticleOrder();
+    captured_at = std::chrono::steady_clock::now();
+    has_counters = simulation.getPerfCounters().isOpen();
+    if (has_counters) {
+        counters = simulation.getLastFrameCounters();
+    }
+}
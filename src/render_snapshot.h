@@ -0,0 +1,69 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "aligned_allocator.h"
+#include "core_types.h"
+#include "perf_counters.h"
+
+class BrownianSimulation;
+
+// How the viewer draws more particles than its budget
+enum class RenderLod {
+    Off,      // Always draw every particle
+    Decimate, // Draw every Nth particle, N chosen to fit the budget
+    Density   // Draw a per-pixel density image instead of particles
+};
+
+// Everything a frame needs to be drawn, copied out of the simulation after
+// update(): particle positions, radii and colors, obstacle poses, and the
+// frame's timings and counters. The viewer draws a snapshot while the
+// simulation thread already works on the next frame (see TripleBuffer).
+// Arrays keep their capacity, so capturing the same sizes never allocates.
+//
+// previous_x / previous_y hold the positions one step earlier, so the frame
+// can be drawn at any point between the two states. A stride > 1 captures
+// every stride-th particle only (level of detail).
+struct RenderSnapshot {
+    AlignedVector<float> pos_x;
+    AlignedVector<float> pos_y;
+    AlignedVector<float> previous_x;
+    AlignedVector<float> previous_y;
+    AlignedVector<float> radius;
+    AlignedVector<Color> color;
+
+    std::vector<float> obstacle_x; // Center
+    std::vector<float> obstacle_y;
+    std::vector<float> obstacle_cos;
+    std::vector<float> obstacle_sin;
+    std::vector<float> obstacle_half_width;
+    std::vector<float> obstacle_half_height;
+    std::vector<Color> obstacle_color;
+
+    float world_width = 0.0f;
+    float world_height = 0.0f;
+    std::size_t stride = 1;
+    uint64_t frame_index = 0;
+    uint64_t particle_order = 0;  // BrownianSimulation::getParticleOrder() of pos_x / pos_y
+    uint64_t previous_order = 0;  // and of previous_x / previous_y
+    std::chrono::steady_clock::time_point captured_at;
+    PhaseCounters counters; // Valid when has_counters
+    bool has_counters = false;
+
+    // Positions before the step that capture() will follow
+    void capturePrevious(const BrownianSimulation& simulation, std::size_t stride = 1);
+    void capture(const BrownianSimulation& simulation, std::size_t stride = 1);
+
+    std::size_t getParticleCount() const { return pos_x.size(); }
+    std::size_t getObstacleCount() const { return obstacle_x.size(); }
+    // The previous positions line up with the current ones unless the
+    // particles were reordered in between (--sort-every)
+    bool hasPrevious() const { return previous_x.size() == pos_x.size() && previous_order == particle_order; }
+
+    // Smallest stride that keeps count particles within budget
+    static std::size_t decimationStride(std::size_t count, std::size_t budget) {
+        return budget == 0 || count <= budget ? 1 : (count + budget - 1) / budget;
+    }
+};
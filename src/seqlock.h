@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Lock-free single-writer / many-reader publication of a small plain value.
+// The writer bumps a sequence number around each store, so it is odd while a
+// store is in progress; a reader copies the value and retries if the number
+// was odd or changed meanwhile. The writer never waits and readers never
+// block it, unlike a mutex a slow reader could hold. The value lives in
+// atomic words, so a torn copy is discarded rather than a data race.
+template <typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock copies values bytewise");
+    static_assert(sizeof(T) % sizeof(uint64_t) == 0, "SeqLock stores whole 8-byte words");
+
+public:
+    SeqLock() : sequence(0) {
+        store(T());
+    }
+    SeqLock(const SeqLock&) = delete;
+    SeqLock& operator=(const SeqLock&) = delete;
+
+    // Writer side (one thread)
+    void store(const T& value) {
+        uint64_t source[WORDS];
+        std::memcpy(source, &value, sizeof(T));
+        const uint64_t start = sequence.load(std::memory_order_relaxed);
+        sequence.store(start + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (std::size_t i = 0; i < WORDS; ++i) {
+            words[i].store(source[i], std::memory_order_relaxed);
+        }
+        sequence.store(start + 2, std::memory_order_release);
+    }
+
+    // Reader side (any thread)
+    T load() const {
+        uint64_t copy[WORDS];
+        uint64_t before = 0;
+        uint64_t after = 0;
+        do {
+            before = sequence.load(std::memory_order_acquire);
+            for (std::size_t i = 0; i < WORDS; ++i) {
+                copy[i] = words[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = sequence.load(std::memory_order_relaxed);
+        } while ((before & 1) != 0 || before != after);
+        T value;
+        std::memcpy(&value, copy, sizeof(T));
+        return value;
+    }
+
+private:
+    static constexpr std::size_t WORDS = sizeof(T) / sizeof(uint64_t);
+
+    std::atomic<uint64_t> sequence;
+    std::atomic<uint64_t> words[WORDS];
+};
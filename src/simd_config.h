@@ -0,0 +1,23 @@
+#pragma once
+
+// SIMD headers shared by the matrix and particle kernels.
+// USE_NEON / USE_SSE describe what the compiler was allowed to emit for the
+// whole translation unit; wider x86 paths (AVX2) are compiled per function
+// with target attributes and picked at runtime.
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #include <arm_neon.h>
+    #define USE_NEON
+#elif defined(__SSE2__) || defined(__SSE3__) || defined(__SSE4_1__) || defined(__AVX__)
+    #include <immintrin.h>
+    #define USE_SSE
+#endif
+
+#if defined(USE_SSE) && (defined(__GNUC__) || defined(__clang__))
+    #define HAVE_AVX2_DISPATCH
+    #define SIMD_TARGET_AVX2 __attribute__((target("avx2,fma")))
+    // AVX2 without asking for FMA, for kernels meant to round like their scalar
+    // twins. It does not forbid FMA: with -mfma or -march=native it stays on and
+    // GCC may contract a multiply and an add, so such files also need
+    // -ffp-contract=off (the build sets it for the obstacle kernels)
+    #define SIMD_TARGET_AVX2_NO_FMA __attribute__((target("avx2")))
+#endif
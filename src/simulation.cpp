@@ -1,133 +1,606 @@
 #include "simulation.h"
 #include "matrix_operations.h"
+#include "particle_kernels.h"
+#include "thread_pool.h"
+#include "allocation_counter.h"
+#include "profiler.h"
+#include "checkpoint.h"
+#include <cassert>
+#include <chrono>
 #include <cmath>
 #include <algorithm>
 
-Particle::Particle(float x, float y, float r) 
-    : position(x, y), velocity(0, 0), radius(r) {
-    // Random color using static generator - darker colors for white background
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    static std::uniform_int_distribution<> color_dist(0, 200); // Darker colors for white background
-    
-    color = sf::Color(
-        color_dist(gen),
-        color_dist(gen), 
-        color_dist(gen),
-        220 // Semi-transparent
-    );
-}
-
-BrownianSimulation::BrownianSimulation(int width, int height, int particle_count) 
-    : rng(std::random_device{}()),
-      noise_dist(-50.0f, 50.0f),
-      color_dist(0.0f, 1.0f),
+BrownianSimulation::BrownianSimulation(int width, int height, int particle_count)
+    : BrownianSimulation(width, height, particle_count, std::random_device{}()) {
+}
+
+BrownianSimulation::BrownianSimulation(int width, int height, int particle_count, uint64_t seed, int obstacle_count)
+    : seed(seed),
+      frame_index(0),
+      counter_rng(seed),
       window_width(width), 
       window_height(height),
-      obstacle_system(width, height, 4) { // 4 obstacles by default
+      matrix_size(DEFAULT_MATRIX_SIZE),
+      lazy_matrix_product(false),
+      obstacle_system(width, height, obstacle_count, seed),
+      interactions_enabled(false),
+      sort_interval(0),
+      particle_order(0),
+      thread_pool(nullptr),
+      allocation_warmup_frames(ALLOCATION_WARMUP_FRAMES),
+      boundary_mode(BoundaryMode::Reflect),
+      noise_mode(NoiseMode::Uniform),
+      color_jitter(true),
+      particle_range(nullptr),
+      host_particles_stale(false),
+      device_particles_stale(true) {
+    
+    std::seed_seq init_sequence{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32),
+                                static_cast<uint32_t>(CounterRng::STREAM_INIT)};
+    rng.seed(init_sequence);
     
     // Initialize particles
     particles.reserve(particle_count);
     std::uniform_real_distribution<float> x_dist(10, width - 10);
     std::uniform_real_distribution<float> y_dist(10, height - 10);
+    std::uniform_real_distribution<float> radius_dist(1.5f, 3.0f);
+    std::uniform_real_distribution<float> vel_dist(-20.0f, 20.0f); // Initial velocity for more interesting motion
+    std::uniform_int_distribution<> channel_dist(0, 200); // Darker colors for white background
     
     for (int i = 0; i < particle_count; ++i) {
-        std::uniform_real_distribution<float> radius_dist(1.5f, 3.0f);
-        particles.emplace_back(x_dist(rng), y_dist(rng), radius_dist(rng));
+        float x = x_dist(rng);
+        float y = y_dist(rng);
+        float r = radius_dist(rng);
+        float vx = vel_dist(rng);
+        float vy = vel_dist(rng);
+        Color c(channel_dist(rng), channel_dist(rng), channel_dist(rng), 220); // Semi-transparent
         
-        // Give particles some initial velocity for more interesting motion
-        std::uniform_real_distribution<float> vel_dist(-20.0f, 20.0f);
-        particles.back().velocity.x = vel_dist(rng);
-        particles.back().velocity.y = vel_dist(rng);
+        particles.add(x, y, vx, vy, r, c);
     }
+    noise_x.resize(particle_count);
+    noise_y.resize(particle_count);
+    color_roll.resize(particle_count);
+    
+    initializeMatrices();
     
+    obstacle_system.setFrameArena(&frame_arena);
+    const float max_radius = particles.empty() ? 0.0f :
+        *std::max_element(particles.radius.begin(), particles.radius.end());
+    particle_interactions.configure(static_cast<float>(width), static_cast<float>(height), max_radius);
+    spatial_sort.configure(static_cast<float>(width), static_cast<float>(height));
+    selectParticleRange();
+}
+
+void BrownianSimulation::initializeMatrices() {
     // Initialize matrices for slow computations (this will hurt performance!)
-    const int matrix_size = 280; // Extreme matrix size for target ~20 FPS
-    transformation_matrix.resize(matrix_size, std::vector<float>(matrix_size));
-    position_matrix.resize(matrix_size, std::vector<float>(matrix_size));  
-    result_matrix.resize(matrix_size, std::vector<float>(matrix_size));
+    transformation_matrix.resize(matrix_size, matrix_size);
+    position_matrix.resize(matrix_size, matrix_size);
+    result_matrix.resize(matrix_size, matrix_size);
     
     MatrixOperations::createIdentityMatrix(transformation_matrix, matrix_size);
-    MatrixOperations::createRandomMatrix(position_matrix, matrix_size, matrix_size);
+    
+    // Seeded from the simulation's seed alone, so every size change rebuilds
+    // the same values and a seed fixes the whole state
+    std::seed_seq matrix_sequence{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32),
+                                  static_cast<uint32_t>(CounterRng::STREAM_MATRIX)};
+    std::mt19937 matrix_rng(matrix_sequence);
+    MatrixOperations::createRandomMatrix(position_matrix, matrix_size, matrix_size, matrix_rng);
+}
+
+void BrownianSimulation::setMatrixSize(int size) {
+    matrix_size = std::max(size, 1);
+    initializeMatrices();
+    allocation_warmup_frames = ALLOCATION_WARMUP_FRAMES;
 }
 
 void BrownianSimulation::update(float delta_time) {
-    MatrixOperations::multiplyMatrices(transformation_matrix, position_matrix, result_matrix);
+    PROFILE_ZONE("BrownianSimulation::update");
+    // Only this thread and the pool's workers run update(); other threads may
+    // allocate freely (the viewer's draw thread, other ensemble members)
+    [[maybe_unused]] auto update_allocations = [this] {
+        return thread_pool ? thread_pool->getAllocationCount() : AllocationCounter::getThreadCount();
+    };
+    [[maybe_unused]] const uint64_t allocations_before = update_allocations();
+    
+    // Last frame's temporaries are dead; size the arena for this frame's grids
+    frame_arena.reset();
+    std::size_t scratch_bytes = obstacle_system.getFrameScratchBytes();
+    if (interactions_enabled) {
+        scratch_bytes += particle_interactions.getFrameScratchBytes(particles.size());
+    }
+    if (sort_interval > 0) {
+        // By capacity: a domain tile's count changes every frame, its arrays
+        // only now and then (insertParticles() restarts the warmup then)
+        scratch_bytes += spatial_sort.getFrameScratchBytes(particles.pos_x.capacity());
+    }
+    frame_arena.reserve(scratch_bytes);
+    
+    using Clock = std::chrono::steady_clock;
+    const bool count_events = perf_counters.isOpen();
+    PerfCounterValues matrix_events, obstacles_events, particles_events, end_events;
+    if (count_events) {
+        perf_counters.read(matrix_events);
+    }
+    const auto matrix_start = Clock::now();
+    
+    {
+        PROFILE_ZONE("MatrixOperations::multiplyMatrices");
+        if (lazy_matrix_product) {
+            matrix_product.evaluate(transformation_matrix, position_matrix, thread_pool);
+        } else {
+            MatrixOperations::multiplyMatrices(transformation_matrix, position_matrix, result_matrix, thread_pool);
+        }
+    }
+    
+    const auto obstacles_start = Clock::now();
+    if (count_events) {
+        perf_counters.read(obstacles_events);
+    }
     
     // Update obstacle system
     obstacle_system.update(delta_time);
     
-    // Update each particle
-    for (auto& particle : particles) {
-        // Add random brownian motion - make it more pronounced
-        float noise_x = noise_dist(rng) * delta_time * 2.0f;
-        float noise_y = noise_dist(rng) * delta_time * 2.0f;
-        
-        particle.velocity.x += noise_x;
-        particle.velocity.y += noise_y;
-        
-        // Apply more damping to slow down particles
-        particle.velocity.x *= 0.992f; // More damping (was 0.995f)
-        particle.velocity.y *= 0.992f;
-        
-        // Update position with more visible movement (slower)
-        particle.position.x += particle.velocity.x * delta_time * 40.0f; // Reduced from 60.0f
-        particle.position.y += particle.velocity.y * delta_time * 40.0f;
-        
-        // Handle collision with obstacles (after position update)
-        obstacle_system.handleParticleCollision(particle.position, particle.velocity, particle.radius);
-        
-        // Bounce off walls (softer bouncing)
-        if (particle.position.x <= particle.radius || particle.position.x >= window_width - particle.radius) {
-            particle.velocity.x *= -0.4f; // Softer bounce (was -0.7f)
-            particle.position.x = std::max(particle.radius, 
-                                         std::min(particle.position.x, window_width - particle.radius));
+    const auto particles_start = Clock::now();
+    if (count_events) {
+        perf_counters.read(particles_events);
+    }
+    
+    // Periodic reorder, so this frame's passes walk the particles in space order
+    if (sort_interval > 0 && frame_index % sort_interval == 0) {
+        beginHostParticleChange();
+        if (spatial_sort.apply(particles, frame_arena, thread_pool)) {
+            ++particle_order;
         }
-        
-        if (particle.position.y <= particle.radius || particle.position.y >= window_height - particle.radius) {
-            particle.velocity.y *= -0.4f; // Softer bounce (was -0.7f)
-            particle.position.y = std::max(particle.radius,
-                                         std::min(particle.position.y, window_height - particle.radius));
+    }
+    
+    // Repulsion from the frame's starting positions, before anything moves
+    if (interactions_enabled) {
+        beginHostParticleChange();
+        particle_interactions.apply(particles, delta_time, frame_arena, thread_pool);
+    }
+    
+    // Add random brownian motion, apply damping and move particles
+    IntegrationStep step;
+    step.noise_scale = delta_time * MotionPolicy::NOISE_SCALE;
+    step.damping = MotionPolicy::DAMPING;
+    step.position_scale = delta_time * MotionPolicy::POSITION_SCALE;
+    
+    // Every particle only reads shared state (obstacles, RNG key), so chunks
+    // can run on any worker in any order with identical results
+    const bool on_device = compute_backend.isOpen() && !interactions_enabled && stepOnDevice(step);
+    if (!on_device) {
+        beginHostParticleChange();
+        const std::size_t count = particles.size();
+        if (thread_pool) {
+            thread_pool->parallelFor(count, PARTICLE_CHUNK_SIZE, [&](std::size_t begin, std::size_t end, int) {
+                (this->*particle_range)(step, begin, end);
+            });
+        } else {
+            (this->*particle_range)(step, 0, count);
         }
-        
-        // Slowly change color for visual interest
-        if (color_dist(rng) > 0.98f) { // Редко меняем цвет
-            std::uniform_int_distribution<> color_change(-10, 10);
-            particle.color.r = std::clamp(particle.color.r + color_change(rng), 0, 200);
-            particle.color.g = std::clamp(particle.color.g + color_change(rng), 0, 200);
-            particle.color.b = std::clamp(particle.color.b + color_change(rng), 0, 200);
+    }
+    
+    const auto frame_end = Clock::now();
+    if (count_events) {
+        perf_counters.read(end_events);
+        last_frame_counters.matrix = obstacles_events - matrix_events;
+        last_frame_counters.obstacles = particles_events - obstacles_events;
+        last_frame_counters.particles = end_events - particles_events;
+    }
+    
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+    last_frame_timings.matrix_ms = Milliseconds(obstacles_start - matrix_start).count();
+    last_frame_timings.obstacles_ms = Milliseconds(particles_start - obstacles_start).count();
+    last_frame_timings.particles_ms = Milliseconds(frame_end - particles_start).count();
+    
+    ++frame_index;
+    
+    // The OpenCL driver may allocate inside its calls, so device frames are not checked
+    if (allocation_warmup_frames > 0) {
+        --allocation_warmup_frames;
+    } else {
+        assert((on_device || update_allocations() == allocations_before) &&
+               "steady-state BrownianSimulation::update allocated on the heap");
+    }
+}
+
+template <typename Boundary, typename Noise>
+BrownianSimulation::ParticleRangeFn BrownianSimulation::particleRangeFor(bool jitter, bool obstacles) {
+    if (jitter) {
+        return obstacles ? &BrownianSimulation::updateParticleRange<Boundary, Noise, true, true>
+                         : &BrownianSimulation::updateParticleRange<Boundary, Noise, true, false>;
+    }
+    return obstacles ? &BrownianSimulation::updateParticleRange<Boundary, Noise, false, true>
+                     : &BrownianSimulation::updateParticleRange<Boundary, Noise, false, false>;
+}
+
+void BrownianSimulation::selectParticleRange() {
+    using namespace MotionPolicy;
+    const bool obstacles = obstacle_system.getObstacleCount() > 0;
+    const bool gaussian = noise_mode == NoiseMode::Gaussian;
+    switch (boundary_mode) {
+        case BoundaryMode::Periodic:
+            particle_range = gaussian ? particleRangeFor<PeriodicBoundary, GaussianNoise>(color_jitter, obstacles)
+                                      : particleRangeFor<PeriodicBoundary, UniformNoise>(color_jitter, obstacles);
+            break;
+        case BoundaryMode::Absorb:
+            particle_range = gaussian ? particleRangeFor<AbsorbBoundary, GaussianNoise>(color_jitter, obstacles)
+                                      : particleRangeFor<AbsorbBoundary, UniformNoise>(color_jitter, obstacles);
+            break;
+        case BoundaryMode::Reflect:
+        default:
+            particle_range = gaussian ? particleRangeFor<ReflectBoundary, GaussianNoise>(color_jitter, obstacles)
+                                      : particleRangeFor<ReflectBoundary, UniformNoise>(color_jitter, obstacles);
+            break;
+    }
+}
+
+template <typename Boundary, typename Noise, bool ColorJitter, bool HasObstacles>
+void BrownianSimulation::updateParticleRange(const IntegrationStep& step, std::size_t begin, std::size_t end) {
+    // Draw brownian noise for the whole range up front, in SIMD batches, so the
+    // integration kernel can consume it the same way
+    {
+        PROFILE_ZONE("ParticleKernels::generateMotionNoise");
+        Noise::generate(counter_rng, frame_index, particles.id.data(), noise_x.data(), noise_y.data(), color_roll.data(),
+                        begin, end);
+    }
+    
+    {
+        PROFILE_ZONE("ParticleKernels::integrate");
+        ParticleKernels::integrate(particles, noise_x.data(), noise_y.data(), step, begin, end);
+    }
+    
+    // Handle collision with obstacles (after position update). The step's
+    // start is recovered from the integration rule instead of being stored:
+    // position moved by exactly velocity * position_scale.
+    if constexpr (HasObstacles) {
+        PROFILE_ZONE("Particle collisions");
+        for (std::size_t i = begin; i < end; ++i) {
+            Vec2f position(particles.pos_x[i], particles.pos_y[i]);
+            Vec2f velocity(particles.vel_x[i], particles.vel_y[i]);
+            const Vec2f previous = position - velocity * step.position_scale;
+            
+            if (obstacle_system.handleParticleCollision(previous, position, velocity, particles.radius[i])) {
+                particles.pos_x[i] = position.x;
+                particles.pos_y[i] = position.y;
+                particles.vel_x[i] = velocity.x;
+                particles.vel_y[i] = velocity.y;
+            }
+        }
+    }
+    
+    {
+        PROFILE_ZONE("Particle boundaries");
+        Boundary::apply(particles, static_cast<float>(window_width), static_cast<float>(window_height), begin, end);
+    }
+    
+    // Slowly change color for visual interest; only this pass touches the color array
+    if constexpr (ColorJitter) {
+        PROFILE_ZONE("Particle colors");
+        for (std::size_t i = begin; i < end; ++i) {
+            if (color_roll[i] > MotionPolicy::COLOR_CHANGE_THRESHOLD) { // Редко меняем цвет
+                CounterRng::Block change = counter_rng.generate(particles.id[i], frame_index,
+                                                                CounterRng::STREAM_COLOR);
+                constexpr int step_max = MotionPolicy::COLOR_STEP;
+                constexpr int channel_max = MotionPolicy::COLOR_MAX;
+                Color& color = particles.color[i];
+                color.r = std::clamp(color.r + CounterRng::toInt(change[0], -step_max, step_max), 0, channel_max);
+                color.g = std::clamp(color.g + CounterRng::toInt(change[1], -step_max, step_max), 0, channel_max);
+                color.b = std::clamp(color.b + CounterRng::toInt(change[2], -step_max, step_max), 0, channel_max);
+            }
         }
     }
 }
 
-void BrownianSimulation::render(sf::RenderWindow& window) {
-    // Draw obstacles first (so they appear behind particles)
-    obstacle_system.render(window);
+bool BrownianSimulation::stepOnDevice(const IntegrationStep& step) {
+    PROFILE_ZONE("ComputeBackend::step");
     
-    // Draw particles as circles
-    sf::CircleShape circle;
+    if (device_particles_stale) {
+        if (!compute_backend.upload(particles)) {
+            compute_backend.close();
+            return false;
+        }
+        device_particles_stale = false;
+    }
     
-    for (const auto& particle : particles) {
-        circle.setRadius(particle.radius);
-        circle.setPosition(sf::Vector2f(particle.position.x - particle.radius, 
-                          particle.position.y - particle.radius));
-        circle.setFillColor(particle.color);
-        
-        window.draw(circle);
+    ComputeStep device_step;
+    device_step.integration = step;
+    device_step.frame = frame_index;
+    device_step.width = static_cast<float>(window_width);
+    device_step.height = static_cast<float>(window_height);
+    device_step.boundary = boundary_mode;
+    device_step.noise = noise_mode;
+    device_step.color_jitter = color_jitter;
+    if (!compute_backend.step(device_step, counter_rng, obstacle_system)) {
+        // Carry on from the last step the device finished
+        syncHostParticles();
+        compute_backend.close();
+        return false;
     }
+    host_particles_stale = true;
+    return true;
+}
+
+void BrownianSimulation::syncHostParticles() const {
+    if (host_particles_stale) {
+        // On failure the host keeps the last state it had
+        compute_backend.download(particles);
+        host_particles_stale = false;
+    }
+}
+
+void BrownianSimulation::beginHostParticleChange() {
+    syncHostParticles();
+    device_particles_stale = true;
+}
+
+bool BrownianSimulation::enableComputeBackend() {
+    beginHostParticleChange();
+    if (!compute_backend.open()) {
+        return false;
+    }
+    allocation_warmup_frames = ALLOCATION_WARMUP_FRAMES;
+    return true;
+}
+
+void BrownianSimulation::setParticles(const ParticleStore& replacement) {
+    beginHostParticleChange();
+    particles = replacement;
+    ++particle_order;
+    noise_x.resize(particles.size());
+    noise_y.resize(particles.size());
+    color_roll.resize(particles.size());
+    allocation_warmup_frames = ALLOCATION_WARMUP_FRAMES;
 }
 
 void BrownianSimulation::resetParticles() {
+    beginHostParticleChange();
     std::uniform_real_distribution<float> x_dist(10, window_width - 10);
     std::uniform_real_distribution<float> y_dist(10, window_height - 10);
     
-    for (auto& particle : particles) {
-        particle.position.x = x_dist(rng);
-        particle.position.y = y_dist(rng);
-        particle.velocity.x = 0;
-        particle.velocity.y = 0;
+    for (std::size_t i = 0; i < particles.size(); ++i) {
+        particles.pos_x[i] = x_dist(rng);
+        particles.pos_y[i] = y_dist(rng);
     }
+    std::fill(particles.vel_x.begin(), particles.vel_x.end(), 0.0f);
+    std::fill(particles.vel_y.begin(), particles.vel_y.end(), 0.0f);
     
     // Also reset obstacles
     obstacle_system.resetObstacles();
-} 
\ No newline at end of file
+    allocation_warmup_frames = ALLOCATION_WARMUP_FRAMES;
+}
+
+void BrownianSimulation::extractParticlesOutside(float min_x, float min_y, float max_x, float max_y,
+                                                 ParticleStore& leaving) {
+    beginHostParticleChange();
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < particles.size(); ++i) {
+        const float x = particles.pos_x[i];
+        const float y = particles.pos_y[i];
+        if (x >= min_x && x < max_x && y >= min_y && y < max_y) {
+            if (kept != i) {
+                particles.pos_x[kept] = x;
+                particles.pos_y[kept] = y;
+                particles.vel_x[kept] = particles.vel_x[i];
+                particles.vel_y[kept] = particles.vel_y[i];
+                particles.radius[kept] = particles.radius[i];
+                particles.color[kept] = particles.color[i];
+                particles.id[kept] = particles.id[i];
+            }
+            ++kept;
+        } else {
+            leaving.append(particles, i);
+        }
+    }
+    if (kept != particles.size()) {
+        ++particle_order;
+    }
+    particles.resize(kept);
+}
+
+void BrownianSimulation::insertParticles(const ParticleStore& arriving) {
+    beginHostParticleChange();
+    const std::size_t capacity = particles.pos_x.capacity();
+    for (std::size_t i = 0; i < arriving.size(); ++i) {
+        particles.append(arriving, i);
+    }
+    if (sort_interval > 0 && particles.pos_x.capacity() != capacity) {
+        allocation_warmup_frames = ALLOCATION_WARMUP_FRAMES; // The frame arena grows with the arrays
+    }
+    noise_x.resize(particles.size());
+    noise_y.resize(particles.size());
+    color_roll.resize(particles.size());
+}
+
+namespace {
+
+constexpr uint32_t SIMULATION_SECTION = CheckpointFormat::sectionTag('S', 'I', 'M', 'U');
+constexpr uint32_t MOTION_SECTION = CheckpointFormat::sectionTag('M', 'O', 'T', 'N');
+constexpr uint32_t ORDER_SECTION = CheckpointFormat::sectionTag('O', 'R', 'D', 'R');
+constexpr uint32_t PARTICLES_SECTION = CheckpointFormat::sectionTag('P', 'R', 'T', 'C');
+constexpr uint32_t MATRICES_SECTION = CheckpointFormat::sectionTag('M', 'A', 'T', 'X');
+constexpr uint64_t MAX_CHECKPOINT_PARTICLES = 100000000;
+
+void writeMatrix(CheckpointWriter& writer, const Matrix& matrix) {
+    writer.write<int32_t>(matrix.getRows());
+    writer.write<int32_t>(matrix.getCols());
+    writer.write<uint32_t>(static_cast<uint32_t>(matrix.getStructure()));
+    for (int i = 0; i < matrix.getRows(); ++i) {
+        writer.writeArray(matrix.row(i), matrix.getCols());
+    }
+}
+
+bool readMatrix(CheckpointReader& reader, Matrix& matrix) {
+    int32_t rows = 0, cols = 0;
+    uint32_t structure = 0;
+    if (!reader.read(rows) || !reader.read(cols) || !reader.read(structure)) {
+        return false;
+    }
+    if (rows < 0 || cols < 0 || rows > 4096 || cols > 4096 ||
+        structure > static_cast<uint32_t>(MatrixStructure::Diagonal)) {
+        return reader.fail("checkpoint matrix header is invalid");
+    }
+    
+    matrix.resize(rows, cols);
+    for (int i = 0; i < rows; ++i) {
+        if (!reader.readArray(matrix.row(i), cols)) {
+            return false;
+        }
+    }
+    matrix.setStructure(static_cast<MatrixStructure>(structure));
+    return true;
+}
+
+} // namespace
+
+bool BrownianSimulation::saveCheckpoint(const std::string& path, std::string& error) const {
+    syncHostParticles();
+    CheckpointWriter writer;
+    
+    writer.beginSection(SIMULATION_SECTION);
+    writer.write<int32_t>(window_width);
+    writer.write<int32_t>(window_height);
+    writer.write(seed);
+    writer.write(frame_index);
+    writer.write<int32_t>(matrix_size);
+    writer.write<uint8_t>(lazy_matrix_product);
+    writer.write<uint8_t>(interactions_enabled);
+    writer.write(particle_interactions.getStiffness());
+    writer.writeRng(rng);
+    
+    writer.beginSection(MOTION_SECTION);
+    writer.write(static_cast<uint8_t>(boundary_mode));
+    writer.write(static_cast<uint8_t>(noise_mode));
+    writer.write<uint8_t>(color_jitter);
+    
+    // The particles are saved in their current order, so only the interval is needed
+    writer.beginSection(ORDER_SECTION);
+    writer.write<int32_t>(sort_interval);
+    
+    writer.beginSection(PARTICLES_SECTION);
+    writer.writeVector(particles.pos_x);
+    writer.writeVector(particles.pos_y);
+    writer.writeVector(particles.vel_x);
+    writer.writeVector(particles.vel_y);
+    writer.writeVector(particles.radius);
+    writer.writeVector(particles.color);
+    writer.writeVector(particles.id);
+    
+    // The operands are random at construction, so they are saved rather than
+    // rebuilt; the product is recomputed on the next frame
+    writer.beginSection(MATRICES_SECTION);
+    writeMatrix(writer, transformation_matrix);
+    writeMatrix(writer, position_matrix);
+    
+    obstacle_system.saveCheckpoint(writer);
+    return writer.writeFile(path, error);
+}
+
+bool BrownianSimulation::loadCheckpoint(const std::string& path, std::string& error) {
+    CheckpointReader reader;
+    if (!reader.open(path)) {
+        error = reader.getError();
+        return false;
+    }
+    
+    // Everything is read into locals first and only swapped in once the whole
+    // file parsed, so a bad checkpoint leaves this simulation as it was
+    int32_t width = 0, height = 0, size = 0;
+    uint64_t loaded_seed = 0, loaded_frame = 0;
+    uint8_t lazy = 0, interactions = 0;
+    float stiffness = 0.0f;
+    std::mt19937 loaded_rng;
+    reader.expectSection(SIMULATION_SECTION, "simulation");
+    reader.read(width);
+    reader.read(height);
+    reader.read(loaded_seed);
+    reader.read(loaded_frame);
+    reader.read(size);
+    reader.read(lazy);
+    reader.read(interactions);
+    reader.read(stiffness);
+    reader.readRng(loaded_rng);
+    if (reader.ok() && (width != window_width || height != window_height)) {
+        reader.fail("checkpoint is for a " + std::to_string(width) + "x" + std::to_string(height) + " world, not " +
+                    std::to_string(window_width) + "x" + std::to_string(window_height));
+    }
+    
+    uint8_t boundary = 0, noise = 0, jitter = 0;
+    reader.expectSection(MOTION_SECTION, "motion");
+    reader.read(boundary);
+    reader.read(noise);
+    reader.read(jitter);
+    if (reader.ok() && (boundary > static_cast<uint8_t>(BoundaryMode::Absorb) ||
+                        noise > static_cast<uint8_t>(NoiseMode::Gaussian))) {
+        reader.fail("checkpoint motion settings are invalid");
+    }
+    
+    int32_t loaded_sort_interval = 0;
+    reader.expectSection(ORDER_SECTION, "particle order");
+    reader.read(loaded_sort_interval);
+    if (reader.ok() && loaded_sort_interval < 0) {
+        reader.fail("checkpoint sort interval is invalid");
+    }
+    
+    ParticleStore loaded;
+    reader.expectSection(PARTICLES_SECTION, "particles");
+    reader.readVector(loaded.pos_x, MAX_CHECKPOINT_PARTICLES);
+    const std::size_t count = loaded.pos_x.size();
+    loaded.resize(count);
+    reader.readArray(loaded.pos_y.data(), count);
+    reader.readArray(loaded.vel_x.data(), count);
+    reader.readArray(loaded.vel_y.data(), count);
+    reader.readArray(loaded.radius.data(), count);
+    reader.readArray(loaded.color.data(), count);
+    reader.readArray(loaded.id.data(), count);
+    
+    Matrix transformation, position;
+    reader.expectSection(MATRICES_SECTION, "matrices");
+    readMatrix(reader, transformation);
+    readMatrix(reader, position);
+    if (reader.ok() && (size < 1 || transformation.getRows() != size || position.getRows() != size)) {
+        reader.fail("checkpoint matrices do not match its matrix size");
+    }
+    
+    // Obstacles go last: they only change once their own section parsed
+    if (!reader.ok() || !obstacle_system.loadCheckpoint(reader)) {
+        error = reader.getError();
+        return false;
+    }
+    
+    seed = loaded_seed;
+    frame_index = loaded_frame;
+    counter_rng = CounterRng(seed);
+    rng = loaded_rng;
+    
+    // The loaded particles replace whatever the device held
+    particles = std::move(loaded);
+    ++particle_order;
+    host_particles_stale = false;
+    device_particles_stale = true;
+    noise_x.resize(count);
+    noise_y.resize(count);
+    color_roll.resize(count);
+    
+    matrix_size = size;
+    transformation_matrix = std::move(transformation);
+    position_matrix = std::move(position);
+    result_matrix.resize(matrix_size, matrix_size);
+    matrix_product.invalidate();
+    lazy_matrix_product = lazy != 0;
+    
+    interactions_enabled = interactions != 0;
+    particle_interactions.setStiffness(stiffness);
+    const float max_radius = particles.empty() ? 0.0f :
+        *std::max_element(particles.radius.begin(), particles.radius.end());
+    particle_interactions.configure(static_cast<float>(window_width), static_cast<float>(window_height), max_radius);
+    
+    boundary_mode = static_cast<BoundaryMode>(boundary);
+    noise_mode = static_cast<NoiseMode>(noise);
+    color_jitter = jitter != 0;
+    selectParticleRange();
+    sort_interval = loaded_sort_interval;
+    
+    allocation_warmup_frames = ALLOCATION_WARMUP_FRAMES;
+    return true;
+}
@@ -1,43 +1,202 @@
 #pragma once
 
 #include <vector>
+#include <algorithm>
 #include <random>
-#include <SFML/Graphics.hpp>
+#include <cstdint>
+#include <string>
 #include "obstacle_system.h"
+#include "particle_store.h"
+#include "counter_rng.h"
+#include "particle_kernels.h"
+#include "matrix.h"
+#include "matrix_product.h"
+#include "frame_arena.h"
+#include "perf_counters.h"
+#include "particle_interactions.h"
+#include "spatial_sort.h"
+#include "motion_policies.h"
+#include "compute_backend.h"
 
-struct Particle {
-    sf::Vector2f position;
-    sf::Vector2f velocity;
-    sf::Color color;
-    float radius;
+class ThreadPool;
+
+// Wall time of each update() phase, in milliseconds
+struct FrameTimings {
+    double matrix_ms = 0.0;
+    double obstacles_ms = 0.0;
+    double particles_ms = 0.0;
     
-    Particle(float x, float y, float r = 2.0f);
+    double total() const { return matrix_ms + obstacles_ms + particles_ms; }
 };
 
 class BrownianSimulation {
 private:
-    std::vector<Particle> particles;
+    // mutable: with a compute backend the device holds the current state, and
+    // const readers refresh this copy on demand (see syncHostParticles())
+    mutable ParticleStore particles;
+    AlignedVector<float> noise_x; // Per-frame noise samples consumed by the integration kernel
+    AlignedVector<float> noise_y;
+    AlignedVector<float> color_roll; // Per-frame [0, 1) roll deciding which colors change
+    
+    // Per-frame randomness is keyed by (seed, particle id, frame), so it does
+    // not depend on update order; rng only serves initialization and resets
+    uint64_t seed;
+    uint64_t frame_index;
+    CounterRng counter_rng;
     std::mt19937 rng;
-    std::uniform_real_distribution<float> noise_dist;
-    std::uniform_real_distribution<float> color_dist;
     
     int window_width;
     int window_height;
     
     // For demonstration: we'll do some matrix operations each frame
-    std::vector<std::vector<float>> transformation_matrix;
-    std::vector<std::vector<float>> position_matrix;
-    std::vector<std::vector<float>> result_matrix;
+    Matrix transformation_matrix;
+    Matrix position_matrix;
+    Matrix result_matrix;
+    int matrix_size;
+    // Opt-in memoized product: the operands never change after setup, so it
+    // multiplies once instead of every frame (off by default for the demo load)
+    MatrixProduct matrix_product;
+    bool lazy_matrix_product;
+    static constexpr int DEFAULT_MATRIX_SIZE = 280; // Extreme matrix size for target ~20 FPS
+    void initializeMatrices();
     
     // Obstacle system for particle interactions
     ObstacleSystem obstacle_system;
     
+    // Optional particle-particle repulsion, applied to the velocities before
+    // the particle pass (off by default)
+    ParticleInteractions particle_interactions;
+    bool interactions_enabled;
+    
+    // Optional Morton reordering of the particle arrays every sort_interval
+    // frames (0 = never). particle_order changes whenever particles change
+    // places, so copies taken by index (render snapshots) can tell they no
+    // longer line up.
+    SpatialSort spatial_sort;
+    int sort_interval;
+    uint64_t particle_order;
+    
+    // Optional worker pool for the particle passes (not owned)
+    ThreadPool* thread_pool;
+    
+    // Frame-lifetime temporaries (obstacle grid lists); reset at the start of
+    // every update(). Matrix scratch uses the per-thread arenas instead.
+    FrameArena frame_arena;
+    
+    // Debug builds assert that update() makes no heap allocation once this many
+    // frames have passed since setup or the last reconfiguration
+    static constexpr int ALLOCATION_WARMUP_FRAMES = 3;
+    int allocation_warmup_frames;
+    
+    FrameTimings last_frame_timings;
+    
+    // Optional hardware counters, read around each phase; they count the
+    // thread that calls update(), not the pool workers
+    PerfCounters perf_counters;
+    PhaseCounters last_frame_counters;
+    
+    // Particles per parallel work item; a multiple of ThreadPool::CHUNK_ALIGNMENT
+    static constexpr std::size_t PARTICLE_CHUNK_SIZE = 1024;
+    
+    // The particle pass is compiled once per combination of motion policies
+    // (see motion_policies.h); selectParticleRange() points particle_range at
+    // the one matching the current settings whenever they change
+    BoundaryMode boundary_mode;
+    NoiseMode noise_mode;
+    bool color_jitter;
+    using ParticleRangeFn = void (BrownianSimulation::*)(const IntegrationStep&, std::size_t, std::size_t);
+    ParticleRangeFn particle_range;
+    void selectParticleRange();
+    template <typename Boundary, typename Noise>
+    static ParticleRangeFn particleRangeFor(bool jitter, bool obstacles);
+    
+    // Noise, integration, collisions, walls and colors for particles [begin, end)
+    template <typename Boundary, typename Noise, bool ColorJitter, bool HasObstacles>
+    void updateParticleRange(const IntegrationStep& step, std::size_t begin, std::size_t end);
+    
+    // Optional device copy of the particle pass (off unless enabled). Only
+    // one side is current at a time: after a device step the host arrays are
+    // stale until read, after a host change the device is until the next step.
+    ComputeBackend compute_backend;
+    mutable bool host_particles_stale;
+    bool device_particles_stale;
+    bool stepOnDevice(const IntegrationStep& step);
+    void syncHostParticles() const;
+    // Before a host-side change of the particles: pull them back and mark the device copy stale
+    void beginHostParticleChange();
+    
 public:
     BrownianSimulation(int width, int height, int particle_count = 1000);
+    BrownianSimulation(int width, int height, int particle_count, uint64_t seed,
+                       int obstacle_count = DEFAULT_OBSTACLE_COUNT);
+    
+    static constexpr int DEFAULT_OBSTACLE_COUNT = 4;
     
     void update(float delta_time);
-    void render(sf::RenderWindow& window);
     
     void resetParticles();
+    
+    // Domain tiles (see domain_decomposition.h): move every particle whose
+    // center is outside [min_x, max_x) x [min_y, max_y) to the end of leaving,
+    // keeping the rest in order; insertParticles appends, ids included
+    void extractParticlesOutside(float min_x, float min_y, float max_x, float max_y, ParticleStore& leaving);
+    void insertParticles(const ParticleStore& arriving);
+    void setThreadPool(ThreadPool* pool) { thread_pool = pool; allocation_warmup_frames = ALLOCATION_WARMUP_FRAMES; }
+    // Edge of the square matrices multiplied every frame (280 by default)
+    void setMatrixSize(int size);
+    int getMatrixSize() const { return matrix_size; }
+    void setLazyMatrixProduct(bool enabled) { lazy_matrix_product = enabled; allocation_warmup_frames = ALLOCATION_WARMUP_FRAMES; }
+    const Matrix& getMatrixResult() const { return lazy_matrix_product ? matrix_product.getResult() : result_matrix; }
     int getParticleCount() const { return particles.size(); }
+    // Downloads them first when a compute backend step left the host copy stale
+    const ParticleStore& getParticles() const { syncHostParticles(); return particles; }
+    // Replace every particle (ids included), e.g. to resync a cross-check run
+    void setParticles(const ParticleStore& replacement);
+    uint64_t getSeed() const { return seed; }
+    uint64_t getFrameIndex() const { return frame_index; }
+    int getObstacleCount() const { return obstacle_system.getObstacleCount(); }
+    const ObstacleSystem& getObstacleSystem() const { return obstacle_system; }
+    int getWidth() const { return window_width; }
+    int getHeight() const { return window_height; }
+    bool isMatrixProductLazy() const { return lazy_matrix_product; }
+    void setParticleInteractions(bool enabled) { interactions_enabled = enabled; allocation_warmup_frames = ALLOCATION_WARMUP_FRAMES; }
+    bool areParticleInteractionsEnabled() const { return interactions_enabled; }
+    // Sort the particles along the Morton curve on every frame index divisible
+    // by frames (0 = keep the creation order); see spatial_sort.h
+    void setSortInterval(int frames) { sort_interval = std::max(frames, 0); allocation_warmup_frames = ALLOCATION_WARMUP_FRAMES; }
+    int getSortInterval() const { return sort_interval; }
+    uint64_t getParticleOrder() const { return particle_order; }
+    ParticleInteractions& getParticleInteractions() { return particle_interactions; }
+    // Wall handling (reflect by default), kick distribution (uniform by
+    // default) and the slow color drift (on by default)
+    void setBoundaryMode(BoundaryMode mode) { boundary_mode = mode; selectParticleRange(); }
+    BoundaryMode getBoundaryMode() const { return boundary_mode; }
+    void setNoiseMode(NoiseMode mode) { noise_mode = mode; selectParticleRange(); }
+    NoiseMode getNoiseMode() const { return noise_mode; }
+    void setColorJitter(bool enabled) { color_jitter = enabled; selectParticleRange(); }
+    bool isColorJitterEnabled() const { return color_jitter; }
+    const FrameTimings& getLastFrameTimings() const { return last_frame_timings; }
+    
+    // Full state between frames (particles, obstacles, RNGs, frame index,
+    // matrices and the matrix / interaction / motion / sort settings) as a versioned
+    // binary file; see checkpoint.h. Loading maps the file and needs the same
+    // world size. A restored run continues bit-identically to an uninterrupted one.
+    // On failure error says why and the simulation is unchanged.
+    bool saveCheckpoint(const std::string& path, std::string& error) const;
+    bool loadCheckpoint(const std::string& path, std::string& error);
+    
+    // Open the counter group on the calling thread, which must be the one that
+    // calls update(); false if perf_event is unavailable (see getPerfCounters())
+    bool enablePerfCounters() { return perf_counters.open(); }
+    const PerfCounters& getPerfCounters() const { return perf_counters; }
+    const PhaseCounters& getLastFrameCounters() const { return last_frame_counters; }
+    
+    // Run the particle pass on the OpenCL device from now on (see
+    // compute_backend.h); false if there is none, with the reason in
+    // getComputeBackend().getError(). Frames with interactions enabled still
+    // run on the CPU. A failing device step closes the backend and the run
+    // continues on the CPU.
+    bool enableComputeBackend();
+    const ComputeBackend& getComputeBackend() const { return compute_backend; }
+    bool isComputeBackendEnabled() const { return compute_backend.isOpen(); }
 }; 
\ No newline at end of file
@@ -0,0 +1,165 @@
+#include "spatial_sort.h"
+#include "frame_arena.h"
+#include "thread_pool.h"
+#include "profiler.h"
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+// fn(chunk, begin, end) for every chunk of [0, count), on the pool when there is one
+template <typename Fn>
+void forEachChunk(ThreadPool* pool, std::size_t count, std::size_t chunk_size, Fn&& fn) {
+    if (pool) {
+        pool->parallelFor(count, chunk_size, [&](std::size_t begin, std::size_t end, int) {
+            fn(begin / chunk_size, begin, end);
+        });
+    } else {
+        for (std::size_t begin = 0; begin < count; begin += chunk_size) {
+            fn(begin / chunk_size, begin, std::min(begin + chunk_size, count));
+        }
+    }
+}
+
+// values[i] = values[order[i]] for every i, through scratch (count elements)
+template <typename T>
+void permute(AlignedVector<T>& values, const uint32_t* order, void* scratch, std::size_t chunk_size, ThreadPool* pool) {
+    static_assert(sizeof(T) <= sizeof(uint32_t), "scratch holds 4-byte elements");
+    T* sorted = static_cast<T*>(scratch);
+    T* data = values.data();
+    forEachChunk(pool, values.size(), chunk_size, [&](std::size_t, std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            sorted[i] = data[order[i]];
+        }
+    });
+    forEachChunk(pool, values.size(), chunk_size, [&](std::size_t, std::size_t begin, std::size_t end) {
+        std::copy(sorted + begin, sorted + end, data + begin);
+    });
+}
+
+// Spread the low 16 bits of v over the even bits
+uint32_t spreadBits(uint32_t v) {
+    v &= 0x0000FFFFu;
+    v = (v | (v << 8)) & 0x00FF00FFu;
+    v = (v | (v << 4)) & 0x0F0F0F0Fu;
+    v = (v | (v << 2)) & 0x33333333u;
+    v = (v | (v << 1)) & 0x55555555u;
+    return v;
+}
+
+} // namespace
+
+SpatialSort::SpatialSort() : cells_per_unit(1.0f) {
+}
+
+void SpatialSort::configure(float world_width, float world_height) {
+    // Square cells: the longer side spans the whole grid
+    cells_per_unit = static_cast<float>(1u << AXIS_BITS) / std::max({world_width, world_height, 1.0f});
+}
+
+uint32_t SpatialSort::mortonKey(uint32_t x, uint32_t y) {
+    return spreadBits(x) | (spreadBits(y) << 1);
+}
+
+uint32_t SpatialSort::keyOf(float x, float y) const {
+    const float last_cell = static_cast<float>((1u << AXIS_BITS) - 1);
+    const float cell_x = std::clamp(x * cells_per_unit, 0.0f, last_cell);
+    const float cell_y = std::clamp(y * cells_per_unit, 0.0f, last_cell);
+    return mortonKey(static_cast<uint32_t>(cell_x), static_cast<uint32_t>(cell_y));
+}
+
+std::size_t SpatialSort::getFrameScratchBytes(std::size_t particle_count) const {
+    const std::size_t chunks = (particle_count + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    // Two key and two order buffers (one key buffer doubles as the permutation
+    // scratch), the per-chunk histograms and sorted flags, each rounded up to
+    // the arena alignment
+    return 4 * particle_count * sizeof(uint32_t) + chunks * BUCKETS * sizeof(uint32_t) + chunks +
+           6 * FrameArena::ALIGNMENT;
+}
+
+bool SpatialSort::apply(ParticleStore& particles, FrameArena& arena, ThreadPool* pool) {
+    PROFILE_ZONE("SpatialSort::apply");
+
+    const std::size_t count = particles.size();
+    if (count < 2) {
+        return false;
+    }
+    const std::size_t chunk_count = (count + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    uint32_t* keys = arena.allocateArray<uint32_t>(count);
+    uint32_t* order = arena.allocateArray<uint32_t>(count);
+    uint32_t* histograms = arena.allocateArray<uint32_t>(chunk_count * BUCKETS);
+    uint8_t* chunk_sorted = arena.allocateArray<uint8_t>(chunk_count);
+
+    forEachChunk(pool, count, CHUNK_SIZE, [&](std::size_t, std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            keys[i] = keyOf(particles.pos_x[i], particles.pos_y[i]);
+            order[i] = static_cast<uint32_t>(i);
+        }
+    });
+
+    // Re-sorting a few frames after the last sort mostly finds the order
+    // intact; a chunk also checks the step from the previous chunk's last key
+    forEachChunk(pool, count, CHUNK_SIZE, [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+        bool sorted = true;
+        for (std::size_t i = std::max<std::size_t>(begin, 1); i < end && sorted; ++i) {
+            sorted = keys[i - 1] <= keys[i];
+        }
+        chunk_sorted[chunk] = sorted;
+    });
+    if (std::all_of(chunk_sorted, chunk_sorted + chunk_count, [](uint8_t sorted) { return sorted != 0; })) {
+        return false;
+    }
+
+    uint32_t* keys_out = arena.allocateArray<uint32_t>(count);
+    uint32_t* order_out = arena.allocateArray<uint32_t>(count);
+    for (int shift = 0; shift < 2 * AXIS_BITS; shift += RADIX_BITS) {
+        forEachChunk(pool, count, CHUNK_SIZE, [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+            uint32_t* histogram = histograms + chunk * BUCKETS;
+            std::fill(histogram, histogram + BUCKETS, 0u);
+            for (std::size_t i = begin; i < end; ++i) {
+                ++histogram[(keys[i] >> shift) & (BUCKETS - 1)];
+            }
+        });
+
+        // Exclusive offsets, digit by digit and within a digit chunk by chunk,
+        // which keeps equal digits in their previous order. A digit that every
+        // particle shares would move nothing.
+        uint32_t offset = 0;
+        bool single_digit = false;
+        for (uint32_t digit = 0; digit < BUCKETS; ++digit) {
+            const uint32_t digit_start = offset;
+            for (std::size_t chunk = 0; chunk < chunk_count; ++chunk) {
+                uint32_t& slot = histograms[chunk * BUCKETS + digit];
+                const uint32_t chunk_total = slot;
+                slot = offset;
+                offset += chunk_total;
+            }
+            single_digit = single_digit || offset - digit_start == count;
+        }
+        if (single_digit) {
+            continue;
+        }
+
+        forEachChunk(pool, count, CHUNK_SIZE, [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+            uint32_t* next = histograms + chunk * BUCKETS;
+            for (std::size_t i = begin; i < end; ++i) {
+                const uint32_t slot = next[(keys[i] >> shift) & (BUCKETS - 1)]++;
+                keys_out[slot] = keys[i];
+                order_out[slot] = order[i];
+            }
+        });
+        std::swap(keys, keys_out);
+        std::swap(order, order_out);
+    }
+
+    // Every array follows the same permutation; keys_out is free scratch now
+    void* scratch = keys_out;
+    permute(particles.pos_x, order, scratch, CHUNK_SIZE, pool);
+    permute(particles.pos_y, order, scratch, CHUNK_SIZE, pool);
+    permute(particles.vel_x, order, scratch, CHUNK_SIZE, pool);
+    permute(particles.vel_y, order, scratch, CHUNK_SIZE, pool);
+    permute(particles.radius, order, scratch, CHUNK_SIZE, pool);
+    permute(particles.color, order, scratch, CHUNK_SIZE, pool);
+    permute(particles.id, order, scratch, CHUNK_SIZE, pool);
+    return true;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "particle_store.h"
+
+class FrameArena;
+class ThreadPool;
+
+// Reorders a ParticleStore along a Morton (Z-order) curve through the
+// particle centers, so particles close in space are close in memory: the
+// obstacle tests, the interaction cell list and the snapshot copies then walk
+// memory mostly in order instead of in the creation order's scatter.
+//
+// Centers are quantized to a square grid of 2^AXIS_BITS cells per axis over
+// the world, and the interleaved keys are sorted with an LSD radix sort:
+// chunks of particles count their digits and scatter in parallel, and the
+// sort is stable, so the result does not depend on the thread count.
+//
+// Particles keep their ids, which key their random streams, so a reordered
+// run follows the same trajectories; only sums over neighbors (particle
+// interactions) see the new order.
+class SpatialSort {
+public:
+    static constexpr int AXIS_BITS = 11;  // 2048 x 2048 cells
+    static constexpr int RADIX_BITS = 11; // Two passes over the 22-bit keys
+
+    SpatialSort();
+
+    // World the particles live in; sets the cell size
+    void configure(float world_width, float world_height);
+
+    // Low AXIS_BITS of x in the even bits, of y in the odd ones
+    static uint32_t mortonKey(uint32_t x, uint32_t y);
+    // Key of the cell holding (x, y); points outside the world use the border cells
+    uint32_t keyOf(float x, float y) const;
+
+    // Arena bytes one apply() takes for this many particles
+    std::size_t getFrameScratchBytes(std::size_t particle_count) const;
+
+    // Sort every particle array by key. Scratch comes from arena, which must
+    // stay alive until apply() returns; pool may be nullptr. Returns false,
+    // with nothing moved, when the particles were in key order already.
+    bool apply(ParticleStore& particles, FrameArena& arena, ThreadPool* pool);
+
+private:
+    static constexpr std::size_t CHUNK_SIZE = 16384; // A multiple of ThreadPool::CHUNK_ALIGNMENT
+    static constexpr uint32_t BUCKETS = 1u << RADIX_BITS;
+
+    float cells_per_unit;
+};
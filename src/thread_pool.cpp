@@ -0,0 +1,138 @@
+#include "thread_pool.h"
+#include "allocation_counter.h"
+#include "profiler.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(int thread_count)
+    : thread_count(thread_count > 0 ? thread_count
+                                    : std::max(1, static_cast<int>(std::thread::hardware_concurrency()))),
+      queues(new WorkerQueue[this->thread_count]),
+      worker_arenas(new FrameArena[this->thread_count]),
+      worker_allocations(new std::atomic<const std::atomic<uint64_t>*>[this->thread_count]()) {
+    threads.reserve(this->thread_count - 1);
+    for (int worker = 1; worker < this->thread_count; ++worker) {
+        threads.emplace_back(&ThreadPool::workerLoop, this, worker);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake_condition.notify_all();
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+std::size_t ThreadPool::alignChunkSize(std::size_t chunk_size) {
+    chunk_size = std::max<std::size_t>(chunk_size, 1);
+    return (chunk_size + CHUNK_ALIGNMENT - 1) / CHUNK_ALIGNMENT * CHUNK_ALIGNMENT;
+}
+
+void ThreadPool::reserveScratch(std::size_t bytes) {
+    FrameArena::forThread().reserve(bytes);
+    for (int worker = 1; worker < thread_count; ++worker) {
+        worker_arenas[worker].reserve(bytes);
+    }
+}
+
+uint64_t ThreadPool::getAllocationCount() const {
+    uint64_t count = AllocationCounter::getThreadCount();
+    for (int worker = 1; worker < thread_count; ++worker) {
+        if (const std::atomic<uint64_t>* counter = worker_allocations[worker].load(std::memory_order_acquire)) {
+            count += counter->load(std::memory_order_relaxed);
+        }
+    }
+    return count;
+}
+
+void ThreadPool::run(std::size_t count, std::size_t chunk_size, ChunkFn fn, void* context) {
+    if (count == 0) {
+        return;
+    }
+
+    const std::size_t chunk_count = (count + chunk_size - 1) / chunk_size;
+
+    // Nothing to share: run inline without waking anyone
+    if (thread_count == 1 || chunk_count == 1) {
+        for (std::size_t begin = 0; begin < count; begin += chunk_size) {
+            fn(context, begin, std::min(begin + chunk_size, count), 0);
+        }
+        return;
+    }
+
+    // Deal out contiguous runs of chunks, one per worker
+    for (int worker = 0; worker < thread_count; ++worker) {
+        queues[worker].next.store(chunk_count * worker / thread_count, std::memory_order_relaxed);
+        queues[worker].end = chunk_count * (worker + 1) / thread_count;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job_fn = fn;
+        job_context = context;
+        job_count = count;
+        job_chunk_size = chunk_size;
+        busy_workers = thread_count - 1;
+        ++generation;
+    }
+    wake_condition.notify_all();
+
+    processChunks(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done_condition.wait(lock, [this] { return busy_workers == 0; });
+}
+
+void ThreadPool::workerLoop(int worker) {
+    uint64_t seen_generation = 0;
+    worker_allocations[worker].store(AllocationCounter::getThreadCounter(), std::memory_order_release);
+    FrameArena::bindThread(&worker_arenas[worker]);
+    PROFILE_THREAD("ThreadPool worker");
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake_condition.wait(lock, [&] { return stopping || generation != seen_generation; });
+            if (stopping) {
+                return;
+            }
+            seen_generation = generation;
+        }
+
+        processChunks(worker);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            --busy_workers;
+        }
+        done_condition.notify_one();
+    }
+}
+
+void ThreadPool::processChunks(int worker) {
+    std::size_t chunk;
+
+    // Own run first, then steal from the others starting with the neighbour
+    for (int offset = 0; offset < thread_count; ++offset) {
+        const int queue = (worker + offset) % thread_count;
+        while (claimChunk(queue, chunk)) {
+            const std::size_t begin = chunk * job_chunk_size;
+            const std::size_t end = std::min(begin + job_chunk_size, job_count);
+            job_fn(job_context, begin, end, worker);
+        }
+    }
+}
+
+bool ThreadPool::claimChunk(int queue, std::size_t& chunk) {
+    WorkerQueue& source = queues[queue];
+    if (source.next.load(std::memory_order_relaxed) >= source.end) {
+        return false;
+    }
+
+    chunk = source.next.fetch_add(1, std::memory_order_relaxed);
+    return chunk < source.end;
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "frame_arena.h"
+
+// Persistent worker pool for data-parallel loops.
+// The calling thread takes part as worker 0, so a pool of N threads starts N - 1
+// helpers once and keeps them parked between frames. Chunks are dealt out in
+// contiguous runs per worker; a worker that runs dry steals from the others,
+// which absorbs imbalance (e.g. chunks that hit many obstacles).
+class ThreadPool {
+public:
+    // Chunk sizes handed to parallelFor are rounded up to this many elements,
+    // so float arrays split on 64-byte cache-line boundaries
+    static constexpr std::size_t CHUNK_ALIGNMENT = 16;
+
+    // thread_count <= 0 uses every hardware thread
+    explicit ThreadPool(int thread_count);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int getThreadCount() const { return thread_count; }
+
+    // Calls fn(begin, end, worker_index) for every chunk of [0, count) and
+    // returns once all chunks are done. Does not allocate.
+    template <typename Fn>
+    void parallelFor(std::size_t count, std::size_t chunk_size, Fn&& fn) {
+        using Callable = typename std::remove_reference<Fn>::type;
+        run(count, alignChunkSize(chunk_size), [](void* context, std::size_t begin, std::size_t end, int worker) {
+            (*static_cast<Callable*>(context))(begin, end, worker);
+        }, const_cast<void*>(static_cast<const void*>(&fn)));
+    }
+
+    // Calls fn(task, worker_index) for every task in [0, task_count), one task
+    // per work item. For a few coarse items (e.g. matrix tiles) where chunk
+    // alignment would lump everything onto one worker.
+    template <typename Fn>
+    void parallelForEach(std::size_t task_count, Fn&& fn) {
+        using Callable = typename std::remove_reference<Fn>::type;
+        run(task_count, 1, [](void* context, std::size_t begin, std::size_t end, int worker) {
+            for (std::size_t task = begin; task < end; ++task) {
+                (*static_cast<Callable*>(context))(task, worker);
+            }
+        }, const_cast<void*>(static_cast<const void*>(&fn)));
+    }
+
+    static std::size_t alignChunkSize(std::size_t chunk_size);
+
+    // Every worker (the caller included) gets a scratch arena of at least this
+    // many bytes, reachable as FrameArena::forThread() from inside a job.
+    // Call between jobs; it only allocates when the size grows.
+    void reserveScratch(std::size_t bytes);
+
+    // Heap allocations so far on the calling thread plus this pool's helpers,
+    // i.e. on every thread that runs its jobs; 0 when counting is compiled out
+    uint64_t getAllocationCount() const;
+
+private:
+    using ChunkFn = void (*)(void* context, std::size_t begin, std::size_t end, int worker);
+
+    // Chunk indices [next, end) not yet claimed from this worker's run
+    struct alignas(64) WorkerQueue {
+        std::atomic<std::size_t> next{0};
+        std::size_t end = 0;
+    };
+
+    int thread_count;
+    std::vector<std::thread> threads;
+    std::unique_ptr<WorkerQueue[]> queues;
+    std::unique_ptr<FrameArena[]> worker_arenas; // Helpers' scratch; worker 0 keeps its own
+    // Helpers' allocation counters, published by each helper as it starts
+    std::unique_ptr<std::atomic<const std::atomic<uint64_t>*>[]> worker_allocations;
+
+    // Current job
+    ChunkFn job_fn = nullptr;
+    void* job_context = nullptr;
+    std::size_t job_count = 0;
+    std::size_t job_chunk_size = 0;
+
+    std::mutex mutex;
+    std::condition_variable wake_condition;
+    std::condition_variable done_condition;
+    uint64_t generation = 0;
+    int busy_workers = 0;
+    bool stopping = false;
+
+    // chunk_size must be non-zero; it is used as given
+    void run(std::size_t count, std::size_t chunk_size, ChunkFn fn, void* context);
+    void workerLoop(int worker);
+    void processChunks(int worker);
+    bool claimChunk(int queue, std::size_t& chunk);
+};
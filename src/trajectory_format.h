@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+
+// On-disk layout of a trajectory file (little-endian, as written by the host):
+//
+//   TrajectoryFileHeader
+//   chunk*    TrajectoryChunkHeader, then frame_count frames of
+//             uint64 frame index | uint16 x[particles] | uint16 y[particles]
+//   index     TrajectoryIndexEntry per chunk
+//   TrajectoryTrailer
+//
+// Positions are quantized to 16 bits over the world plus a margin:
+// x = origin_x + q * scale_x (about 0.02 px steps for a 1200 px world).
+// Every frame in a file has the same size, so a frame inside a chunk is found
+// by arithmetic. The index gives each chunk's offset; without it (a run that
+// died before close) readers can still walk the chunk headers.
+namespace TrajectoryFormat {
+
+constexpr char FILE_MAGIC[8] = {'B', 'R', 'W', 'N', 'T', 'R', 'J', '\0'};
+constexpr char TRAILER_MAGIC[8] = {'B', 'R', 'W', 'N', 'I', 'D', 'X', '\0'};
+constexpr uint32_t CHUNK_MAGIC = 0x4B4E4843; // "CHNK"
+constexpr uint32_t VERSION = 1;
+constexpr float WORLD_MARGIN = 16.0f; // Room for particles just past a wall
+constexpr uint32_t QUANTIZATION_LEVELS = 65535;
+
+inline uint64_t frameBytes(uint32_t particle_count) {
+    return sizeof(uint64_t) + 2ull * particle_count * sizeof(uint16_t);
+}
+
+} // namespace TrajectoryFormat
+
+struct TrajectoryFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t particle_count;
+    uint32_t frames_per_chunk;
+    uint32_t reserved;
+    float origin_x;
+    float origin_y;
+    float scale_x;
+    float scale_y;
+};
+
+struct TrajectoryChunkHeader {
+    uint32_t magic;
+    uint32_t frame_count;
+    uint64_t first_record; // Position of the chunk's first frame in the file
+};
+
+struct TrajectoryIndexEntry {
+    uint64_t first_record;
+    uint64_t offset;       // File offset of the TrajectoryChunkHeader
+    uint32_t frame_count;
+    uint32_t reserved;
+};
+
+struct TrajectoryTrailer {
+    uint64_t index_offset;
+    uint64_t chunk_count;
+    char magic[8];
+};
+
+static_assert(sizeof(TrajectoryFileHeader) == 40, "trajectory header layout");
+static_assert(sizeof(TrajectoryChunkHeader) == 16, "trajectory chunk header layout");
+static_assert(sizeof(TrajectoryIndexEntry) == 24, "trajectory index layout");
+static_assert(sizeof(TrajectoryTrailer) == 24, "trajectory trailer layout");
@@ -0,0 +1,160 @@
+#include "trajectory_reader.h"
+#include <algorithm>
+#include <cstring>
+
+TrajectoryReader::TrajectoryReader()
+    : data(nullptr),
+      size(0),
+      indexed(false),
+      particle_count(0),
+      frame_bytes(0),
+      frame_count(0),
+      origin_x(0.0f),
+      origin_y(0.0f),
+      scale_x(1.0f),
+      scale_y(1.0f) {
+}
+
+TrajectoryReader::~TrajectoryReader() {
+    close();
+}
+
+bool TrajectoryReader::open(const std::string& path) {
+    close();
+    error.clear();
+    if (!file.open(path)) {
+        error = file.getError();
+        return false;
+    }
+    data = file.data();
+    size = file.size();
+
+    TrajectoryFileHeader header;
+    if (size < sizeof(header)) {
+        error = "file is too short for a trajectory header";
+        close();
+        return false;
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, TrajectoryFormat::FILE_MAGIC, sizeof(header.magic)) != 0) {
+        error = "not a trajectory file";
+        close();
+        return false;
+    }
+    if (header.version != TrajectoryFormat::VERSION) {
+        error = "unsupported trajectory version " + std::to_string(header.version);
+        close();
+        return false;
+    }
+
+    particle_count = header.particle_count;
+    frame_bytes = TrajectoryFormat::frameBytes(particle_count);
+    origin_x = header.origin_x;
+    origin_y = header.origin_y;
+    scale_x = header.scale_x;
+    scale_y = header.scale_y;
+
+    indexed = readIndex();
+    if (!indexed) {
+        scanChunks();
+    }
+    frame_count = chunks.empty() ? 0 : chunks.back().first_record + chunks.back().frame_count;
+    return true;
+}
+
+void TrajectoryReader::close() {
+    file.close();
+    data = nullptr;
+    size = 0;
+    chunks.clear();
+    indexed = false;
+    frame_count = 0;
+}
+
+bool TrajectoryReader::readIndex() {
+    TrajectoryTrailer trailer;
+    if (size < sizeof(TrajectoryFileHeader) + sizeof(trailer)) {
+        return false;
+    }
+    std::memcpy(&trailer, data + size - sizeof(trailer), sizeof(trailer));
+    if (std::memcmp(trailer.magic, TrajectoryFormat::TRAILER_MAGIC, sizeof(trailer.magic)) != 0) {
+        return false;
+    }
+    const uint64_t index_bytes = trailer.chunk_count * sizeof(TrajectoryIndexEntry);
+    if (trailer.index_offset + index_bytes + sizeof(trailer) != size) {
+        return false;
+    }
+
+    chunks.resize(trailer.chunk_count);
+    std::memcpy(chunks.data(), data + trailer.index_offset, index_bytes);
+
+    // Trust the index only if every chunk it names is in bounds and contiguous
+    uint64_t expected_record = 0;
+    for (const TrajectoryIndexEntry& entry : chunks) {
+        const uint64_t end = entry.offset + sizeof(TrajectoryChunkHeader) + entry.frame_count * frame_bytes;
+        if (entry.first_record != expected_record || end > trailer.index_offset) {
+            chunks.clear();
+            return false;
+        }
+        expected_record += entry.frame_count;
+    }
+    return true;
+}
+
+void TrajectoryReader::scanChunks() {
+    chunks.clear();
+    uint64_t offset = sizeof(TrajectoryFileHeader);
+    uint64_t expected_record = 0;
+    while (offset + sizeof(TrajectoryChunkHeader) <= size) {
+        TrajectoryChunkHeader header;
+        std::memcpy(&header, data + offset, sizeof(header));
+        const uint64_t chunk_bytes = sizeof(header) + header.frame_count * frame_bytes;
+        if (header.magic != TrajectoryFormat::CHUNK_MAGIC || header.first_record != expected_record ||
+            header.frame_count == 0 || offset + chunk_bytes > size) {
+            break;
+        }
+        chunks.push_back({header.first_record, offset, header.frame_count, 0});
+        expected_record += header.frame_count;
+        offset += chunk_bytes;
+    }
+}
+
+const uint8_t* TrajectoryReader::findFrame(uint64_t k) const {
+    if (k >= frame_count) {
+        return nullptr;
+    }
+    // Last chunk whose first record is <= k
+    auto chunk = std::upper_bound(chunks.begin(), chunks.end(), k,
+                                  [](uint64_t record, const TrajectoryIndexEntry& entry) {
+                                      return record < entry.first_record;
+                                  }) - 1;
+    return data + chunk->offset + sizeof(TrajectoryChunkHeader) + (k - chunk->first_record) * frame_bytes;
+}
+
+uint64_t TrajectoryReader::getFrameIndex(uint64_t k) const {
+    const uint8_t* frame = findFrame(k);
+    uint64_t frame_index = 0;
+    if (frame) {
+        std::memcpy(&frame_index, frame, sizeof(frame_index));
+    }
+    return frame_index;
+}
+
+bool TrajectoryReader::readFrame(uint64_t k, float* x, float* y) const {
+    const uint8_t* frame = findFrame(k);
+    if (!frame) {
+        return false;
+    }
+
+    const uint8_t* quantized_x = frame + sizeof(uint64_t);
+    const uint8_t* quantized_y = quantized_x + particle_count * sizeof(uint16_t);
+    for (uint32_t i = 0; i < particle_count; ++i) {
+        uint16_t qx;
+        uint16_t qy;
+        std::memcpy(&qx, quantized_x + i * sizeof(uint16_t), sizeof(qx));
+        std::memcpy(&qy, quantized_y + i * sizeof(uint16_t), sizeof(qy));
+        x[i] = origin_x + qx * scale_x;
+        y[i] = origin_y + qy * scale_y;
+    }
+    return true;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "mapped_file.h"
+#include "trajectory_format.h"
+
+// Random access to a file written by TrajectoryWriter.
+//
+// The file is memory-mapped (see MappedFile), so opening it only reads the
+// header and the index footer; readFrame(k) finds the chunk holding frame k
+// by binary search and decodes just that frame.
+// A file without a footer (the writer never reached close()) is indexed by
+// walking the chunk headers instead; a torn last chunk is dropped.
+class TrajectoryReader {
+public:
+    TrajectoryReader();
+    ~TrajectoryReader();
+    TrajectoryReader(const TrajectoryReader&) = delete;
+    TrajectoryReader& operator=(const TrajectoryReader&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const { return file.isOpen(); }
+    const std::string& getError() const { return error; }
+    bool hasIndex() const { return indexed; }
+    uint32_t getParticleCount() const { return particle_count; }
+    uint64_t getFrameCount() const { return frame_count; }
+    std::size_t getChunkCount() const { return chunks.size(); }
+    // Largest error introduced by quantization, per axis
+    float getQuantizationStepX() const { return scale_x; }
+    float getQuantizationStepY() const { return scale_y; }
+
+    // Simulation frame number stored with record k (k < getFrameCount())
+    uint64_t getFrameIndex(uint64_t k) const;
+    // Decode record k into x[particles] and y[particles]; false if k is out of range
+    bool readFrame(uint64_t k, float* x, float* y) const;
+
+private:
+    MappedFile file;
+    const uint8_t* data;
+    std::size_t size;
+    std::string error;
+    bool indexed;
+    uint32_t particle_count;
+    uint64_t frame_bytes;
+    uint64_t frame_count;
+    float origin_x;
+    float origin_y;
+    float scale_x;
+    float scale_y;
+    std::vector<TrajectoryIndexEntry> chunks;
+
+    bool readIndex();
+    void scanChunks();
+    const uint8_t* findFrame(uint64_t k) const;
+};
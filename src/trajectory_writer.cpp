@@ -0,0 +1,209 @@
+#include "trajectory_writer.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+TrajectoryWriter::TrajectoryWriter()
+    : file(nullptr),
+      particle_count(0),
+      frames_per_chunk(DEFAULT_FRAMES_PER_CHUNK),
+      frame_bytes(0),
+      origin_x(0.0f),
+      origin_y(0.0f),
+      inverse_scale_x(1.0f),
+      inverse_scale_y(1.0f),
+      records(0),
+      stalls(0),
+      active(0),
+      pending(nullptr),
+      stopping(false),
+      failed(false),
+      file_offset(0) {
+}
+
+TrajectoryWriter::~TrajectoryWriter() {
+    close();
+}
+
+bool TrajectoryWriter::open(const std::string& path, uint32_t particles, float world_width, float world_height,
+                            uint32_t chunk_frames) {
+    close();
+
+    file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        error = "could not open '" + path + "' for writing: " + std::strerror(errno);
+        return false;
+    }
+
+    particle_count = particles;
+    frames_per_chunk = std::max<uint32_t>(chunk_frames, 1);
+    frame_bytes = TrajectoryFormat::frameBytes(particle_count);
+    origin_x = -TrajectoryFormat::WORLD_MARGIN;
+    origin_y = -TrajectoryFormat::WORLD_MARGIN;
+    const float scale_x = (world_width + 2 * TrajectoryFormat::WORLD_MARGIN) / TrajectoryFormat::QUANTIZATION_LEVELS;
+    const float scale_y = (world_height + 2 * TrajectoryFormat::WORLD_MARGIN) / TrajectoryFormat::QUANTIZATION_LEVELS;
+    inverse_scale_x = 1.0f / scale_x;
+    inverse_scale_y = 1.0f / scale_y;
+    records = 0;
+    stalls = 0;
+    failed = false;
+    stopping = false;
+    pending = nullptr;
+    error.clear();
+
+    TrajectoryFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, TrajectoryFormat::FILE_MAGIC, sizeof(header.magic));
+    header.version = TrajectoryFormat::VERSION;
+    header.particle_count = particle_count;
+    header.frames_per_chunk = frames_per_chunk;
+    header.origin_x = origin_x;
+    header.origin_y = origin_y;
+    header.scale_x = scale_x;
+    header.scale_y = scale_y;
+    if (!writeBytes(&header, sizeof(header))) {
+        error = "could not write the trajectory header";
+        std::fclose(file);
+        file = nullptr;
+        return false;
+    }
+    file_offset = sizeof(header);
+
+    const std::size_t chunk_bytes = sizeof(TrajectoryChunkHeader) + frames_per_chunk * frame_bytes;
+    for (Chunk& chunk : chunks) {
+        chunk.bytes.resize(chunk_bytes);
+        chunk.frame_count = 0;
+    }
+    active = 0;
+    index.clear();
+    index.reserve(1024);
+
+    io_thread = std::thread(&TrajectoryWriter::ioLoop, this);
+    return true;
+}
+
+void TrajectoryWriter::addFrame(const ParticleStore& particles, uint64_t frame_index) {
+    if (!file || particles.size() != particle_count) {
+        return;
+    }
+
+    Chunk& chunk = chunks[active];
+    if (chunk.frame_count == 0) {
+        chunk.first_record = records;
+    }
+
+    // Frames start at even offsets, so the 16-bit arrays are aligned
+    uint8_t* frame = chunk.bytes.data() + sizeof(TrajectoryChunkHeader) + chunk.frame_count * frame_bytes;
+    std::memcpy(frame, &frame_index, sizeof(frame_index));
+    uint16_t* quantized_x = reinterpret_cast<uint16_t*>(frame + sizeof(uint64_t));
+    uint16_t* quantized_y = quantized_x + particle_count;
+
+    // Slot k is the particle with id k, wherever --sort-every moved it (ids
+    // of a single simulation are 0 .. count - 1)
+    const float levels = static_cast<float>(TrajectoryFormat::QUANTIZATION_LEVELS);
+    for (uint32_t i = 0; i < particle_count; ++i) {
+        const uint32_t slot = std::min(particles.id[i], particle_count - 1);
+        const float x = (particles.pos_x[i] - origin_x) * inverse_scale_x + 0.5f;
+        const float y = (particles.pos_y[i] - origin_y) * inverse_scale_y + 0.5f;
+        quantized_x[slot] = static_cast<uint16_t>(std::clamp(x, 0.0f, levels));
+        quantized_y[slot] = static_cast<uint16_t>(std::clamp(y, 0.0f, levels));
+    }
+
+    ++records;
+    if (++chunk.frame_count == frames_per_chunk) {
+        submitActive();
+    }
+}
+
+void TrajectoryWriter::submitActive() {
+    Chunk& chunk = chunks[active];
+    TrajectoryChunkHeader header;
+    header.magic = TrajectoryFormat::CHUNK_MAGIC;
+    header.frame_count = chunk.frame_count;
+    header.first_record = chunk.first_record;
+    std::memcpy(chunk.bytes.data(), &header, sizeof(header));
+
+    {
+        // The other buffer is in flight until the I/O thread clears pending
+        std::unique_lock<std::mutex> lock(mutex);
+        if (pending) {
+            ++stalls;
+            condition.wait(lock, [this] { return pending == nullptr; });
+        }
+        // Room for this chunk's index entry, so the I/O thread never allocates
+        if (index.size() == index.capacity()) {
+            index.reserve(index.capacity() * 2);
+        }
+        pending = &chunk;
+    }
+    condition.notify_all();
+
+    active = 1 - active;
+    chunks[active].frame_count = 0;
+}
+
+void TrajectoryWriter::ioLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        condition.wait(lock, [this] { return pending != nullptr || stopping; });
+        if (!pending) {
+            break;
+        }
+
+        Chunk* chunk = pending;
+        const uint64_t offset = file_offset;
+        const std::size_t size = sizeof(TrajectoryChunkHeader) + chunk->frame_count * frame_bytes;
+        lock.unlock();
+        const bool written = writeBytes(chunk->bytes.data(), size);
+        lock.lock();
+
+        if (written) {
+            index.push_back({chunk->first_record, offset, chunk->frame_count, 0});
+            file_offset += size;
+        } else {
+            failed = true;
+        }
+        pending = nullptr;
+        condition.notify_all();
+    }
+}
+
+bool TrajectoryWriter::writeBytes(const void* data, std::size_t size) {
+    return std::fwrite(data, 1, size, file) == size;
+}
+
+bool TrajectoryWriter::close() {
+    if (!file) {
+        return !failed;
+    }
+
+    if (chunks[active].frame_count > 0) {
+        submitActive();
+    }
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [this] { return pending == nullptr; });
+        stopping = true;
+    }
+    condition.notify_all();
+    io_thread.join();
+
+    // The I/O thread is gone; the index and trailer go out from here
+    TrajectoryTrailer trailer;
+    trailer.index_offset = file_offset;
+    trailer.chunk_count = index.size();
+    std::memcpy(trailer.magic, TrajectoryFormat::TRAILER_MAGIC, sizeof(trailer.magic));
+    if (!failed) {
+        failed = !writeBytes(index.data(), index.size() * sizeof(TrajectoryIndexEntry)) ||
+                 !writeBytes(&trailer, sizeof(trailer));
+    }
+    if (std::fclose(file) != 0) {
+        failed = true;
+    }
+    file = nullptr;
+
+    if (failed && error.empty()) {
+        error = "writing the trajectory file failed (disk full?)";
+    }
+    return !failed;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "particle_store.h"
+#include "trajectory_format.h"
+
+// Appends particle positions, one frame per addFrame(), to a chunked binary
+// trajectory file (see trajectory_format.h).
+//
+// Frames are quantized into the active chunk buffer on the calling thread,
+// which is one pass over pos_x / pos_y. A full chunk is handed to a background
+// I/O thread while the other buffer fills, so the simulation loop only blocks
+// if the disk falls more than a whole chunk behind. Those waits are counted.
+// Buffers are sized in open(). The chunk index starts with room for 1024
+// chunks and doubles, on the calling thread at a chunk hand-off, when it fills;
+// no other frame allocates, and the I/O thread never does.
+class TrajectoryWriter {
+public:
+    static constexpr uint32_t DEFAULT_FRAMES_PER_CHUNK = 64;
+
+    TrajectoryWriter();
+    ~TrajectoryWriter();
+    TrajectoryWriter(const TrajectoryWriter&) = delete;
+    TrajectoryWriter& operator=(const TrajectoryWriter&) = delete;
+
+    bool open(const std::string& path, uint32_t particle_count, float world_width, float world_height,
+              uint32_t frames_per_chunk = DEFAULT_FRAMES_PER_CHUNK);
+
+    // particles.size() must match the count given to open(); they are
+    // written in id order, whatever their order in the arrays
+    void addFrame(const ParticleStore& particles, uint64_t frame_index);
+
+    // Flush the partial chunk, write the index footer and stop the I/O thread.
+    // False if any write failed (see getError()).
+    bool close();
+
+    bool isOpen() const { return file != nullptr; }
+    const std::string& getError() const { return error; }
+    uint64_t getFramesWritten() const { return records; }
+    // Times addFrame() had to wait for the I/O thread to free a buffer
+    uint64_t getStallCount() const { return stalls; }
+
+private:
+    struct Chunk {
+        std::vector<uint8_t> bytes; // Chunk header followed by the frames
+        uint32_t frame_count = 0;
+        uint64_t first_record = 0;
+    };
+
+    std::FILE* file;
+    std::string error;
+    uint32_t particle_count;
+    uint32_t frames_per_chunk;
+    uint64_t frame_bytes;
+    float origin_x;
+    float origin_y;
+    float inverse_scale_x;
+    float inverse_scale_y;
+    uint64_t records;
+    uint64_t stalls;
+
+    Chunk chunks[2];
+    int active; // Chunk addFrame() fills; the other one may be in flight
+
+    // Hand-off to the I/O thread; everything below is guarded by mutex
+    std::thread io_thread;
+    std::mutex mutex;
+    std::condition_variable condition;
+    Chunk* pending;  // Full chunk owned by the I/O thread until written, or nullptr
+    bool stopping;
+    bool failed;
+    uint64_t file_offset;
+    std::vector<TrajectoryIndexEntry> index;
+
+    void submitActive();
+    void ioLoop();
+    bool writeBytes(const void* data, std::size_t size);
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Lock-free single-producer / single-consumer hand-off of whole values.
+// The producer fills getWriteBuffer() and publish()es it; the consumer
+// acquire()s the newest published value and reads getReadBuffer() for as
+// long as it likes. Three slots mean neither side ever waits: the third one,
+// shared, is swapped with an atomic exchange. Frames the consumer was too
+// slow to see are skipped, never queued.
+template <typename T>
+class TripleBuffer {
+public:
+    TripleBuffer() : shared(2), write_index(0), read_index(1) {}
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    // Producer side
+    T& getWriteBuffer() { return buffers[write_index]; }
+    void publish() {
+        write_index = shared.exchange(write_index | FRESH, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+
+    // Consumer side: true if a newer value replaced the read buffer
+    bool acquire() {
+        if ((shared.load(std::memory_order_relaxed) & FRESH) == 0) {
+            return false;
+        }
+        read_index = shared.exchange(read_index, std::memory_order_acq_rel) & INDEX_MASK;
+        return true;
+    }
+    const T& getReadBuffer() const { return buffers[read_index]; }
+
+private:
+    static constexpr uint8_t INDEX_MASK = 3;
+    static constexpr uint8_t FRESH = 4; // Set on publish, cleared by acquire
+
+    T buffers[3];
+    std::atomic<uint8_t> shared; // Slot in the middle, plus FRESH
+    uint8_t write_index;         // Owned by the producer
+    uint8_t read_index;          // Owned by the consumer
+};
@@ -0,0 +1,195 @@
+#include "fps_counter.h"
+#include <cstdio>
+#include <sstream>
+#include <iomanip>
+#include <memory>
+#include <string>
+
+namespace {
+
+// Which matrix implementation this binary was built with
+const char* matrixVariantName() {
+#ifdef USE_SLOW_MATRIX
+    return "SLOW";
+#elif defined(USE_FAST_MATRIX)
+    return "FAST";
+#elif defined(USE_ULTRA_FAST_MATRIX)
+    return "ULTRA";
+#elif defined(USE_GEMM_MATRIX)
+    return "GEMM";
+#else
+    return "DEFAULT";
+#endif
+}
+
+} // namespace
+
+FPSCounter::FPSCounter() : frame_stats(TEXT_REFRESH_SECONDS), font_loaded(false) {
+}
+
+bool FPSCounter::initialize() {
+    // Try to load system font (this might fail on some systems)
+    // SFML 3.x uses openFromFile, SFML 2.x uses loadFromFile
+#if SFML_VERSION_MAJOR >= 3
+    if (font.openFromFile("/System/Library/Fonts/Helvetica.ttc") ||  // macOS
+        font.openFromFile("/Library/Fonts/Arial.ttf") ||  // macOS alternative
+        font.openFromFile("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf") ||  // Linux
+        font.openFromFile("C:\\Windows\\Fonts\\arial.ttf")) {  // Windows
+#else
+    if (font.loadFromFile("/System/Library/Fonts/Helvetica.ttc") ||  // macOS
+        font.loadFromFile("/Library/Fonts/Arial.ttf") ||  // macOS alternative
+        font.loadFromFile("/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf") ||  // Linux
+        font.loadFromFile("C:\\Windows\\Fonts\\arial.ttf")) {  // Windows
+#endif
+        
+        font_loaded = true;
+        
+        // SFML 3.x vs 2.x text constructor compatibility
+#if SFML_VERSION_MAJOR >= 3
+        fps_text = std::make_unique<sf::Text>(font, "FPS: --", 24);
+#else
+        fps_text = std::make_unique<sf::Text>("FPS: --", font, 24);
+#endif
+        fps_text->setFillColor(sf::Color::Black); // Black text on white background
+        fps_text->setStyle(sf::Text::Bold);
+        fps_text->setPosition(sf::Vector2f(10, 10));
+        
+#if defined(BROWNIAN_PROFILING)
+#if SFML_VERSION_MAJOR >= 3
+        profile_text = std::make_unique<sf::Text>(font, "", 14);
+#else
+        profile_text = std::make_unique<sf::Text>("", font, 14);
+#endif
+        profile_text->setFillColor(sf::Color::Black);
+        profile_text->setPosition(sf::Vector2f(10, 80));
+#endif
+        
+#if SFML_VERSION_MAJOR >= 3
+        counter_text = std::make_unique<sf::Text>(font, "", 14);
+#else
+        counter_text = std::make_unique<sf::Text>("", font, 14);
+#endif
+        counter_text->setFillColor(sf::Color::Black);
+        return true;
+    }
+    
+    // If we can't load system fonts, we'll proceed without text display
+    return false;
+}
+
+void FPSCounter::update() {
+    const auto now = Clock::now();
+    if (has_frame) {
+        frame_stats.addFrame(std::chrono::duration_cast<std::chrono::nanoseconds>(now - last_frame));
+    } else {
+        has_frame = true;
+        last_text = now;
+    }
+    last_frame = now;
+    
+    if (now - last_text >= std::chrono::duration<double>(TEXT_REFRESH_SECONDS)) {
+        updateFpsText();
+        last_text = now;
+    }
+    
+#if defined(BROWNIAN_PROFILING)
+    if (++profile_frames == PROFILE_REFRESH_FRAMES) {
+        updateProfileText();
+        profile_frames = 0;
+    }
+#endif
+}
+
+void FPSCounter::updateFpsText() {
+    if (!font_loaded || !fps_text) {
+        return;
+    }
+    
+    const FrameStatsSnapshot snapshot = frame_stats.getSnapshot();
+    char sim[32] = "";
+    if (simulation_rate > 0.0f) {
+        std::snprintf(sim, sizeof(sim), " | Sim: %.1f", simulation_rate);
+    }
+    char text[160];
+    std::snprintf(text, sizeof(text), "FPS: %.1f | p99: %.2f ms%s\nParticles: %zu | Matrix: %dx%d | %s",
+                  snapshot.fps, snapshot.p99_ms, sim, particle_count, matrix_size, matrix_size,
+                  matrixVariantName());
+    fps_text->setString(text);
+}
+
+void FPSCounter::addPhaseCounters(const PerfCounters& counters, const PhaseCounters& frame) {
+    counter_totals += frame;
+    if (++counter_frames < COUNTER_REFRESH_FRAMES) {
+        return;
+    }
+    
+    if (counter_text) {
+        std::ostringstream oss;
+        oss << "Per frame, update thread:\n";
+        counters.formatPhases(oss, counter_totals, counter_frames);
+        counter_text->setString(oss.str());
+        counter_lines = 4;
+    }
+    counter_totals = PhaseCounters();
+    counter_frames = 0;
+}
+
+#if defined(BROWNIAN_PROFILING)
+void FPSCounter::updateProfileText() {
+    profile_zone_count = Profiler::collectSummary(profile_zones, Profiler::MAX_SUMMARY_ZONES);
+    if (!profile_text) {
+        return;
+    }
+    
+    // Nested zones are indented under their parents; worker zones are summed
+    // over threads, so they can add up to more than their parent
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(3);
+    for (int i = 0; i < profile_zone_count; ++i) {
+        const ZoneSummary& zone = profile_zones[i];
+        oss << std::string(zone.depth * 4, ' ') << zone.name << ": "
+            << zone.total_ms / PROFILE_REFRESH_FRAMES << " ms\n";
+    }
+    profile_text->setString(oss.str());
+}
+#endif
+
+void FPSCounter::render(sf::RenderWindow& window) {
+    PROFILE_ZONE("FPSCounter::render");
+    
+    if (font_loaded && fps_text) {
+        // Draw semi-transparent background
+        sf::RectangleShape background(sf::Vector2f(440, 70));
+        background.setPosition(sf::Vector2f(5, 5));
+        background.setFillColor(sf::Color(255, 255, 255, 200)); // Light background for better readability
+        window.draw(background);
+        
+        // Draw FPS text
+        window.draw(*fps_text);
+        
+#if defined(BROWNIAN_PROFILING)
+        if (profile_zone_count > 0) {
+            sf::RectangleShape profile_background(sf::Vector2f(420, 10 + 17.0f * profile_zone_count));
+            profile_background.setPosition(sf::Vector2f(5, 78));
+            profile_background.setFillColor(sf::Color(255, 255, 255, 200));
+            window.draw(profile_background);
+            window.draw(*profile_text);
+        }
+#endif
+        
+        if (counter_lines > 0) {
+            float top = 78;
+#if defined(BROWNIAN_PROFILING)
+            if (profile_zone_count > 0) {
+                top += 15 + 17.0f * profile_zone_count;
+            }
+#endif
+            sf::RectangleShape counter_background(sf::Vector2f(520, 10 + 17.0f * counter_lines));
+            counter_background.setPosition(sf::Vector2f(5, top));
+            counter_background.setFillColor(sf::Color(255, 255, 255, 200));
+            window.draw(counter_background);
+            counter_text->setPosition(sf::Vector2f(10, top + 2));
+            window.draw(*counter_text);
+        }
+    }
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include "frame_stats.h"
+#include "profiler.h"
+#include "perf_counters.h"
+
+// FPS overlay. Frame-to-frame intervals go into a FrameStats ring (no
+// allocation per frame); the text is rebuilt from its snapshot only every
+// TEXT_REFRESH_SECONDS, since formatting and re-laying out glyphs every frame
+// costs more than the figures are worth.
+class FPSCounter {
+private:
+    using Clock = std::chrono::steady_clock;
+    static constexpr double TEXT_REFRESH_SECONDS = 0.25;
+    
+    FrameStats frame_stats;
+    Clock::time_point last_frame;
+    Clock::time_point last_text;
+    bool has_frame = false;
+    
+    sf::Font font;
+    std::unique_ptr<sf::Text> fps_text;
+    bool font_loaded;
+    
+    // What the overlay describes, set by the viewer
+    std::size_t particle_count = 0;
+    int matrix_size = 0;
+    
+    void updateFpsText();
+    
+#if defined(BROWNIAN_PROFILING)
+    // Live zone breakdown, averaged per frame over PROFILE_REFRESH_FRAMES
+    static constexpr int PROFILE_REFRESH_FRAMES = 30;
+    std::unique_ptr<sf::Text> profile_text;
+    ZoneSummary profile_zones[Profiler::MAX_SUMMARY_ZONES];
+    int profile_zone_count = 0;
+    int profile_frames = 0;
+    void updateProfileText();
+#endif
+    
+    // Hardware counters per phase, averaged per frame over COUNTER_REFRESH_FRAMES
+    static constexpr int COUNTER_REFRESH_FRAMES = 30;
+    std::unique_ptr<sf::Text> counter_text;
+    PhaseCounters counter_totals;
+    int counter_frames = 0;
+    int counter_lines = 0;
+    
+    // Simulation steps per second, shown next to FPS when set
+    float simulation_rate = 0.0f;
+    
+public:
+    FPSCounter();
+    
+    bool initialize(); // Load font and setup text
+    void update(); // Call this every frame
+    // Feed one frame of per-phase counter deltas (only when counters are open)
+    void addPhaseCounters(const PerfCounters& counters, const PhaseCounters& frame);
+    void setSimulationRate(float ticks_per_second) { simulation_rate = ticks_per_second; }
+    void setWorkload(std::size_t particles, int matrix_edge) {
+        particle_count = particles;
+        matrix_size = matrix_edge;
+    }
+    void render(sf::RenderWindow& window);
+    
+    // Over the last FrameStats::WINDOW frames, as of the last text refresh
+    float getCurrentFPS() const { return static_cast<float>(frame_stats.getSnapshot().fps); }
+    const FrameStats& getFrameStats() const { return frame_stats; }
+}; 
\ No newline at end of file
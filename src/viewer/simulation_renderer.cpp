@@ -0,0 +1,238 @@
+#include "simulation_renderer.h"
+#include "profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+SimulationRenderer::SimulationRenderer()
+    : obstacle_vertices(sf::PrimitiveType::Triangles),
+      particle_vertices(sf::PrimitiveType::Triangles),
+      particle_texture_ready(false),
+      density_columns(0),
+      density_rows(0),
+      density_quad(sf::PrimitiveType::Triangles, 6) {
+}
+
+void SimulationRenderer::render(sf::RenderWindow& window, const RenderSnapshot& snapshot, float alpha,
+                                RenderLod lod) {
+    PROFILE_ZONE("SimulationRenderer::render");
+
+    // Draw obstacles first (so they appear behind particles)
+    renderObstacles(window, snapshot);
+    if (lod == RenderLod::Density) {
+        renderDensity(window, snapshot);
+    } else {
+        renderParticles(window, snapshot, std::clamp(alpha, 0.0f, 1.0f));
+    }
+}
+
+void SimulationRenderer::renderObstacles(sf::RenderWindow& window, const RenderSnapshot& snapshot) {
+    PROFILE_ZONE("SimulationRenderer::renderObstacles");
+
+    // Every obstacle goes into one vertex array, in draw order: the fill (two
+    // triangles) followed by its outline (four edge quads), so all obstacles
+    // take a single draw call. Corners come from the captured poses.
+    const std::size_t obstacle_count = snapshot.getObstacleCount();
+    const float outline_thickness = 2.0f;
+    const sf::Color outline_color(0, 0, 0, 100);
+    obstacle_vertices.resize(obstacle_count * VERTICES_PER_OBSTACLE);
+
+    for (std::size_t i = 0; i < obstacle_count; ++i) {
+        const sf::Vector2f center(snapshot.obstacle_x[i], snapshot.obstacle_y[i]);
+        const float cos_a = snapshot.obstacle_cos[i];
+        const float sin_a = snapshot.obstacle_sin[i];
+        const float half_width = snapshot.obstacle_half_width[i];
+        const float half_height = snapshot.obstacle_half_height[i];
+        auto toWorld = [&](float x, float y) {
+            return center + sf::Vector2f(x * cos_a - y * sin_a, x * sin_a + y * cos_a);
+        };
+
+        sf::Vector2f inner[4];
+        sf::Vector2f outer[4];
+        const float signs[4][2] = {{-1, -1}, {1, -1}, {1, 1}, {-1, 1}};
+        for (int corner = 0; corner < 4; ++corner) {
+            inner[corner] = toWorld(signs[corner][0] * half_width, signs[corner][1] * half_height);
+            outer[corner] = toWorld(signs[corner][0] * (half_width + outline_thickness),
+                                    signs[corner][1] * (half_height + outline_thickness));
+        }
+
+        sf::Vertex* vertex = &obstacle_vertices[i * VERTICES_PER_OBSTACLE];
+        const sf::Color fill_color = toSfColor(snapshot.obstacle_color[i]);
+        const sf::Vector2f fill[6] = {inner[0], inner[1], inner[2], inner[0], inner[2], inner[3]};
+        for (const auto& position : fill) {
+            vertex->position = position;
+            vertex->color = fill_color;
+            ++vertex;
+        }
+
+        for (int edge = 0; edge < 4; ++edge) {
+            const int next = (edge + 1) % 4;
+            const sf::Vector2f band[6] = {inner[edge], outer[edge], outer[next],
+                                          inner[edge], outer[next], inner[next]};
+            for (const auto& position : band) {
+                vertex->position = position;
+                vertex->color = outline_color;
+                ++vertex;
+            }
+        }
+    }
+
+    window.draw(obstacle_vertices);
+}
+
+void SimulationRenderer::renderParticles(sf::RenderWindow& window, const RenderSnapshot& snapshot, float alpha) {
+    // The texture needs a GL context, so it is created on first render
+    if (!particle_texture_ready) {
+        createParticleTexture();
+    }
+
+    // Draw particles as textured quads tinted with the particle color
+    const std::size_t count = snapshot.getParticleCount();
+    const float texture_size = static_cast<float>(PARTICLE_TEXTURE_SIZE);
+    const bool interpolate = alpha < 1.0f && snapshot.hasPrevious();
+    const float half_width = snapshot.world_width * 0.5f;
+    const float half_height = snapshot.world_height * 0.5f;
+    particle_vertices.resize(count * 6);
+
+    for (std::size_t i = 0; i < count; ++i) {
+        float x = snapshot.pos_x[i];
+        float y = snapshot.pos_y[i];
+        if (interpolate) {
+            // A periodic wrap jumps across the world; those are drawn where they landed
+            const float dx = x - snapshot.previous_x[i];
+            const float dy = y - snapshot.previous_y[i];
+            if (std::abs(dx) < half_width && std::abs(dy) < half_height) {
+                x = snapshot.previous_x[i] + dx * alpha;
+                y = snapshot.previous_y[i] + dy * alpha;
+            }
+        }
+        const float r = snapshot.radius[i];
+        const float left = x - r;
+        const float top = y - r;
+        const float right = x + r;
+        const float bottom = y + r;
+        const sf::Color color = toSfColor(snapshot.color[i]);
+
+        sf::Vertex* quad = &particle_vertices[i * 6];
+        quad[0].position = sf::Vector2f(left, top);
+        quad[1].position = sf::Vector2f(right, top);
+        quad[2].position = sf::Vector2f(right, bottom);
+        quad[3].position = sf::Vector2f(left, top);
+        quad[4].position = sf::Vector2f(right, bottom);
+        quad[5].position = sf::Vector2f(left, bottom);
+
+        quad[0].texCoords = sf::Vector2f(0, 0);
+        quad[1].texCoords = sf::Vector2f(texture_size, 0);
+        quad[2].texCoords = sf::Vector2f(texture_size, texture_size);
+        quad[3].texCoords = sf::Vector2f(0, 0);
+        quad[4].texCoords = sf::Vector2f(texture_size, texture_size);
+        quad[5].texCoords = sf::Vector2f(0, texture_size);
+
+        for (int v = 0; v < 6; ++v) {
+            quad[v].color = color;
+        }
+    }
+
+    sf::RenderStates states(&particle_texture);
+    window.draw(particle_vertices, states);
+}
+
+void SimulationRenderer::renderDensity(sf::RenderWindow& window, const RenderSnapshot& snapshot) {
+    PROFILE_ZONE("SimulationRenderer::renderDensity");
+
+    const unsigned columns = std::max(1u, static_cast<unsigned>(std::ceil(snapshot.world_width / DENSITY_CELL_SIZE)));
+    const unsigned rows = std::max(1u, static_cast<unsigned>(std::ceil(snapshot.world_height / DENSITY_CELL_SIZE)));
+    if ((columns != density_columns || rows != density_rows) && !createDensityTexture(columns, rows)) {
+        return;
+    }
+
+    std::fill(density_counts.begin(), density_counts.end(), 0u);
+    const std::size_t count = snapshot.getParticleCount();
+    const float inverse_cell = 1.0f / DENSITY_CELL_SIZE;
+    for (std::size_t i = 0; i < count; ++i) {
+        const int column = static_cast<int>(snapshot.pos_x[i] * inverse_cell);
+        const int row = static_cast<int>(snapshot.pos_y[i] * inverse_cell);
+        if (column >= 0 && row >= 0 && column < static_cast<int>(columns) && row < static_cast<int>(rows)) {
+            ++density_counts[static_cast<std::size_t>(row) * columns + column];
+        }
+    }
+
+    // Saturate at a few times the mean occupancy, so both sparse and crowded
+    // runs keep some contrast; the tint is the usual dark particle color
+    const float mean = static_cast<float>(count) / (static_cast<float>(columns) * rows);
+    const float scale = 255.0f / std::max(4.0f * mean, 1.0f);
+    for (std::size_t cell = 0; cell < density_counts.size(); ++cell) {
+        uint8_t* pixel = &density_pixels[cell * 4];
+        pixel[0] = 40;
+        pixel[1] = 60;
+        pixel[2] = 140;
+        pixel[3] = static_cast<uint8_t>(std::min(255.0f, density_counts[cell] * scale));
+    }
+    density_texture.update(density_pixels.data());
+
+    sf::RenderStates states(&density_texture);
+    window.draw(density_quad, states);
+}
+
+bool SimulationRenderer::createDensityTexture(unsigned columns, unsigned rows) {
+#if SFML_VERSION_MAJOR >= 3
+    if (!density_texture.resize(sf::Vector2u(columns, rows))) {
+        return false;
+    }
+#else
+    if (!density_texture.create(columns, rows)) {
+        return false;
+    }
+#endif
+    density_texture.setSmooth(true);
+    density_columns = columns;
+    density_rows = rows;
+    density_counts.assign(static_cast<std::size_t>(columns) * rows, 0u);
+    density_pixels.assign(density_counts.size() * 4, 0);
+
+    // One quad over the world, texels stretched to DENSITY_CELL_SIZE pixels
+    const float width = static_cast<float>(columns * DENSITY_CELL_SIZE);
+    const float height = static_cast<float>(rows * DENSITY_CELL_SIZE);
+    const sf::Vector2f corners[6] = {{0, 0}, {width, 0}, {width, height}, {0, 0}, {width, height}, {0, height}};
+    const float u = static_cast<float>(columns);
+    const float v = static_cast<float>(rows);
+    const sf::Vector2f texels[6] = {{0, 0}, {u, 0}, {u, v}, {0, 0}, {u, v}, {0, v}};
+    for (int i = 0; i < 6; ++i) {
+        density_quad[i].position = corners[i];
+        density_quad[i].texCoords = texels[i];
+        density_quad[i].color = sf::Color::White;
+    }
+    return true;
+}
+
+void SimulationRenderer::createParticleTexture() {
+    // White anti-aliased disc; vertex colors tint it per particle
+    const unsigned size = PARTICLE_TEXTURE_SIZE;
+    const float center = size / 2.0f;
+
+#if SFML_VERSION_MAJOR >= 3
+    sf::Image image(sf::Vector2u(size, size), sf::Color::Transparent);
+#else
+    sf::Image image;
+    image.create(size, size, sf::Color::Transparent);
+#endif
+
+    for (unsigned y = 0; y < size; ++y) {
+        for (unsigned x = 0; x < size; ++x) {
+            float dx = x + 0.5f - center;
+            float dy = y + 0.5f - center;
+            float coverage = std::clamp(center - std::sqrt(dx * dx + dy * dy), 0.0f, 1.0f);
+            sf::Color pixel(255, 255, 255, static_cast<std::uint8_t>(coverage * 255.0f));
+#if SFML_VERSION_MAJOR >= 3
+            image.setPixel(sf::Vector2u(x, y), pixel);
+#else
+            image.setPixel(x, y, pixel);
+#endif
+        }
+    }
+
+    if (particle_texture.loadFromImage(image)) {
+        particle_texture.setSmooth(true);
+    }
+    particle_texture_ready = true;
+}
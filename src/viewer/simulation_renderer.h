@@ -0,0 +1,52 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+#include <vector>
+#include "render_snapshot.h"
+
+// Draws a RenderSnapshot with SFML: obstacles first, then particles. The
+// core keeps no render state; everything here is rebuilt from the snapshot's
+// arrays each frame, reusing the vertex arrays.
+//
+// Particles are drawn at alpha of the way from the previous to the current
+// step. With RenderLod::Density they become one texture of per-pixel counts
+// instead, so the cost no longer depends on the particle count.
+class SimulationRenderer {
+public:
+    SimulationRenderer();
+
+    // alpha in [0, 1]: 0 draws the previous step, 1 the current one
+    void render(sf::RenderWindow& window, const RenderSnapshot& snapshot, float alpha = 1.0f,
+                RenderLod lod = RenderLod::Off);
+
+private:
+    // Batched rendering: fill + outline triangles for all obstacles
+    static constexpr int VERTICES_PER_OBSTACLE = 30;
+    sf::VertexArray obstacle_vertices;
+
+    // Batched rendering: one textured quad (two triangles) per particle in a
+    // persistent vertex array, drawn with a single draw call
+    sf::VertexArray particle_vertices;
+    sf::Texture particle_texture;
+    bool particle_texture_ready;
+    static constexpr unsigned PARTICLE_TEXTURE_SIZE = 32;
+
+    // Density splat: particle counts per DENSITY_CELL_SIZE pixel cell, drawn
+    // as one stretched quad
+    static constexpr unsigned DENSITY_CELL_SIZE = 2;
+    sf::Texture density_texture;
+    unsigned density_columns;
+    unsigned density_rows;
+    std::vector<uint32_t> density_counts;
+    std::vector<uint8_t> density_pixels; // RGBA
+    sf::VertexArray density_quad;
+
+    void renderObstacles(sf::RenderWindow& window, const RenderSnapshot& snapshot);
+    void renderParticles(sf::RenderWindow& window, const RenderSnapshot& snapshot, float alpha);
+    void renderDensity(sf::RenderWindow& window, const RenderSnapshot& snapshot);
+    void createParticleTexture();
+    bool createDensityTexture(unsigned columns, unsigned rows);
+
+    static sf::Color toSfColor(const Color& color) { return sf::Color(color.r, color.g, color.b, color.a); }
+};
@@ -0,0 +1,254 @@
+#include "viewer.h"
+#include "fps_counter.h"
+#include "simulation_renderer.h"
+#include "simulation.h"
+#include "particle_kernels.h"
+#include "thread_pool.h"
+#include "profiler.h"
+#include "render_snapshot.h"
+#include "triple_buffer.h"
+#include <SFML/Graphics.hpp>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <thread>
+
+int Viewer::run(BrownianSimulation& simulation, ThreadPool& thread_pool, const ViewerOptions& options) {
+    const bool pipelined = options.pipelined;
+    const unsigned width = static_cast<unsigned>(simulation.getWidth());
+    const unsigned height = static_cast<unsigned>(simulation.getHeight());
+
+    // Debug: Print SFML version
+    std::cout << "SFML Version: " << SFML_VERSION_MAJOR << "." << SFML_VERSION_MINOR << "." << SFML_VERSION_PATCH << std::endl;
+
+    // Create window with version-specific API
+#if SFML_VERSION_MAJOR >= 3
+    // SFML 3.x API
+    sf::RenderWindow window(sf::VideoMode(sf::Vector2u(width, height)),
+                           "Brownian Motion Simulation - C++ Zero Cost Conf Demo");
+#else
+    // SFML 2.x API
+    sf::RenderWindow window(sf::VideoMode(width, height),
+                           "Brownian Motion Simulation - C++ Zero Cost Conf Demo");
+#endif
+
+    window.setFramerateLimit(FRAME_RATE_LIMIT); // Lock to 120 FPS for consistent performance comparison
+    window.setVerticalSyncEnabled(false); // Disable V-Sync
+
+    if (!window.isOpen()) {
+        std::cout << "Error: Could not create window!" << std::endl;
+        return -1;
+    }
+
+    // Initialize components
+    SimulationRenderer renderer;
+    FPSCounter fps_counter;
+
+    if (!fps_counter.initialize()) {
+        std::cout << "Warning: Could not load font for FPS counter\n";
+    }
+    fps_counter.setWorkload(simulation.getParticleCount(), simulation.getMatrixSize());
+
+    // Timing variables
+    using Clock = std::chrono::high_resolution_clock;
+    auto last_time = Clock::now();
+
+    uint64_t rate_frame_index = simulation.getFrameIndex();
+    auto rate_time = last_time;
+
+    std::cout << "Brownian Motion Simulation Started\n";
+    std::cout << "Particles: " << simulation.getParticleCount() << "\n";
+    std::cout << "Window: " << width << "x" << height << "\n";
+    std::cout << "Matrix operations: " << simulation.getMatrixSize() << "x" << simulation.getMatrixSize()
+              << (simulation.isMatrixProductLazy() ? " (lazy, recomputed on change)" : " per frame") << "\n";
+    std::cout << "Particle kernels: " << ParticleKernels::getInstructionSetName() << "\n";
+    std::cout << "Seed: " << simulation.getSeed() << "\n";
+    std::cout << "Threads: " << thread_pool.getThreadCount() << "\n";
+    std::cout << "Rendering: " << (pipelined ? "pipelined (simulation on its own thread)" : "serial") << "\n";
+    std::cout << "Press ESC to exit, SPACE to reset\n";
+
+    // Level of detail: decimation shrinks the snapshot itself, density keeps
+    // every position but draws one texture
+    const std::size_t particle_count = simulation.getParticleCount();
+    const bool over_budget = options.lod != RenderLod::Off && particle_count > options.render_budget;
+    const RenderLod lod = over_budget ? options.lod : RenderLod::Off;
+    const std::size_t stride = lod == RenderLod::Decimate ?
+        RenderSnapshot::decimationStride(particle_count, options.render_budget) : 1;
+    if (lod == RenderLod::Decimate) {
+        std::cout << "Level of detail: drawing every " << stride << "th particle (budget "
+                  << options.render_budget << ")\n";
+    } else if (lod == RenderLod::Density) {
+        std::cout << "Level of detail: density image (budget " << options.render_budget << ")\n";
+    }
+    std::cout << "Timestep: " << options.timestep * 1000.0f << " ms, up to " << options.max_substeps
+              << " steps per frame" << (options.interpolate ? ", interpolated" : "") << "\n";
+
+    // Run the steps one frame's worth of wall time covers; the last one records
+    // where particles started so the frame can be drawn between the two
+    auto runSteps = [&](FixedTimestep& timestep, float elapsed, RenderSnapshot& snapshot) {
+        const int steps = timestep.advance(elapsed);
+        for (int i = 0; i < steps; ++i) {
+            if (i == steps - 1 && options.interpolate) {
+                snapshot.capturePrevious(simulation, stride);
+            }
+            simulation.update(timestep.getStep());
+        }
+        if (steps > 0) {
+            snapshot.capture(simulation, stride);
+        }
+        return steps;
+    };
+
+    // Pipelined mode: the simulation thread owns the simulation from here to
+    // the join; this thread only sees it through snapshots and the two flags
+    TripleBuffer<RenderSnapshot> snapshots;
+    RenderSnapshot serial_snapshot;
+    FixedTimestep serial_timestep(options.timestep, options.max_substeps);
+    std::atomic<bool> simulating(true);
+    std::atomic<bool> reset_requested(false);
+    std::thread simulation_thread;
+    if (pipelined) {
+        // Counters count the thread that opened them, so they move along
+        const bool counting = simulation.getPerfCounters().isOpen();
+        std::promise<void> started;
+        simulation_thread = std::thread([&] {
+            PROFILE_THREAD("simulation");
+            if (counting) {
+                simulation.enablePerfCounters();
+            }
+            started.set_value();
+
+            FixedTimestep timestep(options.timestep, options.max_substeps);
+            const auto step_duration = std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(timestep.getStep()));
+            auto last_tick = Clock::now();
+            while (simulating.load(std::memory_order_relaxed)) {
+                const auto tick_start = Clock::now();
+                const float elapsed = std::chrono::duration<float>(tick_start - last_tick).count();
+                last_tick = tick_start;
+
+                if (reset_requested.exchange(false)) {
+                    simulation.resetParticles();
+                }
+                if (runSteps(timestep, elapsed, snapshots.getWriteBuffer()) > 0) {
+                    snapshots.publish();
+                }
+
+                // Nothing to do until the next step is due
+                std::this_thread::sleep_until(tick_start + step_duration);
+            }
+        });
+        started.get_future().wait();
+    } else {
+        // Something to draw before the first step is due
+        serial_snapshot.capture(simulation, stride);
+    }
+
+    // Main game loop
+    while (window.isOpen()) {
+        // Calculate delta time
+        auto current_time = Clock::now();
+        float delta_time = std::chrono::duration<float>(current_time - last_time).count();
+        last_time = current_time;
+
+        // Handle events with version-specific API
+#if SFML_VERSION_MAJOR >= 3
+        // SFML 3.x event handling
+        while (auto event = window.pollEvent()) {
+            if (event->is<sf::Event::Closed>()) {
+                std::cout << "Window closed by user\n";
+                window.close();
+            }
+
+            if (event->is<sf::Event::KeyPressed>()) {
+                auto key_event = event->getIf<sf::Event::KeyPressed>();
+                if (key_event->code == sf::Keyboard::Key::Escape) {
+                    std::cout << "Escape pressed - exiting\n";
+                    window.close();
+                } else if (key_event->code == sf::Keyboard::Key::Space) {
+                    if (pipelined) {
+                        reset_requested = true;
+                    } else {
+                        simulation.resetParticles();
+                    }
+                    std::cout << "Simulation reset\n";
+                }
+            }
+        }
+#else
+        // SFML 2.x event handling
+        sf::Event event;
+        while (window.pollEvent(event)) {
+            if (event.type == sf::Event::Closed) {
+                std::cout << "Window closed by user\n";
+                window.close();
+            }
+
+            if (event.type == sf::Event::KeyPressed) {
+                if (event.key.code == sf::Keyboard::Escape) {
+                    std::cout << "Escape pressed - exiting\n";
+                    window.close();
+                } else if (event.key.code == sf::Keyboard::Space) {
+                    if (pipelined) {
+                        reset_requested = true;
+                    } else {
+                        simulation.resetParticles();
+                    }
+                    std::cout << "Simulation reset\n";
+                }
+            }
+        }
+#endif
+
+        // Step the simulation, or pick up the newest frame the simulation thread made
+        const RenderSnapshot* snapshot = &serial_snapshot;
+        bool new_frame = true;
+        float alpha = 1.0f;
+        if (pipelined) {
+            new_frame = snapshots.acquire();
+            snapshot = &snapshots.getReadBuffer();
+            // Each snapshot is one step ahead of the one before it, so time
+            // since its capture says how far to move toward it
+            const auto since_capture =
+                std::chrono::duration<float>(std::chrono::steady_clock::now() - snapshot->captured_at).count();
+            alpha = since_capture / options.timestep;
+        } else {
+            new_frame = runSteps(serial_timestep, delta_time, serial_snapshot) > 0;
+            alpha = serial_timestep.getAlpha();
+        }
+        if (!options.interpolate) {
+            alpha = 1.0f;
+        }
+        fps_counter.update();
+        if (new_frame && snapshot->has_counters) {
+            fps_counter.addPhaseCounters(simulation.getPerfCounters(), snapshot->counters);
+        }
+
+        const float rate_seconds = std::chrono::duration<float>(current_time - rate_time).count();
+        if (rate_seconds >= 1.0f) {
+            fps_counter.setSimulationRate((snapshot->frame_index - rate_frame_index) / rate_seconds);
+            rate_frame_index = snapshot->frame_index;
+            rate_time = current_time;
+        }
+
+        // Render everything
+        window.clear(sf::Color::White);
+
+        renderer.render(window, *snapshot, alpha, lod);
+        fps_counter.render(window);
+
+        {
+            PROFILE_ZONE("RenderWindow::display");
+            window.display();
+        }
+    }
+
+    if (simulation_thread.joinable()) {
+        simulating = false;
+        simulation_thread.join();
+    }
+
+    std::cout << "Simulation ended\n";
+    return 0;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include "fixed_timestep.h"
+#include "render_snapshot.h"
+
+class BrownianSimulation;
+class ThreadPool;
+
+struct ViewerOptions {
+    static constexpr std::size_t DEFAULT_RENDER_BUDGET = 250000;
+
+    bool pipelined = true;                           // update() on its own thread
+    float timestep = FixedTimestep::DEFAULT_STEP;    // Simulation dt, independent of the frame rate
+    int max_substeps = FixedTimestep::DEFAULT_MAX_STEPS;
+    bool interpolate = true;                         // Draw between the last two steps
+    RenderLod lod = RenderLod::Decimate;             // Used above render_budget particles
+    std::size_t render_budget = DEFAULT_RENDER_BUDGET;
+};
+
+// Interactive SFML front end: one window sized to the simulation, the FPS
+// overlay, ESC to exit and SPACE to reset. Only the viewer target links SFML;
+// the simulation core and brownian_headless never see it.
+//
+// The simulation advances in fixed steps of options.timestep: wall time
+// accumulates and each drawn frame runs however many steps it covers (at most
+// max_substeps), then draws the particles interpolated between the last two
+// steps. A slow frame therefore means more steps, never a bigger dt.
+//
+// By default the steps run on a simulation thread that publishes a
+// RenderSnapshot through a TripleBuffer, while this thread draws the newest
+// snapshot, so the frame rate is set by the slower of the two stages instead
+// of their sum. Serial mode keeps both on one thread.
+class Viewer {
+public:
+    // Runs the window loop on a configured simulation; returns the exit code
+    static int run(BrownianSimulation& simulation, ThreadPool& thread_pool,
+                   const ViewerOptions& options = ViewerOptions());
+
+private:
+    static constexpr unsigned FRAME_RATE_LIMIT = 120;
+};
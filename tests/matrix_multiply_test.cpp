@@ -0,0 +1,131 @@
+// Checks the build's matrix multiply (USE_SLOW_MATRIX, USE_FAST_MATRIX,
+// USE_ULTRA_FAST_MATRIX or USE_GEMM_MATRIX) against a double-precision
+// reference on shapes that reach the edge cases: single rows and columns,
+// sizes that are not multiples of the SIMD width or the GEMM micro-tile,
+// depths past one KC slice, row counts past one MC block, widths past NC,
+// strided sub-block views, and the tiled path on a thread pool.
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "gemm.h"
+#include "matrix_operations.h"
+#include "thread_pool.h"
+
+namespace {
+
+struct Shape {
+    int m;
+    int k;
+    int n;
+};
+
+constexpr Shape SHAPES[] = {
+    {1, 1, 1},
+    {7, 13, 5},
+    {9, 17, 11},
+    {1, 600, 1},
+    {600, 1, 600},
+    {Gemm::MR - 1, Gemm::KC + 1, Gemm::NR + 1},
+    {Gemm::MC + 3, Gemm::KC + 45, 67},
+    {3, 5, Gemm::NC + 5},
+    {281, 281, 281},
+    {500, 97, 513},
+};
+
+constexpr int POOL_THREADS = 4;
+
+int failures = 0;
+
+// C = A * B in double, with the bound on float rounding error for each entry
+void referenceProduct(ConstMatrixView a, ConstMatrixView b, std::vector<double>& product,
+                      std::vector<double>& bound) {
+    product.assign(static_cast<std::size_t>(a.rows) * b.cols, 0.0);
+    bound.assign(product.size(), 0.0);
+    for (int i = 0; i < a.rows; ++i) {
+        for (int p = 0; p < a.cols; ++p) {
+            const double a_value = a(i, p);
+            for (int j = 0; j < b.cols; ++j) {
+                product[static_cast<std::size_t>(i) * b.cols + j] += a_value * b(p, j);
+                bound[static_cast<std::size_t>(i) * b.cols + j] += std::fabs(a_value * b(p, j));
+            }
+        }
+    }
+}
+
+void expectClose(const char* what, const Shape& shape, ConstMatrixView result, const std::vector<double>& product,
+                 const std::vector<double>& bound) {
+    // Any summation order stays within k * eps of the absolute sum
+    const double tolerance = 2.0 * shape.k * 1.1920929e-7;
+    for (int i = 0; i < result.rows; ++i) {
+        for (int j = 0; j < result.cols; ++j) {
+            const std::size_t index = static_cast<std::size_t>(i) * result.cols + j;
+            const double error = std::fabs(result(i, j) - product[index]);
+            if (error > tolerance * bound[index] + 1e-30) {
+                std::printf("FAIL %s %dx%dx%d: C(%d, %d) = %.9g, expected %.9g\n", what, shape.m, shape.k,
+                            shape.n, i, j, result(i, j), product[index]);
+                ++failures;
+                return;
+            }
+        }
+    }
+}
+
+void expectEqual(const char* what, const Shape& shape, const Matrix& result, const Matrix& expected) {
+    for (int i = 0; i < result.getRows(); ++i) {
+        for (int j = 0; j < result.getCols(); ++j) {
+            if (result(i, j) != expected(i, j)) {
+                std::printf("FAIL %s %dx%dx%d: C(%d, %d) = %.9g, single-threaded %.9g\n", what, shape.m, shape.k,
+                            shape.n, i, j, result(i, j), expected(i, j));
+                ++failures;
+                return;
+            }
+        }
+    }
+}
+
+} // namespace
+
+int main() {
+    std::mt19937 rng(42);
+    ThreadPool pool(POOL_THREADS);
+    std::vector<double> product;
+    std::vector<double> bound;
+
+    for (const Shape& shape : SHAPES) {
+        Matrix a;
+        Matrix b;
+        MatrixOperations::createRandomMatrix(a, shape.m, shape.k, rng);
+        MatrixOperations::createRandomMatrix(b, shape.k, shape.n, rng);
+        referenceProduct(static_cast<const Matrix&>(a).view(), static_cast<const Matrix&>(b).view(), product, bound);
+
+        Matrix single(shape.m, shape.n);
+        MatrixOperations::multiplyMatrices(a, b, single);
+        expectClose("single-threaded", shape, static_cast<const Matrix&>(single).view(), product, bound);
+
+        // The tiled path has to give the single-threaded result exactly
+        Matrix pooled(shape.m, shape.n);
+        MatrixOperations::multiplyMatrices(a, b, pooled, &pool);
+        expectEqual("pool", shape, pooled, single);
+
+        // Operands and result as views one row and column into larger
+        // matrices: unaligned starts and strides that are not the row length
+        Matrix a_outer;
+        Matrix b_outer;
+        Matrix c_outer(shape.m + 2, shape.n + 2);
+        MatrixOperations::createRandomMatrix(a_outer, shape.m + 2, shape.k + 2, rng);
+        MatrixOperations::createRandomMatrix(b_outer, shape.k + 2, shape.n + 2, rng);
+        const ConstMatrixView a_block = static_cast<const Matrix&>(a_outer).view().block(1, 1, shape.m, shape.k);
+        const ConstMatrixView b_block = static_cast<const Matrix&>(b_outer).view().block(1, 1, shape.k, shape.n);
+        const MatrixView c_block = c_outer.view().block(1, 1, shape.m, shape.n);
+        referenceProduct(a_block, b_block, product, bound);
+        MatrixOperations::multiplyMatrices(a_block, b_block, c_block);
+        expectClose("view", shape, c_block, product, bound);
+        MatrixOperations::multiplyMatrices(a_block, b_block, c_block, &pool);
+        expectClose("pool view", shape, c_block, product, bound);
+    }
+
+    std::printf("%s: %zu shapes, %d failures\n", MatrixOperations::getImplementationName(),
+                sizeof(SHAPES) / sizeof(SHAPES[0]), failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,91 @@
+# Checks that runs which must end in the same state do: the state_hash of a
+# --frames report is compared between two ways of getting there.
+#
+#   cmake -DHEADLESS=<brownian_headless> -DWORK_DIR=<dir> -DCHECK=threads|resume -P determinism_check.cmake
+#
+# threads: one worker against several, with and without interactions and
+#          Morton reordering
+# resume:  25 frames, a checkpoint and 35 resumed frames against 60 in a row;
+#          the final checkpoints are compared byte for byte as well
+# ensemble: four members run side by side against the same seeds run alone
+#          (with -DBROWNIAN_SANITIZE=thread this also looks for races)
+
+if(NOT HEADLESS OR NOT WORK_DIR OR NOT CHECK)
+    message(FATAL_ERROR "HEADLESS, WORK_DIR and CHECK must be set")
+endif()
+file(MAKE_DIRECTORY "${WORK_DIR}")
+
+set(BASE_OPTIONS --seed 7 --particles 3000 --obstacles 20 --matrix-size 16)
+
+# Run brownian_headless with the given options and store the report's state_hash
+function(run_hash result)
+    execute_process(COMMAND "${HEADLESS}" ${ARGN}
+                    OUTPUT_VARIABLE output ERROR_VARIABLE errors RESULT_VARIABLE status)
+    if(NOT status EQUAL 0)
+        message(FATAL_ERROR "brownian_headless ${ARGN} failed (${status}):\n${output}${errors}")
+    endif()
+    string(REGEX MATCH "\"state_hash\": \"([0-9a-f]+)\"" match "${output}")
+    if(NOT match)
+        message(FATAL_ERROR "no state_hash in the report of brownian_headless ${ARGN}:\n${output}")
+    endif()
+    set(${result} "${CMAKE_MATCH_1}" PARENT_SCOPE)
+endfunction()
+
+function(expect_same what options expected actual)
+    string(REPLACE ";" " " options "${options}")
+    if(options)
+        set(what "${what}, ${options}")
+    endif()
+    if(NOT expected STREQUAL actual)
+        message(FATAL_ERROR "${what}: state_hash ${actual}, expected ${expected}")
+    endif()
+    message(STATUS "${what}: ${actual}")
+endfunction()
+
+if(CHECK STREQUAL "threads")
+    foreach(extra "" "--interactions;--sort-every;5")
+        run_hash(serial ${BASE_OPTIONS} ${extra} --frames 60 --threads 1)
+        run_hash(parallel ${BASE_OPTIONS} ${extra} --frames 60 --threads 4)
+        expect_same("4 threads vs 1" "${extra}" "${serial}" "${parallel}")
+    endforeach()
+elseif(CHECK STREQUAL "resume")
+    # state_hash covers positions and velocities; the final checkpoints must
+    # match byte for byte too (colors, obstacles, RNG state, matrices)
+    set(checkpoint "${WORK_DIR}/determinism_resume.ckpt")
+    set(straight_final "${WORK_DIR}/determinism_straight_final.ckpt")
+    set(resumed_final "${WORK_DIR}/determinism_resumed_final.ckpt")
+    foreach(extra "" "--sort-every;10" "--interactions;--noise;gaussian;--boundary;periodic;--lazy-matrix")
+        file(REMOVE "${checkpoint}" "${straight_final}" "${resumed_final}")
+        run_hash(straight ${BASE_OPTIONS} ${extra} --frames 60 --checkpoint "${straight_final}")
+        run_hash(first_part ${BASE_OPTIONS} ${extra} --frames 25 --checkpoint "${checkpoint}")
+        run_hash(resumed --resume "${checkpoint}" --frames 35 --checkpoint "${resumed_final}")
+        expect_same("25 + 35 resumed frames vs 60" "${extra}" "${straight}" "${resumed}")
+        execute_process(COMMAND "${CMAKE_COMMAND}" -E compare_files "${straight_final}" "${resumed_final}"
+                        RESULT_VARIABLE differ)
+        if(NOT differ EQUAL 0)
+            string(REPLACE ";" " " options "${extra}")
+            message(FATAL_ERROR "25 + 35 resumed frames vs 60 (${options}): final checkpoints differ")
+        endif()
+    endforeach()
+elseif(CHECK STREQUAL "ensemble")
+    execute_process(COMMAND "${HEADLESS}" ${BASE_OPTIONS} --frames 60 --threads 4 --ensemble 4
+                    OUTPUT_VARIABLE output ERROR_VARIABLE errors RESULT_VARIABLE status)
+    if(NOT status EQUAL 0)
+        message(FATAL_ERROR "brownian_headless --ensemble 4 failed (${status}):\n${output}${errors}")
+    endif()
+    string(REGEX MATCHALL "\"state_hash\": \"[0-9a-f]+\"" members "${output}")
+    list(LENGTH members member_count)
+    if(NOT member_count EQUAL 4)
+        message(FATAL_ERROR "expected 4 ensemble results, got ${member_count}:\n${output}")
+    endif()
+    set(member 0)
+    foreach(line ${members})
+        string(REGEX REPLACE ".*\"([0-9a-f]+)\"$" "\\1" member_hash "${line}")
+        math(EXPR member_seed "7 + ${member}")
+        run_hash(alone --seed ${member_seed} --particles 3000 --obstacles 20 --matrix-size 16 --frames 60)
+        expect_same("ensemble member ${member} vs seed ${member_seed} alone" "" "${alone}" "${member_hash}")
+        math(EXPR member "${member} + 1")
+    endforeach()
+else()
+    message(FATAL_ERROR "unknown CHECK '${CHECK}' (threads, resume or ensemble)")
+endif()
@@ -0,0 +1,58 @@
+// Prints a summary of a trajectory file written with --trajectory, and
+// optionally the positions of one frame. Seeking to the frame goes through
+// the index footer, so it costs the same for the first and the last frame.
+#include "trajectory_reader.h"
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+int main(int argc, char* argv[]) {
+    if (argc < 2 || argc > 4) {
+        std::cerr << "Usage: " << argv[0] << " FILE [FRAME [COUNT]]\n"
+                  << "  FRAME  Record to print (0-based, negative counts from the end)\n"
+                  << "  COUNT  Particles to print from that record (default all)\n";
+        return 1;
+    }
+
+    TrajectoryReader reader;
+    if (!reader.open(argv[1])) {
+        std::cerr << "Error: " << reader.getError() << std::endl;
+        return 1;
+    }
+
+    std::cout << "Particles: " << reader.getParticleCount() << "\n"
+              << "Frames: " << reader.getFrameCount() << "\n"
+              << "Chunks: " << reader.getChunkCount() << (reader.hasIndex() ? "" : " (no index footer, scanned)") << "\n"
+              << "Quantization step: " << reader.getQuantizationStepX() << " x " << reader.getQuantizationStepY() << " px\n";
+    if (reader.getFrameCount() > 0) {
+        std::cout << "Simulation frames: " << reader.getFrameIndex(0) << " .. "
+                  << reader.getFrameIndex(reader.getFrameCount() - 1) << "\n";
+    }
+    if (argc < 3) {
+        return 0;
+    }
+
+    long long record = std::atoll(argv[2]);
+    if (record < 0) {
+        record += static_cast<long long>(reader.getFrameCount());
+    }
+    const uint32_t particles = reader.getParticleCount();
+    std::vector<float> x(particles);
+    std::vector<float> y(particles);
+    if (record < 0 || !reader.readFrame(static_cast<uint64_t>(record), x.data(), y.data())) {
+        std::cerr << "Error: frame " << argv[2] << " is out of range" << std::endl;
+        return 1;
+    }
+
+    uint32_t count = particles;
+    if (argc > 3) {
+        count = static_cast<uint32_t>(std::min<unsigned long long>(std::strtoull(argv[3], nullptr, 10), particles));
+    }
+    std::cout << "Record " << record << " (simulation frame " << reader.getFrameIndex(record) << ")\n"
+              << std::fixed << std::setprecision(2);
+    for (uint32_t i = 0; i < count; ++i) {
+        std::cout << i << " " << x[i] << " " << y[i] << "\n";
+    }
+    return 0;
+}